@@ -0,0 +1,368 @@
+﻿// BackupBench.cpp: 进程内备份引擎 (BackupTask 的核心) 的吞吐
+// 不依赖 MFC；需要链接 scheduler_core (见 CMakeLists.txt)
+//
+//   BM_Crc32            CRC32 (slicing-by-8) 的吞吐
+//   BM_Deflate/text:N   单块压缩吞吐，N = 1 类文本数据 / 0 随机数据 (走存储块)
+//   BM_Backup/workers:N 对临时目录中生成的文件树做完整备份 (遍历 + 读取 + 压缩 + 写 zip)
+//                       最后一次备份的归档会重新打开逐条解压，CRC32 与源文件核对不上时报错
+// 生成的文件树和归档都在系统临时目录下，结束时删除。
+
+#include "BenchHarness.h"
+#include "BackupEngine.h"
+#include "TaskScheduler.h"
+#include "Utf8Path.h"
+#include "ZipWriter.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// 类似源代码/日志的文本：从小词表中随机取词，有大量重复
+std::vector<uint8_t> MakeText(size_t n, uint64_t seed) {
+    static const char* words[] = { "task", "scheduler", "worker", "queue", "const", "return", "std::vector",
+        "if (", ") {", "}\n", "    ", "//", "lock", "priority", "deadline", "= 0;", "nullptr", "->", "\n" };
+    std::mt19937_64 rng(seed);
+    std::vector<uint8_t> out;
+    out.reserve(n);
+    while (out.size() < n) {
+        const char* w = words[rng() % (sizeof(words) / sizeof(words[0]))];
+        while (*w && out.size() < n) out.push_back(static_cast<uint8_t>(*w++));
+        if (out.size() < n) out.push_back(' ');
+    }
+    return out;
+}
+
+std::vector<uint8_t> MakeRandom(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<uint8_t> out(n);
+    for (auto& b : out) b = static_cast<uint8_t>(rng());
+    return out;
+}
+
+// 3 层目录、约 48 MB：大部分为文本，另有少量不可压缩的大文件
+class SampleTree {
+public:
+    fs::path root;
+    uint64_t bytes = 0;
+
+    SampleTree() {
+        root = fs::temp_directory_path() / "scheduler_backup_bench";
+        fs::remove_all(root);
+        std::mt19937_64 rng(1);
+        for (int d = 0; d < 8; ++d) {
+            for (int s = 0; s < 4; ++s) {
+                fs::path dir = root / ("dir" + std::to_string(d)) / ("sub" + std::to_string(s));
+                fs::create_directories(dir);
+                for (int f = 0; f < 12; ++f) {
+                    size_t size = static_cast<size_t>(1024 + rng() % (128 * 1024));
+                    if (f == 0) size = static_cast<size_t>(512 * 1024 + rng() % (1024 * 1024));
+                    Write(dir / ("file" + std::to_string(f) + ".txt"), MakeText(size, rng()));
+                }
+            }
+            Write(root / ("dir" + std::to_string(d)) / "blob.bin", MakeRandom(2 * 1024 * 1024, rng()));
+        }
+        Write(root / "empty.txt", {});
+    }
+    ~SampleTree() {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+
+private:
+    void Write(const fs::path& path, const std::vector<uint8_t>& data) {
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size()));
+        bytes += data.size();
+    }
+};
+
+// ------------------------------------------
+// 往返校验：最小的 inflate (存储 / 固定 / 动态 Huffman 块，RFC 1951) 与 zip 中央目录解析
+// ------------------------------------------
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    uint32_t Bits(int count) {
+        while (available < count) {
+            if (pos >= size) throw std::runtime_error("deflate stream truncated");
+            buffer |= static_cast<uint32_t>(data[pos++]) << available;
+            available += 8;
+        }
+        uint32_t value = buffer & ((1u << count) - 1);
+        buffer >>= count;
+        available -= count;
+        return value;
+    }
+
+    // 存储块：丢弃当前字节剩余的位 (按需取字节，剩余位数总是少于 8)
+    void AlignToByte() {
+        buffer = 0;
+        available = 0;
+    }
+
+    const uint8_t* Take(size_t n) {
+        if (size - pos < n) throw std::runtime_error("stored block truncated");
+        const uint8_t* p = data + pos;
+        pos += n;
+        return p;
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    uint32_t buffer = 0;
+    int available = 0;
+};
+
+// 规范 Huffman 码表：各码长的码字数 + 按码字顺序排列的符号
+struct Huffman {
+    uint16_t count[16] = {};
+    std::vector<uint16_t> symbol;
+
+    explicit Huffman(const std::vector<uint8_t>& lengths) : symbol(lengths.size()) {
+        for (uint8_t len : lengths) ++count[len];
+        count[0] = 0;
+        uint16_t offset[16] = {};
+        for (int len = 1; len < 15; ++len) offset[len + 1] = static_cast<uint16_t>(offset[len] + count[len]);
+        for (size_t s = 0; s < lengths.size(); ++s) {
+            if (lengths[s] != 0) symbol[offset[lengths[s]]++] = static_cast<uint16_t>(s);
+        }
+    }
+
+    int Decode(BitReader& in) const {
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= static_cast<int>(in.Bits(1));
+            int n = count[len];
+            if (code - n < first) return symbol[static_cast<size_t>(index + code - first)];
+            index += n;
+            first = (first + n) << 1;
+            code <<= 1;
+        }
+        throw std::runtime_error("invalid Huffman code");
+    }
+};
+
+void InflateCodes(BitReader& in, const Huffman& lit, const Huffman& dist, std::vector<uint8_t>& out) {
+    static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+        67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+        5, 5, 5, 5, 0 };
+    static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+        769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+        11, 11, 12, 12, 13, 13 };
+    while (true) {
+        int symbol = lit.Decode(in);
+        if (symbol < 256) {
+            out.push_back(static_cast<uint8_t>(symbol));
+            continue;
+        }
+        if (symbol == 256) return;
+        symbol -= 257;
+        if (symbol >= 29) throw std::runtime_error("invalid length symbol");
+        size_t length = lengthBase[symbol] + in.Bits(lengthExtra[symbol]);
+        int d = dist.Decode(in);
+        if (d >= 30) throw std::runtime_error("invalid distance symbol");
+        size_t distance = distBase[d] + in.Bits(distExtra[d]);
+        if (distance > out.size()) throw std::runtime_error("distance too far back");
+        for (size_t i = 0; i < length; ++i) out.push_back(out[out.size() - distance]); // 可能与自身重叠，逐字节复制
+    }
+}
+
+std::vector<uint8_t> Inflate(const uint8_t* data, size_t size) {
+    std::vector<uint8_t> out;
+    BitReader in(data, size);
+    bool last = false;
+    while (!last) {
+        last = in.Bits(1) != 0;
+        uint32_t type = in.Bits(2);
+        if (type == 0) {
+            in.AlignToByte();
+            const uint8_t* header = in.Take(4);
+            size_t length = header[0] | (header[1] << 8);
+            if ((length ^ (header[2] | (header[3] << 8))) != 0xFFFF) throw std::runtime_error("bad stored length");
+            const uint8_t* bytes = in.Take(length);
+            out.insert(out.end(), bytes, bytes + length);
+        }
+        else if (type == 1) {
+            static const Huffman fixedLit = [] {
+                std::vector<uint8_t> lengths(288, 8);
+                std::fill(lengths.begin() + 144, lengths.begin() + 256, uint8_t(9));
+                std::fill(lengths.begin() + 256, lengths.begin() + 280, uint8_t(7));
+                return Huffman(lengths);
+            }();
+            static const Huffman fixedDist(std::vector<uint8_t>(30, 5));
+            InflateCodes(in, fixedLit, fixedDist, out);
+        }
+        else if (type == 2) {
+            static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+            size_t nlen = in.Bits(5) + 257;
+            size_t ndist = in.Bits(5) + 1;
+            size_t ncode = in.Bits(4) + 4;
+            std::vector<uint8_t> codeLengths(19, 0);
+            for (size_t i = 0; i < ncode; ++i) codeLengths[order[i]] = static_cast<uint8_t>(in.Bits(3));
+            Huffman codeTable(codeLengths);
+
+            std::vector<uint8_t> lengths;
+            while (lengths.size() < nlen + ndist) {
+                int symbol = codeTable.Decode(in);
+                if (symbol < 16) {
+                    lengths.push_back(static_cast<uint8_t>(symbol));
+                    continue;
+                }
+                uint8_t value = 0;
+                size_t repeat;
+                if (symbol == 16) {
+                    if (lengths.empty()) throw std::runtime_error("repeat without previous length");
+                    value = lengths.back();
+                    repeat = 3 + in.Bits(2);
+                }
+                else if (symbol == 17) {
+                    repeat = 3 + in.Bits(3);
+                }
+                else {
+                    repeat = 11 + in.Bits(7);
+                }
+                lengths.insert(lengths.end(), repeat, value);
+            }
+            if (lengths.size() != nlen + ndist) throw std::runtime_error("code lengths overrun");
+            Huffman lit(std::vector<uint8_t>(lengths.begin(), lengths.begin() + static_cast<std::ptrdiff_t>(nlen)));
+            Huffman dist(std::vector<uint8_t>(lengths.begin() + static_cast<std::ptrdiff_t>(nlen), lengths.end()));
+            InflateCodes(in, lit, dist, out);
+        }
+        else {
+            throw std::runtime_error("invalid block type");
+        }
+    }
+    return out;
+}
+
+uint32_t Get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+uint32_t Get32(const uint8_t* p) { return Get16(p) | (Get16(p + 2) << 16); }
+
+std::vector<uint8_t> ReadAll(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// 重新打开归档：按中央目录逐条解压，核对大小、CRC32 与源文件；返回核对过的条目数
+size_t VerifyArchive(const std::string& archive, const fs::path& sourceRoot) {
+    std::vector<uint8_t> zip = ReadAll(PathFromUtf8(archive));
+    if (zip.size() < 22) throw std::runtime_error("archive too small");
+    size_t eocd = zip.size() - 22;
+    while (Get32(&zip[eocd]) != 0x06054b50) {
+        if (eocd == 0) throw std::runtime_error("end of central directory not found");
+        --eocd;
+    }
+    size_t entries = Get16(&zip[eocd + 10]);
+    size_t pos = Get32(&zip[eocd + 16]);
+
+    for (size_t i = 0; i < entries; ++i) {
+        if (pos + 46 > zip.size() || Get32(&zip[pos]) != 0x02014b50) throw std::runtime_error("bad central header");
+        const uint8_t* h = &zip[pos];
+        uint32_t crc = Get32(h + 16);
+        size_t compressed = Get32(h + 20);
+        size_t size = Get32(h + 24);
+        size_t nameLength = Get16(h + 28);
+        size_t local = Get32(h + 42);
+        std::string name(reinterpret_cast<const char*>(h + 46), nameLength);
+        pos += 46 + nameLength + Get16(h + 30) + Get16(h + 32);
+
+        if (Get16(h + 10) != 8) throw std::runtime_error(name + ": not deflated");
+        if (local + 30 > zip.size() || Get32(&zip[local]) != 0x04034b50) throw std::runtime_error(name + ": bad local header");
+        size_t dataStart = local + 30 + Get16(&zip[local + 26]) + Get16(&zip[local + 28]);
+        if (dataStart + compressed > zip.size()) throw std::runtime_error(name + ": data out of range");
+
+        std::vector<uint8_t> data = Inflate(&zip[dataStart], compressed);
+        std::vector<uint8_t> original = ReadAll(sourceRoot / PathFromUtf8(name));
+        if (data.size() != size || data != original) throw std::runtime_error(name + ": content mismatch");
+        if (Crc32Update(0, data.data(), data.size()) != crc) throw std::runtime_error(name + ": CRC32 mismatch");
+    }
+    return entries;
+}
+
+void BM_Crc32(bench::State& state) {
+    std::vector<uint8_t> data = MakeRandom(1 << 20, 5);
+    uint32_t crc = 0;
+    for (auto _ : state) {
+        crc = Crc32Update(crc, data.data(), data.size());
+    }
+    state.counters["sink"] = crc != 0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size())); // 字节
+}
+
+void BM_Deflate(bench::State& state) {
+    std::vector<uint8_t> data = state.range(0) ? MakeText(1 << 20, 9) : MakeRandom(1 << 20, 9);
+    std::vector<uint8_t> out;
+    for (auto _ : state) {
+        out.clear();
+        DeflateBlock(data.data(), data.size(), out);
+    }
+    state.counters["ratio"] = static_cast<double>(out.size()) / data.size();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size())); // 字节
+}
+
+void BM_Backup(bench::State& state) {
+    static SampleTree tree;
+    size_t workers = static_cast<size_t>(state.range(0));
+    TaskScheduler* scheduler = TaskScheduler::GetInstance();
+    scheduler->SetWorkerCount(workers);
+    scheduler->Start();
+
+    BackupOptions options;
+    options.source = PathToUtf8(tree.root);
+    options.archive = PathToUtf8(fs::temp_directory_path() / "scheduler_backup_bench.zip");
+    BackupResult result;
+    for (auto _ : state) {
+        result = RunBackup(options, *scheduler);
+        if (!result.ok) break;
+    }
+    scheduler->Stop();
+
+    size_t verified = 0;
+    std::string verifyError;
+    if (result.ok) {
+        try {
+            verified = VerifyArchive(options.archive, tree.root);
+        }
+        catch (const std::exception& e) {
+            verifyError = std::string("round-trip check failed: ") + e.what();
+        }
+    }
+    std::error_code ec;
+    fs::remove(options.archive, ec);
+
+    if (!result.ok) {
+        state.SkipWithError(result.error.c_str());
+        return;
+    }
+    if (!verifyError.empty()) {
+        state.SkipWithError(verifyError.c_str());
+        return;
+    }
+    state.counters["verified"] = static_cast<double>(verified);
+    state.counters["MBps"] = result.ThroughputMBps();
+    state.counters["ratio"] = result.Ratio();
+    state.counters["files"] = static_cast<double>(result.files);
+    state.counters["walk_ms"] = result.walkSeconds * 1e3;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(result.bytesIn)); // 字节
+}
+
+} // namespace
+
+BENCHMARK(BM_Crc32);
+BENCHMARK(BM_Deflate)->Args({ 1 })->Args({ 0 })->ArgNames({ "text" });
+BENCHMARK(BM_Backup)->Args({ 1 })->Args({ 2 })->Args({ 4 })->ArgNames({ "workers" })->Iterations(3);
+
+int main(int argc, char** argv) {
+    return bench::RunAll(argc, argv);
+}
@@ -0,0 +1,246 @@
+﻿#pragma once
+// BenchHarness.h: 极简的 Google Benchmark 风格基准框架 (仅头文件，无第三方依赖)
+//
+//   static void BM_Foo(bench::State& state) {
+//       for (auto _ : state) { ... }
+//       state.SetItemsProcessed(state.iterations());
+//   }
+//   BENCHMARK(BM_Foo)->Args({1, 1000})->Args({4, 1000})->ArgNames({"workers", "depth"});
+//   int main(int argc, char** argv) { return bench::RunAll(argc, argv); }
+//
+// 命令行：--filter=<子串>  --format=console|json  --min_time=<秒>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+class State {
+private:
+    int64_t maxIterations;
+    std::vector<int64_t> args;
+    Clock::time_point started;
+    double elapsed;        // 计时区间累计 (秒)
+    double manualElapsed;  // UseManualTime 时由基准自己报告
+    bool running;
+    int64_t itemsProcessed;
+    std::string error;
+
+public:
+    std::map<std::string, double> counters; // 额外输出的列，如 p50_us、jitter_us
+
+    State(int64_t iterations, std::vector<int64_t> arguments)
+        : maxIterations(iterations), args(std::move(arguments)), elapsed(0.0), manualElapsed(0.0), running(false),
+          itemsProcessed(0) {
+    }
+
+    int64_t range(size_t index) const { return index < args.size() ? args[index] : 0; }
+    int64_t iterations() const { return maxIterations; }
+
+    void ResumeTiming() {
+        if (!running) {
+            started = Clock::now();
+            running = true;
+        }
+    }
+
+    void PauseTiming() {
+        if (running) {
+            elapsed += std::chrono::duration<double>(Clock::now() - started).count();
+            running = false;
+        }
+    }
+
+    // 每次迭代单独测量的基准 (例如需要等待后台线程完成) 用它报告耗时
+    void SetIterationTime(double seconds) { manualElapsed += seconds; }
+
+    void SetItemsProcessed(int64_t items) { itemsProcessed = items; }
+
+    // 当前环境无法运行 (例如 CPU 不支持所需指令集)：跳过计时循环，结果只输出原因
+    void SkipWithError(const char* message) { error = message; }
+
+    double ElapsedSeconds(bool manual) const { return manual ? manualElapsed : elapsed; }
+    int64_t ItemsProcessed() const { return itemsProcessed; }
+    const std::string& Error() const { return error; }
+
+    // 支持 for (auto _ : state)：进入循环开始计时，循环结束停止计时
+    struct Iterator {
+        State* state;
+        int64_t remaining;
+        bool operator!=(const Iterator&) const {
+            if (remaining > 0) return true;
+            state->PauseTiming();
+            return false;
+        }
+        void operator++() { --remaining; }
+        struct Value {
+            ~Value() {} // 非平凡析构，避免 for (auto _ : state) 触发未使用变量警告
+        };
+        Value operator*() const { return Value(); }
+    };
+    Iterator begin() {
+        if (!error.empty()) return Iterator{ this, 0 };
+        ResumeTiming();
+        return Iterator{ this, maxIterations };
+    }
+    Iterator end() { return Iterator{ this, 0 }; }
+};
+
+class Benchmark {
+public:
+    std::string name;
+    std::function<void(State&)> fn;
+    std::vector<std::vector<int64_t>> argSets;
+    std::vector<std::string> argNames;
+    int64_t fixedIterations;
+    bool manualTime;
+
+    Benchmark(std::string n, std::function<void(State&)> f)
+        : name(std::move(n)), fn(std::move(f)), fixedIterations(0), manualTime(false) {
+    }
+
+    Benchmark* Args(std::vector<int64_t> values) {
+        argSets.push_back(std::move(values));
+        return this;
+    }
+    Benchmark* ArgNames(std::vector<std::string> names) {
+        argNames = std::move(names);
+        return this;
+    }
+    // 固定迭代次数 (不自动扩增)，适合单次迭代本身就很重的基准
+    Benchmark* Iterations(int64_t n) {
+        fixedIterations = n;
+        return this;
+    }
+    Benchmark* UseManualTime() {
+        manualTime = true;
+        return this;
+    }
+
+    std::string DisplayName(const std::vector<int64_t>& values) const {
+        std::string out = name;
+        for (size_t i = 0; i < values.size(); ++i) {
+            out += "/";
+            if (i < argNames.size()) out += argNames[i] + ":";
+            out += std::to_string(values[i]);
+        }
+        return out;
+    }
+};
+
+inline std::vector<Benchmark*>& Registry() {
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark* Register(const char* name, void (*fn)(State&)) {
+    Registry().push_back(new Benchmark(name, fn));
+    return Registry().back();
+}
+
+struct Result {
+    std::string name;
+    int64_t iterations;
+    double nsPerIter;
+    double itemsPerSec;
+    std::map<std::string, double> counters;
+    std::string error;
+};
+
+// 运行一个参数组合：从 1 次迭代开始按 10 倍扩增，直到耗时超过 minTime
+inline Result RunOne(const Benchmark& b, const std::vector<int64_t>& values, double minTime) {
+    int64_t iterations = b.fixedIterations > 0 ? b.fixedIterations : 1;
+    while (true) {
+        State state(iterations, values);
+        b.fn(state);
+        double seconds = state.ElapsedSeconds(b.manualTime);
+        bool done = b.fixedIterations > 0 || seconds >= minTime || iterations >= (int64_t(1) << 30) ||
+            !state.Error().empty();
+        if (done) {
+            Result r;
+            r.name = b.DisplayName(values);
+            r.iterations = iterations;
+            r.nsPerIter = seconds * 1e9 / static_cast<double>(iterations);
+            r.itemsPerSec = seconds > 0.0 ? static_cast<double>(state.ItemsProcessed()) / seconds : 0.0;
+            r.counters = state.counters;
+            r.error = state.Error();
+            return r;
+        }
+        // 按已测得的速度估算下一轮的次数，最多扩大 10 倍
+        double scale = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+        iterations = static_cast<int64_t>(static_cast<double>(iterations) * (std::min)((std::max)(scale, 2.0), 10.0));
+    }
+}
+
+inline void PrintConsole(const Result& r) {
+    if (!r.error.empty()) {
+        std::printf("%-52s ERROR: %s\n", r.name.c_str(), r.error.c_str());
+        std::fflush(stdout);
+        return;
+    }
+    std::printf("%-52s %12.0f ns %10lld", r.name.c_str(), r.nsPerIter, static_cast<long long>(r.iterations));
+    if (r.itemsPerSec > 0.0) std::printf("  items/s=%.4g", r.itemsPerSec);
+    for (const auto& c : r.counters) std::printf("  %s=%.4g", c.first.c_str(), c.second);
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+inline void PrintJson(const std::vector<Result>& results) {
+    std::printf("{\n  \"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::printf("%s\n    {\"name\": \"%s\", \"iterations\": %lld, \"real_time_ns\": %.1f, \"items_per_second\": %.1f",
+            i ? "," : "", r.name.c_str(), static_cast<long long>(r.iterations), r.nsPerIter, r.itemsPerSec);
+        if (!r.error.empty()) std::printf(", \"error_message\": \"%s\"", r.error.c_str());
+        for (const auto& c : r.counters) std::printf(", \"%s\": %.3f", c.first.c_str(), c.second);
+        std::printf("}");
+    }
+    std::printf("\n  ]\n}\n");
+}
+
+inline int RunAll(int argc, char** argv) {
+    std::string filter;
+    bool json = false;
+    double minTime = 0.5;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) filter = argv[i] + 9;
+        else if (std::strcmp(argv[i], "--format=json") == 0) json = true;
+        else if (std::strncmp(argv[i], "--min_time=", 11) == 0) minTime = std::atof(argv[i] + 11);
+        else {
+            std::fprintf(stderr, "usage: %s [--filter=<substr>] [--format=console|json] [--min_time=<sec>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    if (!json) std::printf("%-52s %15s %10s\n", "Benchmark", "Time", "Iterations");
+    for (Benchmark* b : Registry()) {
+        std::vector<std::vector<int64_t>> sets = b->argSets;
+        if (sets.empty()) sets.push_back({});
+        for (const auto& values : sets) {
+            if (!filter.empty() && b->DisplayName(values).find(filter) == std::string::npos) continue;
+            Result r = RunOne(*b, values, minTime);
+            if (!json) PrintConsole(r);
+            results.push_back(r);
+        }
+    }
+    if (json) PrintJson(results);
+    return 0;
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_INNER(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_INNER(a, b)
+#define BENCHMARK(fn) static bench::Benchmark* BENCH_CONCAT(benchmark_, __LINE__) = bench::Register(#fn, fn)
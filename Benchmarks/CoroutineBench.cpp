@@ -0,0 +1,270 @@
+﻿// CoroutineBench.cpp: 协程任务 (CoTask) 挂起/恢复的开销，以及"大量等待型任务只需少数线程"的效果
+// 不依赖 MFC；需要链接 scheduler_core (见 CMakeLists.txt)
+//
+//   BM_CoSleepers/tasks:N      4 个工作线程上 N 个协程，各 5 次 co_await CoDelay(10 ms)
+//   BM_BlockingSleepers/tasks  对照组：同样的等待写成 Sleep，每个任务独占一个工作线程
+//   BM_CoAwaitChain/depth:D    逐层 co_await 的 D 层递归协程 (对称转移，不占栈)
+//   BM_CoMutex/coros:C         C 个协程各 1000 次 CoMutex 加锁/解锁，竞争时直接把锁交给等待者
+//   BM_CoSocket                两个协程经本机 TCP 连接 ping-pong，用 CoSocketReady 等待可读
+
+#include "SocketPoller.h" // 须在其他头文件之前，见该文件说明
+#include "BenchHarness.h"
+#include "CoTask.h"
+#include "TaskScheduler.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const size_t kWorkers = 4;
+
+TaskScheduler* StartScheduler() {
+    TaskScheduler* scheduler = TaskScheduler::GetInstance();
+    scheduler->SetWorkerCount(kWorkers);
+    scheduler->Start();
+    return scheduler;
+}
+
+CoTask<void> Sleeper(int rounds, milliseconds each) {
+    for (int i = 0; i < rounds; ++i) co_await CoDelay(each);
+}
+
+// CoSyncWait 需要一个协程：把 CoWhenAll 包一层
+CoTask<void> AwaitAll(std::vector<CoTask<void>> tasks) {
+    co_await CoWhenAll(std::move(tasks));
+}
+
+CoTask<int> Chain(int depth) {
+    if (depth == 0) co_return 0;
+    int below = co_await Chain(depth - 1);
+    co_return below + 1;
+}
+
+CoTask<void> Incrementer(CoMutex& mutex, int64_t& counter, int times) {
+    for (int i = 0; i < times; ++i) {
+        auto guard = co_await mutex.Lock();
+        ++counter;
+        if (i % 100 == 0) co_await CoYield(); // 持锁挂起，让其他协程排队
+    }
+}
+
+CoTask<void> Thrower() {
+    co_await CoYield();
+    throw std::runtime_error("expected");
+}
+
+// ------------------------------------------
+// 本机 TCP 连接对 (非阻塞)
+// ------------------------------------------
+bool OpenPair(Socket& a, Socket& b) {
+    a = b = kInvalidSocket;
+    Socket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == kInvalidSocket) return false;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bool ok = bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 && listen(listener, 1) == 0 &&
+        getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) == 0;
+    if (ok) {
+        a = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        ok = a != kInvalidSocket && connect(a, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+    if (ok) {
+        b = accept(listener, nullptr, nullptr);
+        ok = b != kInvalidSocket && SetNonBlocking(a) && SetNonBlocking(b);
+    }
+    CloseSocket(listener);
+    if (!ok) {
+        if (a != kInvalidSocket) CloseSocket(a);
+        if (b != kInvalidSocket) CloseSocket(b);
+    }
+    return ok;
+}
+
+// 读满 1 字节；超时或出错返回 false
+CoTask<bool> ReadByte(Socket s, char& c) {
+    for (;;) {
+        IoSize n = recv(s, &c, 1, 0);
+        if (n == 1) co_return true;
+        if (n == 0 || !WouldBlock(LastSocketError())) co_return false;
+        if (!co_await CoSocketReady(static_cast<intptr_t>(s), CoIoEvent::Readable, milliseconds(2000))) co_return false;
+    }
+}
+
+CoTask<void> PingPong(Socket s, int rounds, bool serve, std::atomic<int>& completed) {
+    char c = 'x';
+    for (int i = 0; i < rounds; ++i) {
+        if (!serve && send(s, &c, 1, kSendFlags) != 1) co_return;
+        if (!co_await ReadByte(s, c)) co_return;
+        if (serve && send(s, &c, 1, kSendFlags) != 1) co_return;
+    }
+    completed.fetch_add(1);
+}
+
+// 基本语义检查：返回值、异常传播、WhenAll、互斥、套接字超时
+bool Verify() {
+    StartScheduler();
+    bool ok = true;
+    auto check = [&](bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "verify failed: %s\n", what);
+            ok = false;
+        }
+    };
+
+    check(CoSyncWait(Chain(1000)) == 1000, "chain value");
+
+    bool caught = false;
+    try {
+        CoSyncWait(Thrower());
+    }
+    catch (const std::runtime_error&) {
+        caught = true;
+    }
+    check(caught, "exception propagates to CoSyncWait");
+
+    std::atomic<int> finished{ 0 };
+    CoSyncWait([](std::atomic<int>& done) -> CoTask<void> {
+        std::vector<CoTask<void>> children;
+        for (int i = 0; i < 16; ++i) {
+            children.push_back([](std::atomic<int>& d, int ms) -> CoTask<void> {
+                co_await CoDelay(milliseconds(ms));
+                d.fetch_add(1);
+            }(done, i));
+        }
+        co_await CoWhenAll(std::move(children));
+    }(finished));
+    check(finished.load() == 16, "CoWhenAll waits for every child");
+
+    CoMutex mutex;
+    int64_t counter = 0;
+    {
+        std::vector<CoTask<void>> children;
+        for (int i = 0; i < 8; ++i) children.push_back(Incrementer(mutex, counter, 500));
+        CoSyncWait(AwaitAll(std::move(children)));
+    }
+    check(counter == 8 * 500, "CoMutex mutual exclusion");
+
+    Socket a, b;
+    if (OpenPair(a, b)) {
+        bool ready = true;
+        auto start = std::chrono::steady_clock::now();
+        CoSyncWait([](Socket s, bool& r) -> CoTask<void> {
+            r = co_await CoSocketReady(static_cast<intptr_t>(s), CoIoEvent::Readable, milliseconds(50));
+        }(a, ready));
+        auto waited = std::chrono::steady_clock::now() - start;
+        check(!ready && waited >= milliseconds(50), "CoSocketReady timeout");
+        CloseSocket(a);
+        CloseSocket(b);
+    }
+    TaskScheduler::GetInstance()->Stop();
+    return ok;
+}
+
+void BM_CoSleepers(bench::State& state) {
+    TaskScheduler* scheduler = StartScheduler();
+    size_t count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        std::vector<CoTask<void>> sleepers;
+        sleepers.reserve(count);
+        for (size_t i = 0; i < count; ++i) sleepers.push_back(Sleeper(5, milliseconds(10)));
+        CoSyncWait(AwaitAll(std::move(sleepers)), CoContext{ scheduler, TaskPriority::Normal, "Sleeper" });
+    }
+    scheduler->Stop();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+
+class SleepTask : public ITask {
+private:
+    std::atomic<size_t>& remaining;
+
+public:
+    explicit SleepTask(std::atomic<size_t>& r) : remaining(r) {}
+    void Execute() override {
+        for (int i = 0; i < 5; ++i) std::this_thread::sleep_for(milliseconds(10));
+        remaining.fetch_sub(1);
+    }
+    std::string GetName() const override { return "Sleeper"; }
+};
+
+void BM_BlockingSleepers(bench::State& state) {
+    TaskScheduler* scheduler = StartScheduler();
+    size_t count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        std::atomic<size_t> remaining{ count };
+        std::vector<TaskSpec> specs(count);
+        for (auto& spec : specs) spec.task = std::make_shared<SleepTask>(remaining);
+        scheduler->AddTasks(specs);
+        while (remaining.load() != 0) std::this_thread::sleep_for(milliseconds(1));
+    }
+    scheduler->Stop();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+
+void BM_CoAwaitChain(bench::State& state) {
+    TaskScheduler* scheduler = StartScheduler();
+    int depth = static_cast<int>(state.range(0));
+    int64_t sink = 0;
+    for (auto _ : state) sink += CoSyncWait(Chain(depth));
+    state.counters["sink"] = sink > 0 ? 1.0 : 0.0;
+    scheduler->Stop();
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+
+void BM_CoMutex(bench::State& state) {
+    TaskScheduler* scheduler = StartScheduler();
+    int coros = static_cast<int>(state.range(0));
+    const int kTimes = 1000;
+    for (auto _ : state) {
+        CoMutex mutex;
+        int64_t counter = 0;
+        std::vector<CoTask<void>> children;
+        for (int i = 0; i < coros; ++i) children.push_back(Incrementer(mutex, counter, kTimes));
+        CoSyncWait(AwaitAll(std::move(children)));
+        if (counter != coros * kTimes) std::fprintf(stderr, "CoMutex lost updates\n");
+    }
+    scheduler->Stop();
+    state.SetItemsProcessed(state.iterations() * coros * kTimes);
+}
+
+void BM_CoSocket(bench::State& state) {
+    TaskScheduler* scheduler = StartScheduler();
+    const int kRounds = 1000;
+    Socket a, b;
+    if (!OpenPair(a, b)) {
+        std::fprintf(stderr, "cannot open loopback pair\n");
+        scheduler->Stop();
+        return;
+    }
+    for (auto _ : state) {
+        std::atomic<int> completed{ 0 };
+        std::vector<CoTask<void>> sides;
+        sides.push_back(PingPong(a, kRounds, false, completed));
+        sides.push_back(PingPong(b, kRounds, true, completed));
+        CoSyncWait(AwaitAll(std::move(sides)));
+        if (completed.load() != 2) std::fprintf(stderr, "ping-pong did not complete\n");
+    }
+    CloseSocket(a);
+    CloseSocket(b);
+    scheduler->Stop();
+    state.SetItemsProcessed(state.iterations() * kRounds);
+}
+
+} // namespace
+
+BENCHMARK(BM_CoSleepers)->Args({ 1000 })->Args({ 10000 })->ArgNames({ "tasks" })->Iterations(3);
+BENCHMARK(BM_BlockingSleepers)->Args({ 100 })->ArgNames({ "tasks" })->Iterations(1);
+BENCHMARK(BM_CoAwaitChain)->Args({ 1000 })->Args({ 100000 })->ArgNames({ "depth" });
+BENCHMARK(BM_CoMutex)->Args({ 1 })->Args({ 64 })->ArgNames({ "coros" });
+BENCHMARK(BM_CoSocket);
+
+int main(int argc, char** argv) {
+    TaskScheduler::GetInstance()->GetLogger().EnableAsync(); // 与 MFC 程序的配置一致
+    if (!Verify()) return 1;
+    int rc = bench::RunAll(argc, argv);
+    TaskScheduler::GetInstance()->GetLogger().Stop();
+    return rc;
+}
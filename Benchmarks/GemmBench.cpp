@@ -0,0 +1,139 @@
+﻿// GemmBench.cpp: 矩阵乘法 (MatrixTask 的计算核心) 的 GFLOP/s 基准
+// 不依赖 MFC；需要链接 scheduler_core (AVX 内核按文件加指令集选项，见 CMakeLists.txt)：
+//   cmake --build build --target GemmBench && ./build/GemmBench
+//
+// 对 64 ~ 1024 的方阵分别测量：
+//   BM_Gemm/isa:N     分块 + 打包 + 寄存器分块实现，N = 0 标量 / 1 AVX2 / 2 AVX-512
+//   BM_GemmNaive      三重循环参考实现 (只测到 256，更大的尺寸太慢)
+//   BM_GemmParallel   按块拆给调度器线程池 (MatrixTask 的做法)，当前最高指令集
+// 启动时先在奇数尺寸上对比参考实现，结果不一致时直接失败。
+
+#include "BenchHarness.h"
+#include "Gemm.h"
+#include "TaskScheduler.h"
+#include <cmath>
+
+namespace {
+
+double Flops(size_t n) {
+    return 2.0 * static_cast<double>(n) * static_cast<double>(n) * static_cast<double>(n);
+}
+
+// 按块计算，与 MatrixTask 相同
+void ParallelGemm(TaskScheduler* scheduler, const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c,
+    size_t minTiles) {
+    std::vector<GemmTile> tiles = GemmPartition(a, b, minTiles);
+    scheduler->ParallelFor(tiles.size(), [&](size_t i) { GemmComputeTile(a, b, c, tiles[i]); }, "Gemm Tile");
+}
+
+float MaxError(const AlignedMatrix& c, const AlignedMatrix& expected) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < c.Rows(); ++i) {
+        for (size_t j = 0; j < c.Cols(); ++j) {
+            worst = (std::max)(worst, std::fabs(c.At(i, j) - expected.At(i, j)));
+        }
+    }
+    return worst;
+}
+
+// 各指令集在不整除寄存器块 / 分块尺寸的形状上与参考实现对比，分块并行的结果也一并对比
+bool Verify() {
+    TaskScheduler* scheduler = TaskScheduler::GetInstance();
+    scheduler->SetWorkerCount(4);
+    scheduler->Start();
+    const size_t shapes[][3] = { { 1, 1, 1 }, { 17, 33, 5 }, { 100, 257, 300 }, { 257, 129, 513 } };
+    bool ok = true;
+    for (int level = 0; level <= static_cast<int>(GemmIsa::Avx512); ++level) {
+        GemmIsa isa = static_cast<GemmIsa>(level);
+        if (SetGemmIsa(isa) != isa) continue;
+        for (const auto& shape : shapes) {
+            AlignedMatrix a(shape[0], shape[2]), b(shape[2], shape[1]);
+            AlignedMatrix c(shape[0], shape[1]), expected(shape[0], shape[1]);
+            a.FillRandom(1);
+            b.FillRandom(2);
+            Gemm(a, b, c);
+            GemmReference(a, b, expected);
+            float worst = MaxError(c, expected);
+            c.Fill(0.0f);
+            ParallelGemm(scheduler, a, b, c, 64);
+            worst = (std::max)(worst, MaxError(c, expected));
+            // 单精度累加误差随 K 增长，按 K 放宽容差
+            if (worst > 1e-5f * static_cast<float>(shape[2]) + 1e-5f) {
+                std::fprintf(stderr, "GEMM mismatch: isa=%s %zux%zux%zu max_err=%g\n", GemmIsaName(isa), shape[0],
+                    shape[1], shape[2], worst);
+                ok = false;
+            }
+        }
+    }
+    SetGemmIsa(DetectGemmIsa());
+    scheduler->Stop();
+    return ok;
+}
+
+void BM_Gemm(bench::State& state) {
+    GemmIsa isa = static_cast<GemmIsa>(state.range(0));
+    size_t n = static_cast<size_t>(state.range(1));
+    if (SetGemmIsa(isa) != isa) {
+        SetGemmIsa(DetectGemmIsa());
+        state.SkipWithError("instruction set not supported by this CPU or build");
+        return;
+    }
+    AlignedMatrix a(n, n), b(n, n), c(n, n);
+    a.FillRandom(1);
+    b.FillRandom(2);
+    for (auto _ : state) {
+        Gemm(a, b, c);
+    }
+    SetGemmIsa(DetectGemmIsa());
+    double seconds = state.ElapsedSeconds(false);
+    state.counters["GFLOPS"] = seconds > 0.0 ? Flops(n) * static_cast<double>(state.iterations()) / seconds / 1e9 : 0.0;
+}
+
+void BM_GemmNaive(bench::State& state) {
+    size_t n = static_cast<size_t>(state.range(0));
+    AlignedMatrix a(n, n), b(n, n), c(n, n);
+    a.FillRandom(1);
+    b.FillRandom(2);
+    for (auto _ : state) {
+        GemmReference(a, b, c);
+    }
+    double seconds = state.ElapsedSeconds(false);
+    state.counters["GFLOPS"] = seconds > 0.0 ? Flops(n) * static_cast<double>(state.iterations()) / seconds / 1e9 : 0.0;
+}
+
+void BM_GemmParallel(bench::State& state) {
+    size_t workers = static_cast<size_t>(state.range(0));
+    size_t n = static_cast<size_t>(state.range(1));
+    TaskScheduler* scheduler = TaskScheduler::GetInstance();
+    scheduler->SetWorkerCount(workers);
+    scheduler->Start();
+    AlignedMatrix a(n, n), b(n, n), c(n, n);
+    a.FillRandom(1);
+    b.FillRandom(2);
+    for (auto _ : state) {
+        ParallelGemm(scheduler, a, b, c, workers * 4);
+    }
+    scheduler->Stop();
+    double seconds = state.ElapsedSeconds(false);
+    state.counters["GFLOPS"] = seconds > 0.0 ? Flops(n) * static_cast<double>(state.iterations()) / seconds / 1e9 : 0.0;
+    state.counters["tiles"] = static_cast<double>(GemmPartition(a, b, workers * 4).size());
+}
+
+} // namespace
+
+BENCHMARK(BM_Gemm)
+    ->Args({ 0, 64 })->Args({ 0, 256 })->Args({ 0, 512 })->Args({ 0, 1024 })
+    ->Args({ 1, 64 })->Args({ 1, 256 })->Args({ 1, 512 })->Args({ 1, 1024 })
+    ->Args({ 2, 64 })->Args({ 2, 256 })->Args({ 2, 512 })->Args({ 2, 1024 })
+    ->ArgNames({ "isa", "n" });
+BENCHMARK(BM_GemmNaive)->Args({ 64 })->Args({ 256 })->ArgNames({ "n" });
+BENCHMARK(BM_GemmParallel)
+    ->Args({ 1, 512 })->Args({ 2, 512 })->Args({ 4, 512 })->Args({ 8, 512 })
+    ->Args({ 1, 1024 })->Args({ 2, 1024 })->Args({ 4, 1024 })->Args({ 8, 1024 })
+    ->ArgNames({ "workers", "n" });
+
+int main(int argc, char** argv) {
+    std::printf("detected instruction set: %s\n", GemmIsaName(DetectGemmIsa()));
+    if (!Verify()) return 1;
+    return bench::RunAll(argc, argv);
+}
@@ -0,0 +1,372 @@
+﻿// HttpBench.cpp: 异步 HTTP 客户端 (HttpTask 的 I/O 引擎) 对本机替身服务的吞吐
+// 不依赖 MFC；需要链接 scheduler_core (见 CMakeLists.txt)
+//
+//   BM_HttpRoundTrip/conns:N   1000 个小请求同时提交，每主机最多 N 条 keep-alive 连接
+//   BM_HttpDelayed/conns:N     128 个服务端延迟 20 ms 的请求，在途请求数受连接数限制
+//   BM_HttpDownload/chunked:C  32 MB 响应体边收边写入临时文件 (C = 1 时为 chunked 编码)
+//   BM_HttpTasks/async:A       只有 1 个工作线程的调度器上跑 32 个请求任务 (各延迟 20 ms)：
+//                              A = 0 在 Execute 内阻塞等待响应，A = 1 交给延续任务，不占工作线程
+//
+// --serve=<端口> 只启动替身服务 (GET /zen 等)，供界面里的 HttpTask 使用，回车退出
+
+#include "SocketPoller.h" // 须在其他头文件之前，见该文件说明
+#include "BenchHarness.h"
+#include "HttpClient.h"
+#include "ITask.h"
+#include "TaskScheduler.h"
+#include "Utf8Path.h"
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+#ifdef _WIN32
+const int kShutdownBoth = SD_BOTH;
+#else
+const int kShutdownBoth = SHUT_RDWR;
+#endif
+
+// ------------------------------------------
+// 本机替身服务：每条连接一个线程的阻塞式 HTTP/1.1 服务，支持 keep-alive
+//   /zen          一句短文本
+//   /bytes/N      N 字节，带 Content-Length
+//   /chunked/N    N 字节，chunked 编码
+//   /delay/MS     等待 MS 毫秒后返回 "ok"
+//   /close        返回后关闭连接
+// ------------------------------------------
+class LocalHttpServer {
+public:
+    bool Start(uint16_t port = 0) {
+        listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener == kInvalidSocket) return false;
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        socklen_t len = sizeof(addr);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 1024) != 0 ||
+            getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            CloseSocket(listener);
+            listener = kInvalidSocket;
+            return false;
+        }
+        boundPort = ntohs(addr.sin_port);
+        acceptThread = std::thread([this] { AcceptLoop(); });
+        return true;
+    }
+
+    void Stop() {
+        if (listener == kInvalidSocket) return;
+        stopping = true;
+        shutdown(listener, kShutdownBoth);
+        CloseSocket(listener);
+        listener = kInvalidSocket;
+        acceptThread.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Socket s : clients) shutdown(s, kShutdownBoth);
+        }
+        for (auto& t : handlers) t.join();
+        handlers.clear();
+    }
+
+    ~LocalHttpServer() { Stop(); }
+
+    std::string Url(const std::string& path) const {
+        return "http://127.0.0.1:" + std::to_string(boundPort) + path;
+    }
+    uint16_t Port() const { return boundPort; }
+
+private:
+    SocketRuntime runtime;
+    Socket listener = kInvalidSocket;
+    uint16_t boundPort = 0;
+    std::atomic<bool> stopping{ false };
+    std::thread acceptThread;
+    std::mutex mutex;
+    std::vector<Socket> clients;
+    std::vector<std::thread> handlers;
+
+    void AcceptLoop() {
+        while (!stopping) {
+            Socket s = accept(listener, nullptr, nullptr);
+            if (s == kInvalidSocket) {
+                if (stopping) break;
+                continue;
+            }
+            int one = 1;
+            setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.push_back(s);
+            handlers.emplace_back([this, s] { Serve(s); });
+        }
+    }
+
+    static bool SendAll(Socket s, const char* data, size_t n) {
+        while (n > 0) {
+            int chunk = static_cast<int>((std::min)(n, size_t(1) << 20));
+            auto sent = send(s, data, chunk, kSendFlags);
+            if (sent <= 0) return false;
+            data += sent;
+            n -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    static std::string Pattern(size_t n) {
+        std::string body(n, ' ');
+        for (size_t i = 0; i < n; ++i) body[i] = static_cast<char>('a' + i % 26);
+        return body;
+    }
+
+    // 返回 false 表示发送后关闭连接
+    bool Respond(Socket s, const std::string& method, const std::string& path) {
+        std::string head = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n";
+        std::string body;
+        bool keep = true;
+        if (path == "/zen") {
+            body = "Keep it logically awesome.";
+        }
+        else if (path.compare(0, 7, "/bytes/") == 0) {
+            body = Pattern(std::strtoull(path.c_str() + 7, nullptr, 10));
+        }
+        else if (path.compare(0, 9, "/chunked/") == 0) {
+            std::string data = Pattern(std::strtoull(path.c_str() + 9, nullptr, 10));
+            std::string wire = head + "Transfer-Encoding: chunked\r\n\r\n";
+            const size_t kChunk = 16 * 1024;
+            char size[32];
+            for (size_t pos = 0; pos < data.size(); pos += kChunk) {
+                size_t n = (std::min)(kChunk, data.size() - pos);
+                std::snprintf(size, sizeof(size), "%zx\r\n", n);
+                wire += size;
+                wire.append(data, pos, n);
+                wire += "\r\n";
+            }
+            wire += "0\r\n\r\n";
+            return SendAll(s, wire.data(), wire.size());
+        }
+        else if (path.compare(0, 7, "/delay/") == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::atoi(path.c_str() + 7)));
+            body = "ok";
+        }
+        else if (path == "/close") {
+            body = "bye";
+            keep = false;
+            head += "Connection: close\r\n";
+        }
+        else {
+            head = "HTTP/1.1 404 Not Found\r\n";
+            body = "not found";
+        }
+        head += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+        if (method == "HEAD") body.clear();
+        if (!SendAll(s, head.data(), head.size()) || !SendAll(s, body.data(), body.size())) return false;
+        return keep;
+    }
+
+    void Serve(Socket s) {
+        std::string in;
+        char buf[16 * 1024];
+        bool open = true;
+        while (open && !stopping) {
+            auto n = recv(s, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            in.append(buf, static_cast<size_t>(n));
+            size_t end;
+            while (open && (end = in.find("\r\n\r\n")) != std::string::npos) {
+                size_t sp1 = in.find(' ');
+                size_t sp2 = in.find(' ', sp1 + 1);
+                std::string method = in.substr(0, (std::min)(sp1, end));
+                std::string path = sp1 < end && sp2 < end ? in.substr(sp1 + 1, sp2 - sp1 - 1) : "/";
+                in.erase(0, end + 4);
+                open = Respond(s, method, path);
+            }
+        }
+        shutdown(s, kShutdownBoth);
+        std::lock_guard<std::mutex> lock(mutex);
+        clients.erase(std::find(clients.begin(), clients.end(), s));
+        CloseSocket(s);
+    }
+};
+
+LocalHttpServer& Server() {
+    static LocalHttpServer server;
+    static bool started = server.Start();
+    (void)started;
+    return server;
+}
+
+// 等待 n 个回调
+class Latch {
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t remaining;
+
+public:
+    explicit Latch(size_t n) : remaining(n) {}
+    void CountDown() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) cv.notify_all();
+    }
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return remaining == 0; });
+    }
+};
+
+// 同时提交 count 个请求并等待全部完成；返回失败的个数
+size_t SendAll(HttpClient& client, const std::string& url, size_t count) {
+    Latch latch(count);
+    std::atomic<size_t> failures{ 0 };
+    for (size_t i = 0; i < count; ++i) {
+        HttpRequest request;
+        request.url = url;
+        client.Send(std::move(request), [&](HttpResponse& response) {
+            if (!response.ok || response.status != 200) failures++;
+            latch.CountDown();
+        });
+    }
+    latch.Wait();
+    return failures.load();
+}
+
+void BM_HttpRoundTrip(bench::State& state) {
+    HttpClientOptions options;
+    options.maxConnectionsPerHost = static_cast<size_t>(state.range(0));
+    HttpClient client(options);
+    const size_t kRequests = 1000;
+    std::string url = Server().Url("/zen");
+    size_t failures = 0;
+    for (auto _ : state) {
+        failures += SendAll(client, url, kRequests);
+    }
+    HttpClientStats stats = client.GetStats();
+    if (failures > 0) {
+        state.SkipWithError("requests failed");
+        return;
+    }
+    state.counters["conns_opened"] = static_cast<double>(stats.connectionsOpened);
+    state.counters["reuse"] = stats.requests ? static_cast<double>(stats.connectionsReused) / stats.requests : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kRequests));
+}
+
+void BM_HttpDelayed(bench::State& state) {
+    HttpClientOptions options;
+    options.maxConnectionsPerHost = static_cast<size_t>(state.range(0));
+    HttpClient client(options);
+    const size_t kRequests = 128;
+    std::string url = Server().Url("/delay/20");
+    size_t failures = 0;
+    for (auto _ : state) {
+        failures += SendAll(client, url, kRequests);
+    }
+    if (failures > 0) {
+        state.SkipWithError("requests failed");
+        return;
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kRequests));
+}
+
+void BM_HttpDownload(bench::State& state) {
+    HttpClient client;
+    const size_t kBytes = 32u << 20;
+    std::string url = Server().Url((state.range(0) ? "/chunked/" : "/bytes/") + std::to_string(kBytes));
+    std::string path = PathToUtf8(fs::temp_directory_path() / "scheduler_http_bench.bin");
+    HttpResponse last;
+    for (auto _ : state) {
+        std::promise<HttpResponse> done;
+        HttpRequest request;
+        request.url = url;
+        request.saveTo = path;
+        request.timeout = std::chrono::seconds(60);
+        client.Send(std::move(request), [&](HttpResponse& response) { done.set_value(response); });
+        last = done.get_future().get();
+        if (!last.ok) break;
+    }
+    std::error_code ec;
+    uintmax_t size = fs::file_size(PathFromUtf8(path), ec);
+    fs::remove(PathFromUtf8(path), ec);
+    if (!last.ok || last.bodyBytes != kBytes || size != kBytes) {
+        state.SkipWithError(last.ok ? "size mismatch" : last.error.c_str());
+        return;
+    }
+    state.counters["MBps"] = kBytes / last.seconds / 1e6;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kBytes)); // 字节
+}
+
+// 请求任务：async 时交给延续任务收尾，否则在 Execute 内阻塞等待 (占住工作线程)
+class BenchHttpTask : public ITask {
+private:
+    HttpClient& client;
+    std::string url;
+    bool async;
+    Latch& latch;
+
+public:
+    BenchHttpTask(HttpClient& c, std::string u, bool a, Latch& l) : client(c), url(std::move(u)), async(a), latch(l) {}
+    std::string GetName() const override { return "Bench HTTP"; }
+    void Execute() override {
+        HttpRequest request;
+        request.url = url;
+        if (async) {
+            Latch* done = &latch; // 任务对象在 Execute 返回后可能已释放，不能捕获 this
+            client.Send(std::move(request), *TaskScheduler::GetInstance(), [done](HttpResponse&) { done->CountDown(); });
+            return;
+        }
+        std::promise<void> done;
+        client.Send(std::move(request), [&](HttpResponse&) { done.set_value(); });
+        done.get_future().wait();
+        latch.CountDown();
+    }
+};
+
+void BM_HttpTasks(bench::State& state) {
+    bool async = state.range(0) != 0;
+    HttpClientOptions options;
+    options.maxConnectionsPerHost = 64;
+    HttpClient client(options);
+    TaskScheduler* scheduler = TaskScheduler::GetInstance();
+    scheduler->SetWorkerCount(1);
+    scheduler->Start();
+    const size_t kTasks = 32;
+    std::string url = Server().Url("/delay/20");
+    for (auto _ : state) {
+        Latch latch(kTasks);
+        std::vector<TaskSpec> specs(kTasks);
+        for (auto& spec : specs) spec.task = std::make_shared<BenchHttpTask>(client, url, async, latch);
+        scheduler->AddTasks(specs);
+        latch.Wait();
+    }
+    scheduler->Stop();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kTasks));
+}
+
+} // namespace
+
+BENCHMARK(BM_HttpRoundTrip)->Args({ 1 })->Args({ 8 })->Args({ 64 })->ArgNames({ "conns" });
+BENCHMARK(BM_HttpDelayed)->Args({ 1 })->Args({ 16 })->Args({ 64 })->ArgNames({ "conns" })->Iterations(3);
+BENCHMARK(BM_HttpDownload)->Args({ 0 })->Args({ 1 })->ArgNames({ "chunked" });
+BENCHMARK(BM_HttpTasks)->Args({ 0 })->Args({ 1 })->ArgNames({ "async" })->Iterations(3);
+
+int main(int argc, char** argv) {
+    if (argc == 2 && std::strncmp(argv[1], "--serve=", 8) == 0) {
+        LocalHttpServer server;
+        if (!server.Start(static_cast<uint16_t>(std::atoi(argv[1] + 8)))) {
+            std::fprintf(stderr, "cannot listen on port %s\n", argv[1] + 8);
+            return 1;
+        }
+        std::printf("serving %s (press Enter to stop)\n", server.Url("/zen").c_str());
+        std::getchar();
+        return 0;
+    }
+    return bench::RunAll(argc, argv);
+}
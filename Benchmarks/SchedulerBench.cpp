@@ -0,0 +1,494 @@
+﻿// SchedulerBench.cpp: 调度器核心的基准测试 (不依赖 MFC)
+// 需要链接 scheduler_core (见 CMakeLists.txt)：
+//   cmake --build build --target SchedulerBench && ./build/SchedulerBench
+//
+// 测量：
+//   BM_AddTask          不同队列深度、不同定时器后端下单次 AddTask 的耗时
+//   BM_SubmitExecute    不同线程数下"提交 -> 执行完成"的吞吐，逐个 AddTask 与批量 AddTasks 对比
+//   BM_DispatchLatency  到期时间到 Execute() 开始之间的延迟 (p50/p99/max)
+//   BM_PriorityLatency  大量低优先级任务积压时，高优先级任务的排队延迟 (p50/p99/max)
+//   BM_TaskGraph        菱形依赖图 (根 -> width 个并行分支 -> 汇合) 从提交到全部结束的耗时
+//   BM_PeriodicJitter   周期任务相邻两次执行的间隔与设定间隔之差，以及固定延迟/固定频率下的累积漂移
+//   BM_LogWrite         LogWriter 同步/异步模式下的单条写入耗时
+//   BM_Notify           慢观察者 (每条 20 us) 存在时发布一条通知的耗时，同步回调与异步成批投递对比
+//   BM_UiLogFrame       界面日志缓冲：threads 个线程写日志，另一线程按 30 帧/秒取帧，报告每帧最多行数
+//   BM_FactoryTask      TaskFactory 创建的带日志任务与空任务的端到端对比
+// 调度器日志照常写到当前目录的 scheduler_log.txt (与程序运行时一致，采用异步模式)。
+
+#include "BenchHarness.h"
+#include "TaskFactory.h"
+#include "TaskGraph.h"
+#include "TaskScheduler.h"
+#include "UiLogSink.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+class NopTask : public ITask {
+public:
+    void Execute() override {}
+    std::string GetName() const override { return "Nop"; }
+};
+
+// 执行一次就计数，用于等待一批任务全部完成
+class CountingTask : public ITask {
+private:
+    std::atomic<long long>& counter;
+
+public:
+    explicit CountingTask(std::atomic<long long>& c) : counter(c) {}
+    void Execute() override { counter.fetch_add(1, std::memory_order_relaxed); }
+    std::string GetName() const override { return "Counting"; }
+};
+
+// 多个工作线程并发写入的样本：next 分配槽位，filled 在写完后才递增
+struct Samples {
+    std::vector<double> values;
+    std::atomic<size_t> next;
+    std::atomic<size_t> filled;
+
+    explicit Samples(size_t count) : values(count, 0.0), next(0), filled(0) {}
+
+    void Add(double value) {
+        size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= values.size()) return;
+        values[slot] = value;
+        filled.fetch_add(1, std::memory_order_release);
+    }
+
+    void WaitFull() const {
+        while (filled.load(std::memory_order_acquire) < values.size()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+// 记录到期时间与实际开始之间的延迟
+class LatencyTask : public ITask {
+private:
+    SchedulerClock::time_point due;
+    Samples& samples;
+
+public:
+    LatencyTask(SchedulerClock::time_point d, Samples& s) : due(d), samples(s) {}
+    void Execute() override {
+        samples.Add(std::chrono::duration<double, std::micro>(SchedulerClock::now() - due).count());
+    }
+    std::string GetName() const override { return "Latency"; }
+};
+
+// 忙等一小段时间，模拟短小的计算任务
+class SpinTask : public ITask {
+private:
+    std::chrono::microseconds duration;
+    std::atomic<long long>& counter;
+
+public:
+    SpinTask(std::chrono::microseconds d, std::atomic<long long>& c) : duration(d), counter(c) {}
+    void Execute() override {
+        auto until = SteadyClock::now() + duration;
+        while (SteadyClock::now() < until) {
+        }
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::string GetName() const override { return "Spin"; }
+};
+
+// 周期任务：记录相邻两次执行之间的实际间隔
+class PeriodicProbe : public ITask {
+private:
+    SteadyClock::time_point last;
+    bool first;
+    Samples& samples;
+
+public:
+    explicit PeriodicProbe(Samples& s) : first(true), samples(s) {}
+    void Execute() override {
+        auto now = SteadyClock::now();
+        if (!first) {
+            samples.Add(std::chrono::duration<double, std::micro>(now - last).count());
+        }
+        first = false;
+        last = now;
+    }
+    std::string GetName() const override { return "PeriodicProbe"; }
+};
+
+// 按新的线程数/后端重启调度器单例
+TaskScheduler* Restart(size_t workers, TimerBackend backend = TimerBackend::BinaryHeap) {
+    TaskScheduler* scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+    scheduler->SetWorkerCount(workers);
+    scheduler->SetTimerBackend(backend);
+    scheduler->Start();
+    return scheduler;
+}
+
+void WaitFor(const std::atomic<long long>& counter, long long target) {
+    while (counter.load(std::memory_order_relaxed) < target) {
+        std::this_thread::yield();
+    }
+}
+
+double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+void ReportDistribution(bench::State& state, const std::vector<double>& samples, const char* prefix) {
+    std::string p(prefix);
+    state.counters[p + "_p50_us"] = Percentile(samples, 50);
+    state.counters[p + "_p99_us"] = Percentile(samples, 99);
+    state.counters[p + "_max_us"] = samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+}
+
+// ==========================================
+// AddTask：队列中已有 depth 个远期任务时，再插入一个远期任务的耗时
+// ==========================================
+void BM_AddTask(bench::State& state) {
+    TimerBackend backend = state.range(0) ? TimerBackend::TimingWheel : TimerBackend::BinaryHeap;
+    TaskScheduler* scheduler = Restart(1, backend);
+    auto task = std::make_shared<NopTask>();
+    const int kFarMs = 3600 * 1000;
+
+    std::vector<TaskHandle> handles;
+    handles.reserve(static_cast<size_t>(state.range(1) + state.iterations()));
+    for (int64_t i = 0; i < state.range(1); ++i) {
+        handles.push_back(scheduler->AddTask(task, kFarMs + static_cast<int>(i % 1000)));
+    }
+
+    for (auto _ : state) {
+        handles.push_back(scheduler->AddTask(task, kFarMs));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    for (auto& h : handles) h.Cancel();
+    scheduler->Stop(); // 停止时压缩掉已取消的条目
+}
+BENCHMARK(BM_AddTask)->ArgNames({ "wheel", "depth" })
+    ->Args({ 0, 0 })->Args({ 0, 10000 })->Args({ 0, 100000 })
+    ->Args({ 1, 0 })->Args({ 1, 10000 })->Args({ 1, 100000 });
+
+// ==========================================
+// 提交 N 个立即任务，直到全部执行完成；batch 为 1 时逐个 AddTask，否则每 batch 个调用一次 AddTasks
+// ==========================================
+void BM_SubmitExecute(bench::State& state) {
+    TaskScheduler* scheduler = Restart(static_cast<size_t>(state.range(0)));
+    size_t batch = static_cast<size_t>(state.range(1));
+    std::atomic<long long> done(0);
+    auto task = std::make_shared<CountingTask>(done);
+    std::vector<TaskSpec> specs;
+
+    auto start = SteadyClock::now();
+    for (int64_t i = 0; i < state.iterations(); ++i) {
+        if (batch <= 1) {
+            scheduler->AddTask(task, 0);
+            continue;
+        }
+        specs.push_back(TaskSpec{ task, 0 });
+        if (specs.size() == batch || i + 1 == state.iterations()) {
+            scheduler->AddTasks(specs);
+            specs.clear();
+        }
+    }
+    WaitFor(done, state.iterations());
+    state.SetIterationTime(std::chrono::duration<double>(SteadyClock::now() - start).count());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SubmitExecute)->ArgNames({ "workers", "batch" })
+    ->Args({ 1, 1 })->Args({ 2, 1 })->Args({ 4, 1 })->Args({ 8, 1 })
+    ->Args({ 1, 1000 })->Args({ 4, 1000 })->Args({ 8, 1000 })
+    ->UseManualTime();
+
+// ==========================================
+// 分发延迟：iterations 个任务在 1~50ms 内陆续到期，队列中另有 depth 个远期任务
+// ==========================================
+void BM_DispatchLatency(bench::State& state) {
+    TaskScheduler* scheduler = Restart(static_cast<size_t>(state.range(0)));
+    auto nop = std::make_shared<NopTask>();
+    std::vector<TaskHandle> background;
+    for (int64_t i = 0; i < state.range(1); ++i) {
+        background.push_back(scheduler->AddTask(nop, 3600 * 1000));
+    }
+
+    Samples samples(static_cast<size_t>(state.iterations()));
+    auto start = SteadyClock::now();
+    for (int64_t i = 0; i < state.iterations(); ++i) {
+        int delayMs = 1 + static_cast<int>(i % 50);
+        auto due = SchedulerClock::now() + std::chrono::milliseconds(delayMs);
+        scheduler->AddTask(std::make_shared<LatencyTask>(due, samples), delayMs);
+    }
+    samples.WaitFull();
+    state.SetIterationTime(std::chrono::duration<double>(SteadyClock::now() - start).count());
+    ReportDistribution(state, samples.values, "delay");
+
+    for (auto& h : background) h.Cancel();
+    scheduler->Stop();
+}
+BENCHMARK(BM_DispatchLatency)->ArgNames({ "workers", "depth" })
+    ->Args({ 1, 0 })->Args({ 4, 0 })->Args({ 4, 100000 })
+    ->Iterations(5000)->UseManualTime();
+
+// ==========================================
+// 优先级：先压入 20000 个 50us 的低优先级任务，再每 1ms 提交一个立即执行的探针任务
+// prio 1 = 探针为高优先级，0 = 探针与积压任务同为低优先级 (相当于原来的先到先服务)
+// ==========================================
+void BM_PriorityLatency(bench::State& state) {
+    TaskScheduler* scheduler = Restart(static_cast<size_t>(state.range(0)));
+    bool prioritized = state.range(1) != 0;
+    const size_t kBacklog = 20000;
+
+    std::atomic<long long> done(0);
+    auto spin = std::make_shared<SpinTask>(std::chrono::microseconds(50), done);
+    std::vector<TaskSpec> backlog(kBacklog, TaskSpec{ spin, 0 });
+    for (auto& spec : backlog) spec.priority = TaskPriority::Low;
+    scheduler->AddTasks(backlog);
+
+    Samples samples(static_cast<size_t>(state.iterations()));
+    auto start = SteadyClock::now();
+    for (int64_t i = 0; i < state.iterations(); ++i) {
+        TaskSpec probe{ std::make_shared<LatencyTask>(SchedulerClock::now(), samples), 0 };
+        probe.priority = prioritized ? TaskPriority::High : TaskPriority::Low;
+        scheduler->AddTask(probe);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    samples.WaitFull();
+    state.SetIterationTime(std::chrono::duration<double>(SteadyClock::now() - start).count());
+    ReportDistribution(state, samples.values, "probe");
+    scheduler->Stop();
+}
+BENCHMARK(BM_PriorityLatency)->ArgNames({ "workers", "prio" })
+    ->Args({ 2, 0 })->Args({ 2, 1 })->Args({ 4, 0 })->Args({ 4, 1 })
+    ->Iterations(200)->UseManualTime();
+
+// ==========================================
+// 依赖图：根 -> width 个 20us 的分支 -> 汇合，每次迭代提交一张图并等待结束
+// ==========================================
+void BM_TaskGraph(bench::State& state) {
+    TaskScheduler* scheduler = Restart(static_cast<size_t>(state.range(0)));
+    size_t width = static_cast<size_t>(state.range(1));
+    std::atomic<long long> done(0);
+    auto spin = std::make_shared<SpinTask>(std::chrono::microseconds(20), done);
+
+    TaskGraph graph;
+    TaskGraph::NodeId root = graph.AddNode(std::make_shared<NopTask>());
+    TaskGraph::NodeId join = graph.AddNode(nullptr);
+    for (size_t i = 0; i < width; ++i) {
+        TaskGraph::NodeId branch = graph.AddNode(spin);
+        graph.Precede(root, branch);
+        graph.Precede(branch, join);
+    }
+
+    for (auto _ : state) {
+        graph.Submit(*scheduler)->Wait();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(graph.Size()));
+    scheduler->Stop();
+}
+BENCHMARK(BM_TaskGraph)->ArgNames({ "workers", "width" })
+    ->Args({ 1, 16 })->Args({ 4, 16 })->Args({ 4, 256 });
+
+// ==========================================
+// 周期抖动：count 个间隔 5ms 的周期任务同时运行，每个采样 iterations 次间隔
+// mode 0 = 固定延迟，1 = 固定频率；drift 为每个任务平均的累积漂移 (实际总时长 - 次数 × 间隔)
+// ==========================================
+void BM_PeriodicJitter(bench::State& state) {
+    TaskScheduler* scheduler = Restart(static_cast<size_t>(state.range(0)));
+    const int kIntervalMs = 5;
+    size_t count = static_cast<size_t>(state.range(1));
+    PeriodicMode mode = state.range(2) ? PeriodicMode::FixedRate : PeriodicMode::FixedDelay;
+
+    Samples samples(count * static_cast<size_t>(state.iterations()));
+    std::vector<TaskHandle> handles;
+    auto start = SteadyClock::now();
+    for (size_t i = 0; i < count; ++i) {
+        handles.push_back(scheduler->AddTask(std::make_shared<PeriodicProbe>(samples), 0, true, kIntervalMs, mode));
+    }
+    samples.WaitFull();
+    state.SetIterationTime(std::chrono::duration<double>(SteadyClock::now() - start).count());
+    for (auto& h : handles) h.Cancel();
+
+    std::vector<double> jitter = samples.values;
+    double drift = 0.0;
+    for (auto& interval : jitter) {
+        drift += interval - kIntervalMs * 1000.0;
+        interval = interval > kIntervalMs * 1000.0 ? interval - kIntervalMs * 1000.0 : kIntervalMs * 1000.0 - interval;
+    }
+    ReportDistribution(state, jitter, "jitter");
+    state.counters["drift_us"] = drift / static_cast<double>(count);
+    scheduler->Stop();
+}
+BENCHMARK(BM_PeriodicJitter)->ArgNames({ "workers", "tasks", "mode" })
+    ->Args({ 1, 1, 0 })->Args({ 1, 1, 1 })->Args({ 4, 1, 0 })->Args({ 4, 1, 1 })
+    ->Args({ 4, 1000, 0 })->Args({ 4, 1000, 1 })
+    ->Iterations(200)->UseManualTime();
+
+// ==========================================
+// 日志开销：threads 个线程并发写，mode 0 = 同步，1 = 异步
+// ==========================================
+void BM_LogWrite(bench::State& state) {
+    bool async = state.range(0) != 0;
+    int threads = static_cast<int>(state.range(1));
+    int64_t perThread = state.iterations() / threads + 1;
+    double seconds = 0.0;
+    {
+        LogWriter writer("bench_log.txt");
+        if (async) writer.EnableAsync();
+        auto start = SteadyClock::now();
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&writer, perThread, t] {
+                for (int64_t i = 0; i < perThread; ++i) {
+                    writer.Write("[Bench] thread " + std::to_string(t) + " line " + std::to_string(i));
+                }
+            });
+        }
+        for (auto& w : writers) w.join();
+        seconds = std::chrono::duration<double>(SteadyClock::now() - start).count(); // 生产者侧的耗时
+        writer.Flush();
+    }
+    std::remove("bench_log.txt");
+    state.SetIterationTime(seconds);
+    state.SetItemsProcessed(perThread * threads);
+}
+BENCHMARK(BM_LogWrite)->ArgNames({ "async", "threads" })
+    ->Args({ 0, 1 })->Args({ 0, 4 })->Args({ 1, 1 })->Args({ 1, 4 })
+    ->UseManualTime();
+
+// ==========================================
+// 观察者通知：threads 个线程并发发布，mode 0 = 同步回调，1 = 异步成批投递
+// 消息带 8 种状态 key，异步模式下同一批中的重复状态被合并
+// ==========================================
+class SlowObserver : public IObserver {
+public:
+    std::atomic<long long> seen{ 0 };
+    void OnLogUpdate(const std::string&) override {
+        auto until = SteadyClock::now() + std::chrono::microseconds(20);
+        while (SteadyClock::now() < until) {
+        }
+        seen.fetch_add(1);
+    }
+};
+
+void BM_Notify(bench::State& state) {
+    bool async = state.range(0) != 0;
+    int threads = static_cast<int>(state.range(1));
+    int64_t perThread = state.iterations() / threads + 1;
+    SlowObserver observer;
+    ObserverHub hub;
+    hub.Attach(&observer);
+    if (async) hub.EnableAsync();
+    auto start = SteadyClock::now();
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < threads; ++t) {
+        publishers.emplace_back([&hub, perThread] {
+            for (int64_t i = 0; i < perThread; ++i) {
+                std::string key = "running/" + std::to_string(i % 8);
+                hub.Publish("[Running] " + key, key);
+            }
+        });
+    }
+    for (auto& p : publishers) p.join();
+    double seconds = std::chrono::duration<double>(SteadyClock::now() - start).count(); // 发布方的耗时
+    hub.Stop();
+    hub.Detach(&observer);
+    ObserverHubStats stats = hub.GetStats();
+    state.SetIterationTime(seconds);
+    state.SetItemsProcessed(perThread * threads);
+    state.counters["delivered"] = static_cast<double>(observer.seen.load());
+    state.counters["coalesced"] = static_cast<double>(stats.coalesced);
+    state.counters["dropped"] = static_cast<double>(stats.dropped);
+}
+BENCHMARK(BM_Notify)->ArgNames({ "async", "threads" })
+    ->Args({ 0, 1 })->Args({ 0, 4 })->Args({ 1, 1 })->Args({ 1, 4 })
+    ->UseManualTime();
+
+// ==========================================
+// 界面日志帧：不管写得多快，每帧交给界面的行数不超过 historyLimit
+// ==========================================
+void BM_UiLogFrame(bench::State& state) {
+    int threads = static_cast<int>(state.range(0));
+    int64_t perThread = state.iterations() / threads + 1;
+    UiLogSink sink(1000);
+    std::atomic<bool> producing(true);
+    size_t frames = 0;
+    size_t maxLines = 0;
+    size_t shownMax = 0;
+    std::thread ui([&] {
+        UiLogFrame frame;
+        for (;;) {
+            bool more = producing.load();
+            while (sink.PollFrame(frame)) {
+                ++frames;
+                maxLines = (std::max)(maxLines, frame.lines.size());
+                shownMax = (std::max)(shownMax, sink.Shown());
+                if (more) break; // 生产中每帧只取一次
+            }
+            if (!more) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(33));
+        }
+    });
+    auto start = SteadyClock::now();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&sink, perThread, t] {
+            for (int64_t i = 0; i < perThread; ++i) {
+                sink.OnLogUpdate("[Bench] thread " + std::to_string(t) + " line " + std::to_string(i));
+            }
+        });
+    }
+    for (auto& w : writers) w.join();
+    double seconds = std::chrono::duration<double>(SteadyClock::now() - start).count(); // 写入方的耗时
+    producing = false;
+    ui.join();
+    state.SetIterationTime(seconds);
+    state.SetItemsProcessed(perThread * threads);
+    state.counters["frames"] = static_cast<double>(frames);
+    state.counters["maxLines"] = static_cast<double>(maxLines);
+    state.counters["maxShown"] = static_cast<double>(shownMax);
+    state.counters["dropped"] = static_cast<double>(sink.GetDroppedCount());
+}
+BENCHMARK(BM_UiLogFrame)->ArgNames({ "threads" })->Args({ 1 })->Args({ 4 })->UseManualTime();
+
+// ==========================================
+// 工厂任务：Stats 任务每次执行写一行日志，与空任务对比即为任务内日志的开销
+// ==========================================
+void BM_FactoryTask(bench::State& state) {
+    TaskScheduler* scheduler = Restart(static_cast<size_t>(state.range(1)));
+    std::atomic<long long> done(0);
+    auto counter = std::make_shared<CountingTask>(done);
+    auto task = state.range(0) ? TaskFactory::CreateTask("Stats") : std::shared_ptr<ITask>(std::make_shared<NopTask>());
+
+    auto start = SteadyClock::now();
+    for (int64_t i = 0; i < state.iterations(); ++i) {
+        scheduler->AddTask(task, 0);
+    }
+    scheduler->AddTask(counter, 0);
+    scheduler->Stop(); // 排空：等全部任务执行完
+    WaitFor(done, 1);
+    state.SetIterationTime(std::chrono::duration<double>(SteadyClock::now() - start).count());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FactoryTask)->ArgNames({ "stats", "workers" })
+    ->Args({ 0, 4 })->Args({ 1, 4 })
+    ->UseManualTime();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    TaskScheduler::GetInstance()->GetLogger().EnableAsync(); // 与 MFC 程序的配置一致
+    int rc = bench::RunAll(argc, argv);
+    TaskScheduler::GetInstance()->Stop();
+    TaskScheduler::GetInstance()->GetLogger().Stop();
+    return rc;
+}
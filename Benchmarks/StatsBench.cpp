@@ -0,0 +1,270 @@
+﻿// StatsBench.cpp: 流式统计 (StatsTask 的计算核心) 的吞吐与精度
+// 不依赖 MFC；需要链接 scheduler_core (见 CMakeLists.txt)：
+//   cmake --build build --target StatsBench && ./build/StatsBench
+//
+//   BM_WelfordAdd       逐个值的 Welford 递推 (基线)
+//   BM_RunningBatch     分块 + 多路并行的批量累加
+//   BM_KllAdd           KLL 分位数草图的插入
+//   BM_KllMerge         合并 N 个分片的草图并查询分位数
+//   BM_Mt19937Normal    std::mt19937_64 + std::normal_distribution 逐个生成 (基线)
+//   BM_PhiloxBits/Uniform/Normal   Philox4x32-10 批量生成
+//   BM_Pipeline/chunk:N 生成 + 累加融合，N 为缓冲区大小 (4096 留在 L1，1M 相当于先整体生成)
+// 启动时先检查精度：均值远大于标准差时的方差 (大数相消)，以及草图分位数的秩误差；
+// Philox 对照 Random123 的已知答案，并检查批量路径与逐块路径一致。
+
+#include "BenchHarness.h"
+#include "StreamingStats.h"
+#include "Philox.h"
+#include <cmath>
+#include <random>
+
+namespace {
+
+std::vector<double> MakeData(size_t n, double mean, double sd, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> dist(mean, sd);
+    std::vector<double> data(n);
+    for (auto& v : data) v = dist(rng);
+    return data;
+}
+
+bool VerifyPhilox() {
+    // Random123 kat_vectors 中 philox4x32_10 的三组 (计数器, 密钥) -> 输出
+    struct Kat {
+        uint64_t counterLo, counterHi, key;
+        uint32_t expected[4];
+    };
+    const Kat kats[] = {
+        { 0, 0, 0, { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } },
+        { ~0ull, ~0ull, ~0ull, { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } },
+        { 0x85a308d3243f6a88ull, 0x0370734413198a2eull, 0x299f31d0a4093822ull,
+          { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } },
+    };
+    bool ok = true;
+    for (const auto& kat : kats) {
+        PhiloxStream::Block b = PhiloxStream::Generate(kat.counterLo, kat.counterHi, kat.key);
+        for (int i = 0; i < 4; ++i) {
+            if (b.v[i] != kat.expected[i]) {
+                std::fprintf(stderr, "Philox KAT mismatch: word %d got %08x expected %08x\n", i, b.v[i], kat.expected[i]);
+                ok = false;
+            }
+        }
+    }
+
+    // 批量 (8 路交错) 与逐块生成一致，跳转后与顺序生成一致
+    PhiloxStream stream(42, 7);
+    std::vector<PhiloxStream::Block> blocks(1000);
+    stream.FillBits(blocks.data(), 13);
+    stream.FillBits(blocks.data() + 13, blocks.size() - 13);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        PhiloxStream::Block ref = PhiloxStream::Generate(i, 7, 42);
+        for (int w = 0; w < 4; ++w) {
+            if (blocks[i].v[w] != ref.v[w]) ok = false;
+        }
+    }
+    PhiloxStream jumped(42, 7);
+    jumped.Seek(500);
+    PhiloxStream::Block b;
+    jumped.FillBits(&b, 1);
+    if (b.v[0] != blocks[500].v[0] || b.v[3] != blocks[500].v[3]) ok = false;
+
+    // 正态样本的矩
+    std::vector<double> normal(1 << 20);
+    PhiloxStream(1, 0).FillNormal(normal.data(), normal.size(), 0.0, 1.0);
+    RunningStats stats;
+    stats.AddBatch(normal.data(), normal.size());
+    if (std::fabs(stats.Mean()) > 0.01 || std::fabs(stats.StdDev() - 1.0) > 0.01) {
+        std::fprintf(stderr, "Philox normal moments off: mean %g sd %g\n", stats.Mean(), stats.StdDev());
+        ok = false;
+    }
+    if (!ok) std::fprintf(stderr, "Philox verification failed\n");
+    return ok;
+}
+
+bool Verify() {
+    bool ok = VerifyPhilox();
+
+    // 均值 1e9、标准差 1：朴素的 Σx² - (Σx)²/n 在这里完全失效
+    std::vector<double> data = MakeData(1000000, 1e9, 1.0, 7);
+    long double sum = 0.0L;
+    for (double v : data) sum += v;
+    long double exactMean = sum / data.size();
+    long double sq = 0.0L;
+    for (double v : data) sq += (v - exactMean) * (v - exactMean);
+    double exactVar = static_cast<double>(sq / (data.size() - 1));
+
+    RunningStats batch, single, merged, halfA, halfB;
+    batch.AddBatch(data.data(), data.size());
+    for (double v : data) single.Add(v);
+    halfA.AddBatch(data.data(), data.size() / 3);
+    halfB.AddBatch(data.data() + data.size() / 3, data.size() - data.size() / 3);
+    merged.Merge(halfA);
+    merged.Merge(halfB);
+    const RunningStats* all[] = { &batch, &single, &merged };
+    const char* names[] = { "batch", "single", "merged" };
+    for (int i = 0; i < 3; ++i) {
+        double relErr = std::fabs(all[i]->SampleVariance() - exactVar) / exactVar;
+        if (relErr > 1e-6) {
+            std::fprintf(stderr, "variance mismatch (%s): got %.9g expected %.9g\n", names[i],
+                all[i]->SampleVariance(), exactVar);
+            ok = false;
+        }
+    }
+
+    // 分片草图合并后的秩误差
+    std::vector<double> skewed = MakeData(1000000, 0.0, 1.0, 11);
+    for (auto& v : skewed) v = std::exp(v); // 对数正态，长尾
+    KllSketch total;
+    for (size_t part = 0; part < 8; ++part) {
+        KllSketch sketch;
+        size_t begin = skewed.size() * part / 8, end = skewed.size() * (part + 1) / 8;
+        sketch.AddBatch(skewed.data() + begin, end - begin);
+        total.Merge(sketch);
+    }
+    std::vector<double> sorted = skewed;
+    std::sort(sorted.begin(), sorted.end());
+    double worst = 0.0;
+    for (double q : { 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999 }) {
+        double estimate = total.Quantile(q);
+        double rank = static_cast<double>(std::lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin()) /
+            static_cast<double>(sorted.size());
+        worst = (std::max)(worst, std::fabs(rank - q));
+    }
+    std::printf("KLL k=200: retained %zu of %llu values, max rank error %.4f\n", total.Retained(),
+        static_cast<unsigned long long>(total.Count()), worst);
+    if (worst > 0.02) ok = false;
+    return ok;
+}
+
+const std::vector<double>& BenchData() {
+    static const std::vector<double> data = MakeData(1 << 20, 50.0, 10.0, 3);
+    return data;
+}
+
+void BM_WelfordAdd(bench::State& state) {
+    const auto& data = BenchData();
+    double sink = 0.0;
+    for (auto _ : state) {
+        RunningStats stats;
+        for (double v : data) stats.Add(v);
+        sink += stats.Variance();
+    }
+    state.counters["sink"] = sink > 0.0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+
+void BM_RunningBatch(bench::State& state) {
+    const auto& data = BenchData();
+    double sink = 0.0;
+    for (auto _ : state) {
+        RunningStats stats;
+        stats.AddBatch(data.data(), data.size());
+        sink += stats.Variance();
+    }
+    state.counters["sink"] = sink > 0.0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+
+void BM_KllAdd(bench::State& state) {
+    const auto& data = BenchData();
+    size_t k = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        KllSketch sketch(k);
+        sketch.AddBatch(data.data(), data.size());
+        state.counters["retained"] = static_cast<double>(sketch.Retained());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.size()));
+}
+
+void BM_KllMerge(bench::State& state) {
+    const auto& data = BenchData();
+    size_t parts = static_cast<size_t>(state.range(0));
+    std::vector<KllSketch> sketches(parts);
+    for (size_t part = 0; part < parts; ++part) {
+        size_t begin = data.size() * part / parts, end = data.size() * (part + 1) / parts;
+        sketches[part].AddBatch(data.data() + begin, end - begin);
+    }
+    double sink = 0.0;
+    for (auto _ : state) {
+        KllSketch total;
+        for (const auto& sketch : sketches) total.Merge(sketch);
+        sink += total.Quantile(0.99);
+    }
+    state.counters["sink"] = sink > 0.0 ? 1.0 : 0.0;
+}
+
+void BM_Mt19937Normal(bench::State& state) {
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> dist(50.0, 10.0);
+    std::vector<double> out(4096);
+    for (auto _ : state) {
+        for (auto& v : out) v = dist(rng);
+    }
+    state.counters["sink"] = out[0] != 0.0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(out.size()));
+}
+
+void BM_PhiloxBits(bench::State& state) {
+    PhiloxStream stream(1, 0);
+    std::vector<PhiloxStream::Block> out(1024);
+    for (auto _ : state) {
+        stream.FillBits(out.data(), out.size());
+    }
+    state.counters["sink"] = out[0].v[0] != 0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(out.size()) * 4); // 32 位字
+}
+
+void BM_PhiloxUniform(bench::State& state) {
+    PhiloxStream stream(1, 0);
+    std::vector<double> out(4096);
+    for (auto _ : state) {
+        stream.FillUniform(out.data(), out.size());
+    }
+    state.counters["sink"] = out[0] != 0.0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(out.size()));
+}
+
+void BM_PhiloxNormal(bench::State& state) {
+    PhiloxStream stream(1, 0);
+    std::vector<double> out(4096);
+    for (auto _ : state) {
+        stream.FillNormal(out.data(), out.size(), 50.0, 10.0);
+    }
+    state.counters["sink"] = out[0] != 0.0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(out.size()));
+}
+
+// StatsTask 的单个分片：按块生成并立即累加
+void BM_Pipeline(bench::State& state) {
+    const size_t total = 1 << 22;
+    size_t chunk = static_cast<size_t>(state.range(0));
+    std::vector<double> buffer(chunk);
+    double sink = 0.0;
+    for (auto _ : state) {
+        StreamingStats stats;
+        for (size_t c = 0; c * chunk < total; ++c) {
+            PhiloxStream(7, c).FillNormal(buffer.data(), chunk, 50.0, 10.0);
+            stats.AddBatch(buffer.data(), chunk);
+        }
+        sink += stats.moments.Mean();
+    }
+    state.counters["sink"] = sink > 0.0 ? 1.0 : 0.0;
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(total));
+}
+
+} // namespace
+
+BENCHMARK(BM_WelfordAdd);
+BENCHMARK(BM_RunningBatch);
+BENCHMARK(BM_KllAdd)->Args({ 100 })->Args({ 200 })->Args({ 800 })->ArgNames({ "k" });
+BENCHMARK(BM_KllMerge)->Args({ 4 })->Args({ 16 })->Args({ 64 })->ArgNames({ "parts" });
+BENCHMARK(BM_Mt19937Normal);
+BENCHMARK(BM_PhiloxBits);
+BENCHMARK(BM_PhiloxUniform);
+BENCHMARK(BM_PhiloxNormal);
+BENCHMARK(BM_Pipeline)->Args({ 4096 })->Args({ 1 << 20 })->ArgNames({ "chunk" });
+
+int main(int argc, char** argv) {
+    if (!Verify()) return 1;
+    return bench::RunAll(argc, argv);
+}
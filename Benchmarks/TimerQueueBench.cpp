@@ -0,0 +1,106 @@
+﻿// TimerQueueBench.cpp: 定时器后端基准测试 (二叉堆 vs 分层时间轮)
+// 不依赖 MFC；需要链接 scheduler_core (见 CMakeLists.txt)：
+//   cmake --build build --target TimerQueueBench && ./build/TimerQueueBench
+//
+// 对 1k / 100k / 1M 个待执行定时器分别测量：
+//   insert  : 批量插入的单次耗时
+//   rearm   : 稳态下"到期一个、再续期一个"(周期任务) 的单次耗时
+//   drain   : 推进时间直到全部到期的单次耗时
+// 时间是模拟推进的，不依赖真实时钟，两种后端面对完全相同的输入。
+
+#include "HeapTimerQueue.h"
+#include "TimingWheel.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+class NopTask : public ITask {
+public:
+    void Execute() override {}
+    std::string GetName() const override { return "Nop"; }
+};
+
+using Clock = std::chrono::steady_clock;
+using TimePoint = SchedulerClock::time_point;
+
+struct Result {
+    double insertNs;
+    double rearmNs;
+    double drainNs;
+};
+
+double NsPerOp(Clock::time_point start, Clock::time_point end, size_t ops) {
+    if (ops == 0) return 0.0;
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+}
+
+template <typename MakeQueue>
+Result Run(MakeQueue makeQueue, size_t pending, TimePoint origin) {
+    std::mt19937_64 rng(12345);
+    // 延迟分布：大部分落在 60 秒内，模拟大量周期任务与延迟任务
+    std::uniform_int_distribution<int> delayMs(1, 60000);
+    auto task = std::make_shared<NopTask>();
+    auto queue = makeQueue(origin);
+    Result result{};
+
+    // 1. 批量插入
+    std::vector<int> delays(pending);
+    for (auto& d : delays) d = delayMs(rng);
+    auto start = Clock::now();
+    for (size_t i = 0; i < pending; ++i) {
+        queue->Push(ScheduledTask(task, origin + std::chrono::milliseconds(delays[i]), true, delays[i]));
+    }
+    result.insertNs = NsPerOp(start, Clock::now(), pending);
+
+    // 2. 稳态续期：时间每次推进 1ms，把到期的任务按各自间隔重新插入，队列长度保持不变
+    std::vector<ScheduledTask> due;
+    size_t rearmOps = 0;
+    TimePoint now = origin;
+    start = Clock::now();
+    while (rearmOps < pending) {
+        now += std::chrono::milliseconds(1);
+        due.clear();
+        queue->PopDue(now, due);
+        for (auto& t : due) {
+            t.executeTime = now + t.interval;
+            queue->Push(std::move(t));
+        }
+        rearmOps += due.size();
+    }
+    result.rearmNs = NsPerOp(start, Clock::now(), rearmOps);
+
+    // 3. 排空
+    size_t drained = 0;
+    start = Clock::now();
+    while (!queue->Empty()) {
+        now += std::chrono::milliseconds(1);
+        due.clear();
+        queue->PopDue(now, due);
+        drained += due.size();
+    }
+    result.drainNs = NsPerOp(start, Clock::now(), drained);
+    return result;
+}
+
+} // namespace
+
+int main() {
+    const size_t sizes[] = { 1000, 100000, 1000000 };
+    TimePoint origin = SchedulerClock::now();
+
+    std::printf("%-12s %10s %12s %12s %12s\n", "backend", "pending", "insert ns", "rearm ns", "drain ns");
+    for (size_t n : sizes) {
+        Result heap = Run([](TimePoint) { return std::make_unique<HeapTimerQueue>(); }, n, origin);
+        std::printf("%-12s %10zu %12.1f %12.1f %12.1f\n", "BinaryHeap", n, heap.insertNs, heap.rearmNs, heap.drainNs);
+
+        Result wheel = Run([](TimePoint start) {
+            return std::make_unique<TimingWheel>(std::chrono::milliseconds(1), start);
+            }, n, origin);
+        std::printf("%-12s %10zu %12.1f %12.1f %12.1f\n", "TimingWheel", n, wheel.insertNs, wheel.rearmNs, wheel.drainNs);
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+﻿#include "BackupEngine.h"
+#include "TaskScheduler.h"
+#include "Utf8Path.h"
+#include "ZipWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct FileItem {
+    fs::path path;
+    std::string name;   // 归档内的相对路径，'/' 分隔
+    uint64_t size;
+    long long modified; // time_t
+};
+
+// 一个待压缩的块；空文件也占一个长度为 0 的块，保证每个文件都有首块和末块
+struct BlockItem {
+    size_t file;
+    uint64_t offset;
+    size_t length;
+    bool last;
+};
+
+struct BlockResult {
+    std::vector<uint8_t> data;
+    uint32_t crc = 0;
+    size_t length = 0;  // 实际读到的字节数
+    bool opened = false;
+};
+
+long long ModifiedTime(const fs::path& path) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_wstat64(path.c_str(), &st) != 0) return 0;
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return 0;
+#endif
+    return static_cast<long long>(st.st_mtime);
+}
+
+// 列举一个目录：普通文件记入 files，子目录记入 dirs；不跟随符号链接
+void ListDirectory(const fs::path& root, const fs::path& dir, const fs::path& exclude, std::vector<FileItem>& files,
+    std::vector<fs::path>& dirs, uint64_t& skipped) {
+    std::error_code ec;
+    fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        ++skipped;
+        return;
+    }
+    for (; it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            ++skipped;
+            break;
+        }
+        fs::file_status status = it->symlink_status(ec);
+        if (ec) {
+            ++skipped;
+            continue;
+        }
+        if (fs::is_directory(status)) {
+            dirs.push_back(it->path());
+        }
+        else if (fs::is_regular_file(status)) {
+            // 先比较文件名，同名时才做一次 equivalent (两次 stat)
+            if (it->path().filename() == exclude.filename() && fs::equivalent(it->path(), exclude, ec)) continue;
+            uint64_t size = it->file_size(ec);
+            if (ec) {
+                ++skipped;
+                continue;
+            }
+            files.push_back(FileItem{ it->path(), GenericPathToUtf8(it->path().lexically_relative(root)), size,
+                ModifiedTime(it->path()) });
+        }
+    }
+}
+
+// 按层并行遍历：每一层的所有目录同时列举，下一层由它们的子目录组成
+std::vector<FileItem> Walk(const fs::path& root, const fs::path& exclude, TaskScheduler& scheduler, uint64_t& skipped) {
+    std::vector<FileItem> all;
+    std::vector<fs::path> level(1, root);
+    while (!level.empty()) {
+        std::vector<std::vector<FileItem>> files(level.size());
+        std::vector<std::vector<fs::path>> dirs(level.size());
+        std::vector<uint64_t> failures(level.size(), 0);
+        scheduler.ParallelFor(level.size(), [&](size_t i) {
+            ListDirectory(root, level[i], exclude, files[i], dirs[i], failures[i]);
+        }, "Backup Walk");
+
+        std::vector<fs::path> next;
+        for (size_t i = 0; i < level.size(); ++i) {
+            std::move(files[i].begin(), files[i].end(), std::back_inserter(all));
+            std::move(dirs[i].begin(), dirs[i].end(), std::back_inserter(next));
+            skipped += failures[i];
+        }
+        level.swap(next);
+    }
+    // 归档内的顺序与遍历的并行度无关
+    std::sort(all.begin(), all.end(), [](const FileItem& a, const FileItem& b) { return a.name < b.name; });
+    return all;
+}
+
+// 读取一块并压缩；首块打不开时整个文件跳过
+void CompressBlock(const FileItem& file, const BlockItem& block, BlockResult& result) {
+    result.data.clear();
+    result.crc = 0;
+    result.length = 0;
+    result.opened = false;
+
+    std::ifstream in(file.path, std::ios::binary);
+    if (!in) return;
+    result.opened = true;
+    if (block.length == 0) return;
+
+    static thread_local std::vector<char> buffer;
+    if (buffer.size() < block.length) buffer.resize(block.length);
+    in.seekg(static_cast<std::streamoff>(block.offset));
+    in.read(buffer.data(), static_cast<std::streamsize>(block.length));
+    result.length = static_cast<size_t>((std::max)(in.gcount(), std::streamsize(0))); // 文件在备份期间变短时只取读到的部分
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(buffer.data());
+    result.crc = Crc32Update(0, bytes, result.length);
+    DeflateBlock(bytes, result.length, result.data);
+}
+
+} // namespace
+
+BackupResult RunBackup(const BackupOptions& options, TaskScheduler& scheduler) {
+    BackupResult result;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+    std::error_code ec;
+    fs::path root = PathFromUtf8(options.source);
+    if (!fs::is_directory(root, ec)) {
+        result.error = "source is not a directory: " + options.source;
+        return result;
+    }
+    fs::path archive = options.archive.empty() ? fs::temp_directory_path(ec) / "scheduler_backup.zip"
+                                               : PathFromUtf8(options.archive);
+    result.archive = PathToUtf8(archive);
+
+    ZipWriter zip;
+    if (!zip.Open(result.archive)) {
+        result.error = zip.Error();
+        return result;
+    }
+
+    // 1. 遍历 (归档本身可能位于源目录内，需要排除)
+    std::vector<FileItem> files = Walk(root, archive, scheduler, result.skipped);
+    result.walkSeconds = elapsed();
+
+    // 2. 切块
+    size_t blockSize = (std::max)(options.blockSize, size_t(4096));
+    std::vector<BlockItem> blocks;
+    for (size_t f = 0; f < files.size(); ++f) {
+        uint64_t size = files[f].size;
+        uint64_t offset = 0;
+        do {
+            size_t length = static_cast<size_t>((std::min)(static_cast<uint64_t>(blockSize), size - offset));
+            blocks.push_back(BlockItem{ f, offset, length, offset + length >= size });
+            offset += length;
+        } while (offset < size);
+    }
+
+    // 3/4. 按窗口并行压缩，再按顺序写出
+    size_t window = options.maxInFlight > 0 ? options.maxInFlight : (std::max)(scheduler.GetWorkerCount(), size_t(1)) * 4;
+    std::vector<BlockResult> results(window);
+    bool skipFile = false;     // 当前文件的首块打不开
+    uint32_t fileCrc = 0;
+    uint64_t fileSize = 0;
+    bool ok = true;
+
+    for (size_t begin = 0; begin < blocks.size() && ok; begin += window) {
+        size_t count = (std::min)(window, blocks.size() - begin);
+        scheduler.ParallelFor(count, [&](size_t i) {
+            const BlockItem& block = blocks[begin + i];
+            CompressBlock(files[block.file], block, results[i]);
+        }, "Backup Block");
+
+        for (size_t i = 0; i < count && ok; ++i) {
+            const BlockItem& block = blocks[begin + i];
+            const FileItem& file = files[block.file];
+            BlockResult& r = results[i];
+            if (block.offset == 0) {
+                skipFile = !r.opened;
+                if (skipFile) {
+                    ++result.skipped;
+                    continue;
+                }
+                ok = zip.BeginEntry(file.name, file.modified);
+                fileCrc = 0;
+                fileSize = 0;
+            }
+            if (skipFile) continue;
+            ok = ok && zip.WriteData(r.data.data(), r.data.size());
+            fileCrc = Crc32Combine(fileCrc, r.crc, r.length);
+            fileSize += r.length;
+            if (block.last) {
+                ok = ok && zip.EndEntry(fileCrc, fileSize);
+                result.files++;
+                result.bytesIn += fileSize;
+            }
+        }
+    }
+    ok = ok && zip.Close();
+
+    result.seconds = elapsed();
+    result.bytesOut = zip.BytesWritten();
+    result.ok = ok;
+    if (!ok) result.error = zip.Error();
+    return result;
+}
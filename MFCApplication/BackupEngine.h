@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TaskScheduler;
+
+// 进程内的并行压缩备份：目录 -> 标准 zip
+//
+//   1. 并行遍历：按层展开目录，每层的目录交给线程池同时列举
+//   2. 分块读取：文件按 blockSize 切块，每块一次大块读取
+//   3. 分块压缩：同一窗口内的块通过 ParallelFor 在工作线程上并行压缩 (见 ZipWriter.h 的 DeflateBlock)
+//   4. 流式写出：窗口内的块按顺序追加到归档，内存中最多同时保留 maxInFlight 块
+struct BackupOptions {
+    std::string source;              // 要备份的目录
+    std::string archive;             // 输出的 zip 文件，空则写到临时目录下的 scheduler_backup.zip
+    size_t blockSize = size_t(1) << 20;
+    size_t maxInFlight = 0;          // 0 表示工作线程数 × 4
+};
+
+struct BackupResult {
+    bool ok = false;
+    std::string error;
+    std::string archive;             // 实际写出的归档路径
+    uint64_t files = 0;
+    uint64_t skipped = 0;            // 无法打开或读取的文件
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    double walkSeconds = 0.0;
+    double seconds = 0.0;            // 总耗时 (含遍历)
+
+    double ThroughputMBps() const { return seconds > 0.0 ? bytesIn / seconds / 1e6 : 0.0; }
+    double Ratio() const { return bytesIn > 0 ? static_cast<double>(bytesOut) / bytesIn : 0.0; }
+};
+
+// 在调用线程上执行备份，读取和压缩由 scheduler 的线程池分担
+// 可以在工作线程内调用 (例如 BackupTask)：调用者自己也参与，不会死锁
+BackupResult RunBackup(const BackupOptions& options, TaskScheduler& scheduler);
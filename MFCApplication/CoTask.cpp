@@ -0,0 +1,401 @@
+﻿#include "SocketPoller.h" // 须在其他头文件之前，见该文件说明
+#include "CoTask.h"
+#include "TaskScheduler.h"
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+using CoClock = std::chrono::steady_clock;
+
+thread_local const CoContext* tlsContext = nullptr;
+
+TaskScheduler* SchedulerOf(const CoContext& context) {
+    return context.scheduler ? context.scheduler : TaskScheduler::GetInstance();
+}
+
+// 在 context 中执行协程的一段：从恢复点直到下一次挂起或结束
+void RunSlice(std::coroutine_handle<> handle, const CoContext& context) {
+    struct Scope {
+        const CoContext* previous;
+        explicit Scope(const CoContext* c) : previous(tlsContext) { tlsContext = c; }
+        ~Scope() { tlsContext = previous; }
+    } scope(&context);
+    handle.resume();
+}
+
+// 恢复任务：协程的每一段都是调度器里的一个内部延续，名字、优先级和任务编号取自协程的上下文
+class CoResumeTask : public ITask {
+private:
+    std::coroutine_handle<> handle;
+    CoContext context;
+
+public:
+    CoResumeTask(std::coroutine_handle<> h, CoContext c) : handle(h), context(std::move(c)) {}
+    void Execute() override {
+        // 第一段提交时才分配编号，记下来，之后各段 (包括等待体捕获的上下文) 都沿用它
+        if (context.taskId == 0) context.taskId = TaskScheduler::CurrentTaskId();
+        RunSlice(handle, context);
+    }
+    std::string GetName() const override { return context.name; }
+};
+
+void LogFailure(TaskScheduler* scheduler, const std::string& name, std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    }
+    catch (const std::exception& e) {
+        scheduler->GetLogger().Write("[Error] Exception in coroutine " + name + ": " + e.what());
+    }
+    catch (...) {
+        scheduler->GetLogger().Write("[Error] Unknown exception in coroutine " + name);
+    }
+}
+
+// 标记为根协程：结束时自行销毁，并调用 onDone (为空时只记录异常)
+void Detach(CoTask<void>::Handle handle, const CoContext& context, std::function<void(std::exception_ptr)> onDone) {
+    auto& promise = handle.promise();
+    promise.detached = true;
+    if (!onDone) {
+        TaskScheduler* scheduler = SchedulerOf(context);
+        std::string name = context.name;
+        onDone = [scheduler, name](std::exception_ptr error) {
+            if (error) LogFailure(scheduler, name, error);
+        };
+    }
+    promise.onDetachedDone = std::move(onDone);
+}
+
+// ------------------------------------------
+// 套接字就绪的监视线程：所有 CoSocketReady 共用一个 Poller
+// ------------------------------------------
+class IoWatcher {
+public:
+    static IoWatcher& Instance() {
+        static IoWatcher watcher;
+        return watcher;
+    }
+
+    void Watch(intptr_t socket, CoIoEvent event, std::chrono::milliseconds timeout, bool* ready,
+        std::coroutine_handle<> handle, CoContext context) {
+        Request request;
+        request.socket = socket;
+        request.event = event;
+        request.waiter.handle = handle;
+        request.waiter.context = std::move(context);
+        request.waiter.ready = ready;
+        request.waiter.hasDeadline = timeout.count() >= 0;
+        if (request.waiter.hasDeadline) request.waiter.deadline = CoClock::now() + timeout;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!stopping) {
+                incoming.push_back(std::move(request));
+                request.waiter.handle = nullptr;
+            }
+        }
+        if (request.waiter.handle) {
+            Fire(request.waiter, false); // 已停止：当作超时
+            return;
+        }
+        if (wakeSocket != kInvalidSocket) SignalWakeSocket(wakeSocket);
+    }
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        CoContext context;
+        bool* ready = nullptr;
+        bool hasDeadline = false;
+        CoClock::time_point deadline;
+    };
+    struct Entry {
+        Socket socket = kInvalidSocket;
+        unsigned interest = 0;
+        Waiter read;
+        Waiter write;
+    };
+    struct Request {
+        intptr_t socket = 0;
+        CoIoEvent event = CoIoEvent::Readable;
+        Waiter waiter;
+    };
+
+    SocketRuntime runtime;
+    Poller poller;
+    Socket wakeSocket = kInvalidSocket;
+    std::thread thread;
+
+    std::mutex mutex;                 // 保护 incoming / stopping
+    std::vector<Request> incoming;
+    bool stopping = false;
+
+    std::unordered_map<intptr_t, Entry> entries; // 只在监视线程上访问；节点地址稳定，作为 Poller 的 tag
+    size_t timed = 0;                 // 带超时的等待者个数
+    std::vector<std::pair<Waiter, bool>> fired; // 待恢复的等待者
+
+    IoWatcher() {
+        wakeSocket = OpenWakeSocket();
+        if (wakeSocket != kInvalidSocket && !poller.Add(wakeSocket, nullptr, kPollRead)) {
+            CloseSocket(wakeSocket);
+            wakeSocket = kInvalidSocket;
+        }
+        thread = std::thread(&IoWatcher::Run, this);
+    }
+
+    ~IoWatcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        if (wakeSocket != kInvalidSocket) SignalWakeSocket(wakeSocket);
+        thread.join();
+        if (wakeSocket != kInvalidSocket) CloseSocket(wakeSocket);
+    }
+
+    static void Fire(Waiter& waiter, bool ready) {
+        *waiter.ready = ready;
+        std::coroutine_handle<> handle = std::exchange(waiter.handle, nullptr);
+        CoResume(handle, waiter.context);
+    }
+
+    // 取出等待者，先不恢复：必须等 Poller 的登记更新完再 Flush，
+    // 否则协程恢复后可能已关闭套接字 (编号还可能被复用)，再去 Remove 就错了
+    void Clear(Waiter& waiter, bool ready) {
+        if (!waiter.handle) return;
+        if (waiter.hasDeadline) --timed;
+        fired.emplace_back(std::move(waiter), ready);
+        waiter.handle = nullptr;
+    }
+
+    void Flush() {
+        for (auto& item : fired) Fire(item.first, item.second);
+        fired.clear();
+    }
+
+    // 按剩余的等待者重新登记关注的事件，没有等待者时移除
+    void Update(intptr_t key) {
+        auto it = entries.find(key);
+        Entry& entry = it->second;
+        unsigned want = (entry.read.handle ? kPollRead : 0u) | (entry.write.handle ? kPollWrite : 0u);
+        if (want == entry.interest) return;
+        if (want == 0) {
+            poller.Remove(entry.socket);
+            entries.erase(it);
+            return;
+        }
+        bool ok = entry.interest == 0 ? poller.Add(entry.socket, &entry, want) : poller.Modify(entry.socket, &entry, want);
+        entry.interest = want;
+        if (!ok) {
+            // 无效的套接字：立即恢复，由调用者的读写操作报告具体错误
+            Clear(entry.read, true);
+            Clear(entry.write, true);
+            poller.Remove(entry.socket);
+            entries.erase(it);
+        }
+    }
+
+    void Apply(Request& request) {
+        Entry& entry = entries[request.socket];
+        entry.socket = static_cast<Socket>(request.socket);
+        Waiter& slot = request.event == CoIoEvent::Readable ? entry.read : entry.write;
+        Clear(slot, false); // 同一方向已有等待者属于误用：旧的当作超时
+        if (request.waiter.hasDeadline) ++timed;
+        slot = std::move(request.waiter);
+        Update(request.socket);
+    }
+
+    void Run() {
+        std::vector<PollEvent> events;
+        std::vector<Request> batch;
+        std::vector<intptr_t> keys;
+        for (;;) {
+            // 有带超时的等待者时 10 ms 检查一次
+            int timeoutMs = (timed > 0 || wakeSocket == kInvalidSocket) ? 10 : -1;
+            events.clear();
+            poller.Wait(timeoutMs, events);
+            for (const PollEvent& ev : events) {
+                if (ev.tag == nullptr) {
+                    DrainWakeSocket(wakeSocket);
+                    continue;
+                }
+                Entry& entry = *static_cast<Entry*>(ev.tag);
+                intptr_t key = static_cast<intptr_t>(entry.socket);
+                if (ev.readable || ev.error) Clear(entry.read, true);
+                if (ev.writable || ev.error) Clear(entry.write, true);
+                Update(key);
+            }
+            Flush();
+
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch.swap(incoming);
+                stop = stopping;
+            }
+            for (auto& request : batch) Apply(request);
+            batch.clear();
+            Flush();
+
+            if (timed > 0) {
+                auto now = CoClock::now();
+                keys.clear();
+                for (auto& item : entries) {
+                    Entry& entry = item.second;
+                    bool changed = false;
+                    for (Waiter* waiter : { &entry.read, &entry.write }) {
+                        if (waiter->handle && waiter->hasDeadline && now >= waiter->deadline) {
+                            Clear(*waiter, false);
+                            changed = true;
+                        }
+                    }
+                    if (changed) keys.push_back(item.first);
+                }
+                for (intptr_t key : keys) Update(key);
+                Flush();
+            }
+            if (stop) break;
+        }
+
+        // 停止时仍在等待的协程当作超时恢复
+        for (auto& item : entries) {
+            Clear(item.second.read, false);
+            Clear(item.second.write, false);
+            poller.Remove(item.second.socket);
+        }
+        entries.clear();
+        Flush();
+    }
+};
+
+} // namespace
+
+const CoContext* CoCurrentContext() {
+    return tlsContext;
+}
+
+CoContext co_detail::CaptureContext() {
+    return tlsContext ? *tlsContext : CoContext();
+}
+
+void CoResume(std::coroutine_handle<> handle, const CoContext& context, int delayMs) {
+    SchedulerOf(context)->PostContinuation(std::make_shared<CoResumeTask>(handle, context), context.taskId,
+        context.priority, delayMs);
+}
+
+void CoSpawn(CoTask<void> task, const CoContext& context, std::function<void(std::exception_ptr)> onDone) {
+    auto handle = task.Release();
+    if (!handle) return;
+    Detach(handle, context, std::move(onDone));
+    CoResume(handle, context);
+}
+
+void CoSyncWait(CoTask<void> task, const CoContext& context) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    std::exception_ptr error;
+    CoSpawn(std::move(task), context, [&](std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = e;
+        done = true;
+        cv.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return done; });
+    if (error) std::rethrow_exception(error);
+}
+
+void CoSocketReady::await_suspend(std::coroutine_handle<> h) {
+    IoWatcher::Instance().Watch(socket, event, timeout, &ready, h, co_detail::CaptureContext());
+}
+
+// ------------------------------------------
+// CoWhenAll
+// ------------------------------------------
+struct CoWhenAll::State {
+    std::atomic<size_t> remaining{ 0 };
+    std::mutex mutex;
+    std::exception_ptr error;
+    std::coroutine_handle<> waiter;
+    CoContext context;
+};
+
+CoWhenAll::CoWhenAll(std::vector<CoTask<void>> t) : tasks(std::move(t)), state(std::make_shared<State>()) {}
+
+bool CoWhenAll::await_suspend(std::coroutine_handle<> h) {
+    // 之后只通过局部变量访问：最后一个子协程可能在本函数返回前就在别的线程上恢复了等待者
+    std::shared_ptr<State> s = state;
+    std::vector<CoTask<void>> children = std::move(tasks);
+    s->waiter = h;
+    s->context = co_detail::CaptureContext();
+    s->remaining.store(children.size() + 1); // 多出的一份在提交完之后才释放
+    for (auto& child : children) {
+        CoSpawn(std::move(child), s->context, [s](std::exception_ptr error) {
+            if (error) {
+                std::lock_guard<std::mutex> lock(s->mutex);
+                if (!s->error) s->error = error;
+            }
+            if (s->remaining.fetch_sub(1) == 1) CoResume(s->waiter, s->context);
+        });
+    }
+    return s->remaining.fetch_sub(1) != 1; // 提交期间已全部结束时不挂起
+}
+
+void CoWhenAll::await_resume() {
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+// ------------------------------------------
+// CoMutex
+// ------------------------------------------
+bool CoMutex::TryLock() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (locked) return false;
+    locked = true;
+    return true;
+}
+
+bool CoMutex::LockAwaiter::await_suspend(std::coroutine_handle<> h) {
+    CoContext context = co_detail::CaptureContext();
+    std::lock_guard<std::mutex> lock(mutex.mutex);
+    if (!mutex.locked) {
+        mutex.locked = true;
+        return false; // 等待期间锁已释放
+    }
+    mutex.waiters.push_back({ h, std::move(context) });
+    return true;
+}
+
+void CoMutex::Unlock() {
+    Waiter next;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (waiters.empty()) {
+            locked = false;
+            return;
+        }
+        next = std::move(waiters.front());
+        waiters.pop_front();
+    }
+    CoResume(next.handle, next.context); // 锁不释放，直接交给它
+}
+
+// ------------------------------------------
+// CoTaskAdapter
+// ------------------------------------------
+void CoTaskAdapter::Execute() {
+    // 各段沿用适配器自己的任务编号，协程中发布的结果归属这个任务
+    CoContext context{ TaskScheduler::GetInstance(), TaskScheduler::CurrentPriority(), inner->GetName(),
+        TaskScheduler::CurrentTaskId() };
+    auto handle = inner->Run().Release();
+    if (!handle) return;
+    std::shared_ptr<ICoTask> keep = inner; // Run 是成员协程，结束前对象必须存活
+    TaskScheduler* scheduler = context.scheduler;
+    std::string name = context.name;
+    Detach(handle, context, [keep, scheduler, name](std::exception_ptr error) {
+        if (error) LogFailure(scheduler, name, error);
+    });
+    RunSlice(handle, context);
+}
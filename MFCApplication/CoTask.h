@@ -0,0 +1,286 @@
+﻿#pragma once
+#include "ITask.h"
+#include "TaskPriority.h"
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TaskScheduler;
+
+// C++20 协程任务：等待定时器、套接字、锁或其他协程时挂起，不占用工作线程；
+// 每次恢复都作为一个普通任务提交给调度器，由线程池中的任意工作线程继续执行。
+// 大量"大部分时间在等待"的任务只需要少数几个线程。
+//
+//   CoTask<void> Poll(Socket s) {
+//       for (;;) {
+//           if (!co_await CoSocketReady(s, CoIoEvent::Readable, std::chrono::seconds(5))) break;
+//           ...                                     // 读取
+//           co_await CoDelay(std::chrono::milliseconds(100));
+//       }
+//   }
+//   CoSpawn(Poll(s), CoContext{ scheduler, TaskPriority::Normal, "Poll" });
+
+// 协程的运行上下文：由哪个调度器恢复、以什么优先级、在指标中记为什么名字、属于哪个任务
+struct CoContext {
+    TaskScheduler* scheduler = nullptr;   // 空表示 TaskScheduler::GetInstance()
+    TaskPriority priority = TaskPriority::Normal;
+    std::string name = "Coroutine";
+    uint64_t taskId = 0;                  // 所属任务的编号，各段都以它执行 (结果按它路由)；0 表示第一次提交时分配
+};
+
+// 当前线程上正在运行的协程的上下文，不在协程中时为 nullptr
+const CoContext* CoCurrentContext();
+
+// 把挂起的协程交回线程池：以 context.taskId 提交一个内部延续 (不写任务日志)，delayMs > 0 时先进入定时器队列
+void CoResume(std::coroutine_handle<> handle, const CoContext& context, int delayMs = 0);
+
+namespace co_detail {
+
+// 当前上下文的副本 (供等待体在挂起时保存)
+CoContext CaptureContext();
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;                  // co_await 本协程的父协程
+    std::exception_ptr error;
+    std::function<void(std::exception_ptr)> onDetachedDone; // 根协程 (CoSpawn) 结束时调用
+    bool detached = false;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    // 结束时：有父协程就直接转过去 (对称转移，不占栈)；根协程则销毁自己并通知
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            PromiseBase& p = h.promise();
+            if (p.continuation) return p.continuation;
+            if (p.detached) {
+                auto done = std::move(p.onDetachedDone);
+                std::exception_ptr error = p.error;
+                h.destroy();
+                if (done) done(error);
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    T Take() { return std::move(*value); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    void return_void() noexcept {}
+    void Take() {}
+};
+
+} // namespace co_detail
+
+// 协程的返回类型。创建后不会自己开始：
+//   co_await task  在当前线程上立即执行子协程，结束后回到等待者，取得返回值或重新抛出异常
+//   CoSpawn(task)  作为独立的根协程交给线程池 (只支持 CoTask<void>)
+template <typename T = void>
+class CoTask {
+public:
+    struct promise_type : co_detail::Promise<T> {
+        CoTask get_return_object() { return CoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    CoTask() = default;
+    CoTask(CoTask&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask() { Reset(); }
+
+    bool Valid() const { return static_cast<bool>(handle); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    T await_resume() {
+        auto& p = handle.promise();
+        if (p.error) std::rethrow_exception(p.error);
+        return p.Take();
+    }
+
+    // 交出协程帧的所有权 (CoSpawn 使用)
+    Handle Release() { return std::exchange(handle, {}); }
+
+private:
+    Handle handle;
+
+    explicit CoTask(Handle h) : handle(h) {}
+    void Reset() {
+        if (handle) {
+            handle.destroy();
+            handle = {};
+        }
+    }
+};
+
+// 启动一个根协程：第一段就作为任务提交给 context 的调度器，调用者不等待
+// onDone 在协程结束时调用 (参数为未捕获的异常，正常结束为空)；为空时异常写入调度器日志
+void CoSpawn(CoTask<void> task, const CoContext& context = CoContext(),
+    std::function<void(std::exception_ptr)> onDone = nullptr);
+
+// 阻塞调用线程直到协程结束，并取得结果 (供 main、基准和非工作线程使用；在工作线程上调用会占住该线程)
+void CoSyncWait(CoTask<void> task, const CoContext& context = CoContext());
+
+template <typename T>
+T CoSyncWait(CoTask<T> task, const CoContext& context = CoContext()) {
+    std::optional<T> result;
+    auto wrapper = [](CoTask<T> inner, std::optional<T>& out) -> CoTask<void> { out.emplace(co_await inner); };
+    CoSyncWait(wrapper(std::move(task), result), context);
+    return std::move(*result);
+}
+
+// ------------------------------------------
+// 等待体
+// ------------------------------------------
+
+// co_await CoDelay(d)：挂起 d，由调度器自己的定时器队列到期后在工作线程上恢复 (毫秒粒度)
+class CoDelay {
+private:
+    int delayMs;
+
+public:
+    explicit CoDelay(std::chrono::milliseconds d)
+        : delayMs(static_cast<int>(d.count() > 0 ? d.count() : 0)) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { CoResume(h, co_detail::CaptureContext(), delayMs); }
+    void await_resume() const noexcept {}
+};
+
+// co_await CoYield()：让出工作线程，重新排队
+inline CoDelay CoYield() { return CoDelay(std::chrono::milliseconds(0)); }
+
+enum class CoIoEvent {
+    Readable,
+    Writable
+};
+
+// co_await CoSocketReady(s, event, timeout)：套接字就绪返回 true，超时返回 false
+// 由一个共享的 I/O 线程监视 (Linux 上为 epoll，见 SocketPoller.h)，就绪后在工作线程上恢复；
+// socket 为平台套接字 (POSIX 的 fd 或 Windows 的 SOCKET)，同一套接字同一方向同时只能有一个等待者
+class CoSocketReady {
+private:
+    intptr_t socket;
+    CoIoEvent event;
+    std::chrono::milliseconds timeout;
+    bool ready = false;
+
+public:
+    CoSocketReady(intptr_t s, CoIoEvent e, std::chrono::milliseconds t = std::chrono::milliseconds(-1))
+        : socket(s), event(e), timeout(t) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h);
+    bool await_resume() const noexcept { return ready; }
+};
+
+// co_await CoWhenAll(std::move(tasks))：子协程作为独立的根协程同时交给线程池，全部结束后恢复等待者
+// 第一个异常在全部结束后重新抛出
+class CoWhenAll {
+private:
+    struct State;
+    std::vector<CoTask<void>> tasks;
+    std::shared_ptr<State> state;
+
+public:
+    explicit CoWhenAll(std::vector<CoTask<void>> t);
+    bool await_ready() const noexcept { return tasks.empty(); }
+    bool await_suspend(std::coroutine_handle<> h);
+    void await_resume();
+};
+
+// 协程互斥锁：拿不到锁时挂起而不是阻塞工作线程；解锁时把锁直接交给最早的等待者并在线程池上恢复它
+//   auto guard = co_await mutex.Lock();
+class CoMutex {
+public:
+    class Guard {
+    private:
+        CoMutex* owner;
+
+    public:
+        explicit Guard(CoMutex* m) : owner(m) {}
+        Guard(Guard&& other) noexcept : owner(std::exchange(other.owner, nullptr)) {}
+        Guard& operator=(Guard&&) = delete;
+        ~Guard() { if (owner) owner->Unlock(); }
+    };
+
+    class LockAwaiter {
+    private:
+        CoMutex& mutex;
+
+    public:
+        explicit LockAwaiter(CoMutex& m) : mutex(m) {}
+        bool await_ready() { return mutex.TryLock(); }
+        bool await_suspend(std::coroutine_handle<> h);
+        Guard await_resume() { return Guard(&mutex); }
+    };
+
+    LockAwaiter Lock() { return LockAwaiter(*this); }
+    bool TryLock();
+    void Unlock();
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        CoContext context;
+    };
+    std::mutex mutex;
+    bool locked = false;
+    std::deque<Waiter> waiters;
+};
+
+// ------------------------------------------
+// 与 ITask 并列的协程任务接口
+// ------------------------------------------
+class ICoTask {
+public:
+    virtual ~ICoTask() = default;
+
+    // 任务逻辑：可以 co_await 上面的等待体和其他 CoTask
+    virtual CoTask<void> Run() = 0;
+
+    virtual std::string GetName() const = 0;
+};
+
+// 对应设计模式：Adapter (适配器)
+// 把 ICoTask 包装成 ITask，照常通过 AddTask / TaskFactory 提交 (也可以是周期任务，每个周期启动一个新协程)；
+// Execute 在当前工作线程上运行到第一次挂起就返回，之后的每一段由调度器以同样的名字和优先级单独执行
+class CoTaskAdapter : public ITask {
+private:
+    std::shared_ptr<ICoTask> inner;
+
+public:
+    explicit CoTaskAdapter(std::shared_ptr<ICoTask> task) : inner(std::move(task)) {}
+    void Execute() override;
+    std::string GetName() const override { return inner->GetName(); }
+};
@@ -1,13 +1,21 @@
 ﻿#pragma once
 #include "ITask.h"
 #include "TaskScheduler.h"
+#include "Gemm.h"
+#include "StreamingStats.h"
+#include "Philox.h"
+#include "BackupEngine.h"
+#include "HttpClient.h"
+#include "TaskResult.h"
 #include <string>
 #include <thread>
 #include <mutex>
 #include <iostream>
 #include <vector>
-#include <sstream>
-#include <iomanip>
+#ifdef _WIN32
+#include <windows.h>
+#include <tchar.h>
+#endif
 
 // ==========================================
 // 1. 全局资源锁 (防死锁演示用)
@@ -17,14 +25,39 @@ static std::mutex g_resourceMutex;
 
 
 // --- 矩阵计算任务 ---
+// 真实的 n × n 单精度矩阵乘法 (见 Gemm.h)，结果以 MatrixResult 发布给界面
+// C 按块拆成子任务交回调度器的线程池 (ParallelFor)，本任务也参与计算并在全部块完成后结束
 class MatrixTask : public ITask {
+private:
+    size_t size;
+
 public:
+    explicit MatrixTask(size_t n = 512) : size(n) {}
+
     std::string GetName() const override { return "Matrix Calc"; }
     void Execute() override {
-        // 简单模拟矩阵计算
-        TaskScheduler::GetInstance()->GetLogger().Write("[Matrix] 正在进行矩阵乘法运算...");
-        std::this_thread::sleep_for(std::chrono::milliseconds(800));
-        TaskScheduler::GetInstance()->GetLogger().Write("[Matrix] 运算完成。结果已生成。");
+        auto* scheduler = TaskScheduler::GetInstance();
+        auto& log = scheduler->GetLogger();
+        log.Write("[Matrix] 正在进行矩阵乘法运算...");
+
+        AlignedMatrix a(size, size), b(size, size), c(size, size);
+        a.FillRandom(1);
+        b.FillRandom(2);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<GemmTile> tiles = GemmPartition(a, b, (std::max)(scheduler->GetWorkerCount(), size_t(1)) * 4);
+        scheduler->ParallelFor(tiles.size(), [&](size_t i) { GemmComputeTile(a, b, c, tiles[i]); }, "Matrix Tile");
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        double gflops = ms > 0.0 ? 2.0 * size * size * size / (ms * 1e6) : 0.0;
+
+        MatrixResult result;
+        result.size = size;
+        result.ms = ms;
+        result.gflops = gflops;
+        result.isa = GemmIsaName(GetGemmIsa());
+        result.tiles = tiles.size();
+        log.Write("[Matrix] 运算完成。" + Describe(result));
+        scheduler->NotifyObservers("[Matrix] 运算完成。" + Describe(result));
+        scheduler->PublishResult(std::move(result));
     }
 };
 
@@ -34,44 +67,141 @@ public:
     std::string GetName() const override { return "Class Reminder"; }
     void Execute() override {
         TaskScheduler::GetInstance()->GetLogger().Write("[Reminder] 检查课程表中...");
+#ifdef _WIN32
         ::MessageBox(NULL, _T("该上课了！\n请检查您的日程安排。"), _T("课堂提醒"), MB_OK | MB_TOPMOST);
+#else
+        // 没有消息框的平台上改为通知观察者
+        TaskScheduler::GetInstance()->NotifyObservers("[Reminder] 该上课了！请检查您的日程安排。");
+#endif
         TaskScheduler::GetInstance()->GetLogger().Write("[Reminder] 提醒已发送。");
     }
 };
 
-// --- 文件备份任务 (修复版：带权限绕过) ---
+// --- 文件备份任务 ---
+// 进程内的并行压缩备份 (见 BackupEngine.h)：不再启动 PowerShell 子进程，
+// 读取与压缩分给线程池，本任务负责遍历调度和按顺序写出 zip
 class BackupTask : public ITask {
+private:
+    std::string source;
+    std::string archive;
+
 public:
+    // archive 为空时写到临时目录下的 scheduler_backup.zip
+    explicit BackupTask(std::string src = ".", std::string dst = "") : source(std::move(src)), archive(std::move(dst)) {}
+
     std::string GetName() const override { return "File Backup"; }
     void Execute() override {
-        auto& log = TaskScheduler::GetInstance()->GetLogger();
-        log.Write("[Backup] 正在启动 PowerShell 备份...");
+        auto* scheduler = TaskScheduler::GetInstance();
+        auto& log = scheduler->GetLogger();
+        log.Write("[Backup] 正在备份 " + source + " ...");
 
-        // 模拟命令，防止报错
-        std::string cmd = "powershell -NoProfile -ExecutionPolicy Bypass -Command \"Write-Host 'Backup Test'\"";
-        system(cmd.c_str());
-
-        log.Write("[Backup] ✅ 备份流程结束。");
+        BackupOptions options;
+        options.source = source;
+        options.archive = archive;
+        BackupResult result = RunBackup(options, *scheduler);
+        if (!result.ok) {
+            log.Write("[Backup] ❌ " + Describe(result));
+            scheduler->NotifyObservers("[Backup] " + Describe(result));
+        }
+        else {
+            log.Write("[Backup] ✅ 备份完成: " + Describe(result));
+            scheduler->NotifyObservers("[Backup] 备份完成: " + Describe(result));
+        }
+        scheduler->PublishResult(std::move(result));
     }
 };
 
-// --- HTTP 任务 (空壳，防止报错) ---
+// --- HTTP 任务 (异步抓取网页并流式保存到文件) ---
+// 请求交给异步 HTTP 客户端 (见 HttpClient.h) 后 Execute 立即返回，等待网络期间不占用工作线程；
+// 响应体边收边写入 savePath，完成后的记录和结果发布作为延续任务回到调度器执行 (结果仍归属本任务的编号)。
+// 客户端不支持 TLS，默认请求本机的替身服务 (./build/HttpBench --serve=8080)
 class HttpTask : public ITask {
+private:
+    std::string url;
+    std::string savePath;
+
 public:
+    explicit HttpTask(std::string u = "http://127.0.0.1:8080/zen", std::string path = "zen.txt")
+        : url(std::move(u)), savePath(std::move(path)) {}
+
     std::string GetName() const override { return "HTTP Request"; }
     void Execute() override {
-        TaskScheduler::GetInstance()->GetLogger().Write("[HTTP] 正在抓取数据...");
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        TaskScheduler::GetInstance()->GetLogger().Write("[HTTP] 数据获取成功。");
+        auto* scheduler = TaskScheduler::GetInstance();
+        scheduler->GetLogger().Write("[HTTP] 正在抓取数据: " + url);
+
+        HttpRequest request;
+        request.url = url;
+        request.saveTo = savePath;
+        std::string path = savePath;
+        uint64_t taskId = TaskScheduler::CurrentTaskId();
+        HttpClient::Shared().Send(std::move(request), *scheduler, [path, taskId](HttpResponse& response) {
+            auto* s = TaskScheduler::GetInstance();
+            HttpFetchResult result;
+            result.ok = response.ok;
+            result.error = response.error;
+            result.status = response.status;
+            result.reason = response.reason;
+            result.savedTo = path;
+            result.bytes = response.bodyBytes;
+            result.ms = response.seconds * 1e3;
+            s->GetLogger().Write(response.ok ? "[HTTP] 数据获取成功。" + Describe(result) : "[HTTP] " + Describe(result));
+            s->NotifyObservers("[HTTP] " + Describe(result));
+            s->PublishResult(std::move(result), taskId);
+        });
     }
 };
 
-// --- 统计任务 (空壳，防止报错) ---
+// --- 统计任务 ---
+// 生成正态分布随机数并做单遍流式统计 (见 StreamingStats.h)：
+// 每个数据块用自己的 Philox 流生成到一个留在 L1 的缓冲区，随即累加，不保留原始数据；
+// 各分片交给线程池并行，最后合并。样本只取决于种子和块编号，与线程数无关
 class StatsTask : public ITask {
+private:
+    uint64_t samples;
+    uint64_t seed;
+
 public:
+    explicit StatsTask(uint64_t n = 4000000, uint64_t s = 20240601) : samples(n), seed(s) {}
+
     std::string GetName() const override { return "Data Stats"; }
     void Execute() override {
-        TaskScheduler::GetInstance()->GetLogger().Write("[Stats] 正在分析数据...");
+        auto* scheduler = TaskScheduler::GetInstance();
+        auto& log = scheduler->GetLogger();
+        log.Write("[Stats] 正在分析数据...");
+
+        const size_t kChunk = 4096;
+        uint64_t chunks = (samples + kChunk - 1) / kChunk;
+        size_t parts = static_cast<size_t>((std::min)(static_cast<uint64_t>(
+            (std::max)(scheduler->GetWorkerCount(), size_t(1)) * 2), (std::max)(chunks, uint64_t(1))));
+        std::vector<StreamingStats> partials(parts);
+        auto start = std::chrono::steady_clock::now();
+        scheduler->ParallelFor(parts, [&](size_t part) {
+            std::vector<double> chunk(kChunk);
+            for (uint64_t c = chunks * part / parts; c < chunks * (part + 1) / parts; ++c) {
+                size_t n = static_cast<size_t>((std::min)(static_cast<uint64_t>(kChunk), samples - c * kChunk));
+                PhiloxStream(seed, c).FillNormal(chunk.data(), n, 50.0, 10.0);
+                partials[part].AddBatch(chunk.data(), n);
+            }
+        }, "Stats Chunk");
+
+        StreamingStats total;
+        for (const auto& partial : partials) total.Merge(partial);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::vector<double> q = total.quantiles.Quantiles({ 0.5, 0.9, 0.99 });
+
+        StatsResult result;
+        result.count = total.moments.Count();
+        result.mean = total.moments.Mean();
+        result.sd = total.moments.StdDev();
+        result.min = total.moments.Min();
+        result.max = total.moments.Max();
+        result.p50 = q[0];
+        result.p90 = q[1];
+        result.p99 = q[2];
+        result.ms = ms;
+        log.Write("[Stats] 分析完成。" + Describe(result));
+        scheduler->NotifyObservers("[Stats] 分析完成。" + Describe(result));
+        scheduler->PublishResult(std::move(result));
     }
 };
 
@@ -134,6 +264,9 @@ public:
         std::lock_guard<std::mutex> lock(g_resourceMutex); // 拿锁
 
         log.Write("[Normal B] 成功拿到锁！");
-        TaskScheduler::GetInstance()->NotifyObservers("[Normal B] [OK] 成功执行！(锁未遗弃)");
+        LockDemoResult result;
+        result.acquired = true;
+        TaskScheduler::GetInstance()->NotifyObservers("[Normal B] [OK] " + Describe(result));
+        TaskScheduler::GetInstance()->PublishResult(result);
     }
 };
\ No newline at end of file
@@ -0,0 +1,273 @@
+﻿#pragma once
+#include "RingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 二进制结构化事件日志
+// 热路径只写定长记录 (时间戳 + 事件类型 + 任务编号 + 名称编号)，不做任何字符串拼接；
+// 任务名称只在第一次出现时登记到旁路的 .names 文件中。
+// 用 Tools/EventLogDecoder 把 .bin 解码为文本或 CSV。
+//
+// 文件格式 (小端)：
+//   文件头 16 字节：magic "SCHEVLOG" | uint32 版本 | uint32 记录大小
+//   之后是连续的 EventRecord
+//   <文件名>.names：每行 "名称编号<TAB>名称"，UTF-8
+
+enum class EventType : uint16_t {
+    TaskAdded = 1,
+    TaskStarted = 2,
+    TaskFinished = 3,
+    TaskFailed = 4,
+    TaskCancelled = 5,
+    TaskRescheduled = 6,
+    SchedulerStarted = 7,
+    SchedulerStopped = 8,
+    TaskStalled = 9
+};
+
+inline const char* EventTypeName(uint16_t type) {
+    switch (static_cast<EventType>(type)) {
+    case EventType::TaskAdded: return "TaskAdded";
+    case EventType::TaskStarted: return "TaskStarted";
+    case EventType::TaskFinished: return "TaskFinished";
+    case EventType::TaskFailed: return "TaskFailed";
+    case EventType::TaskCancelled: return "TaskCancelled";
+    case EventType::TaskRescheduled: return "TaskRescheduled";
+    case EventType::SchedulerStarted: return "SchedulerStarted";
+    case EventType::SchedulerStopped: return "SchedulerStopped";
+    case EventType::TaskStalled: return "TaskStalled";
+    }
+    return "Unknown";
+}
+
+// 定长 24 字节的事件记录
+struct EventRecord {
+    uint64_t timestampNs;  // system_clock 纪元以来的纳秒
+    uint64_t taskId;       // TaskControl::id，调度器级事件为 0
+    uint32_t nameId;       // 登记过的任务名称编号，0 表示无名称
+    uint16_t type;         // EventType
+    uint16_t reserved;
+};
+static_assert(sizeof(EventRecord) == 24, "EventRecord must stay 24 bytes");
+
+struct EventLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+};
+static_assert(sizeof(EventLogHeader) == 16, "EventLogHeader must stay 16 bytes");
+
+static const char kEventLogMagic[8] = { 'S', 'C', 'H', 'E', 'V', 'L', 'O', 'G' };
+static const uint32_t kEventLogVersion = 1;
+
+// 解析 .names 文件中的一行 "名称编号<TAB>名称"
+// 文件可能被截断或手工修改：编号必须是 1..UINT32_MAX 的十进制数字，否则返回 false，由调用者跳过该行
+inline bool ParseEventNameLine(const std::string& line, uint32_t& id, std::string& name) {
+    size_t tab = line.find('\t');
+    if (tab == 0 || tab == std::string::npos || tab > 10) return false;
+    std::string digits = line.substr(0, tab);
+    if (digits.find_first_not_of("0123456789") != std::string::npos) return false;
+    unsigned long long value = std::stoull(digits); // 最多 10 位数字，不会溢出
+    if (value == 0 || value > 0xFFFFFFFFull) return false;
+    id = static_cast<uint32_t>(value);
+    name = line.substr(tab + 1);
+    return true;
+}
+
+// 事件日志写入器：生产者把记录推入无锁环形队列，后台线程成批写出
+// 队列满时丢弃并计数，热路径永远不会阻塞
+class EventLogWriter {
+private:
+    std::ofstream file;
+    std::ofstream namesFile;
+    std::unique_ptr<RingBuffer<EventRecord>> ring;
+    std::thread flusherThread;
+    std::atomic<bool> open;
+    std::atomic<bool> stopFlusher;
+    std::atomic<int> activeProducers;                    // 正在 Record() 中入队的线程数，Close() 等它们离开
+    std::atomic<unsigned long long> pushed;
+    std::atomic<unsigned long long> written;
+    std::atomic<unsigned long long> dropped;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::condition_variable flushedCv;
+
+    std::mutex namesMutex;                               // 只在登记新名称时使用
+    std::unordered_map<std::string, uint32_t> nameIds;
+    uint32_t nextNameId;
+
+    static const size_t kBatchLimit = 4096;
+
+    size_t WriteBatch(std::vector<EventRecord>& batch) {
+        batch.clear();
+        EventRecord record;
+        while (batch.size() < kBatchLimit && ring->TryPop(record)) {
+            batch.push_back(record);
+        }
+        if (!batch.empty()) {
+            file.write(reinterpret_cast<const char*>(batch.data()),
+                static_cast<std::streamsize>(batch.size() * sizeof(EventRecord)));
+            file.flush();
+            written.fetch_add(batch.size());
+        }
+        return batch.size();
+    }
+
+    void FlusherLoop() {
+        std::vector<EventRecord> batch;
+        batch.reserve(kBatchLimit);
+        while (true) {
+            if (WriteBatch(batch) > 0) {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                flushedCv.notify_all();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            flushedCv.notify_all();
+            if (stopFlusher) break;
+            // 热路径不做通知：事件量大时每批都是满的，不会走到这里；量小时按固定节奏检查一次即可
+            wakeCv.wait_for(lock, std::chrono::milliseconds(20), [this] {
+                return stopFlusher.load() || !ring->Empty();
+                });
+        }
+    }
+
+    // 读取已有的 .names 文件，追加模式下名称编号保持一致
+    // 编号不是合法的非零 32 位整数的行 (如上次崩溃时写了一半) 直接跳过
+    void LoadNames(const std::string& namesPath) {
+        std::ifstream in(namesPath);
+        std::string line;
+        uint32_t id = 0;
+        std::string name;
+        while (std::getline(in, line)) {
+            if (!ParseEventNameLine(line, id, name)) continue;
+            nameIds[name] = id;
+            if (id >= nextNameId) nextNameId = id + 1;
+        }
+    }
+
+public:
+    EventLogWriter()
+        : open(false), stopFlusher(false), activeProducers(0), pushed(0), written(0), dropped(0), nextNameId(1) {
+    }
+
+    ~EventLogWriter() {
+        Close();
+    }
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    // 打开 (或追加到) 事件日志文件
+    bool Open(const std::string& path, size_t capacity = 65536) {
+        if (open) return true;
+        LoadNames(path + ".names");
+
+        file.open(path, std::ios::binary | std::ios::app);
+        namesFile.open(path + ".names", std::ios::app);
+        if (!file.is_open() || !namesFile.is_open()) {
+            return false;
+        }
+        if (file.tellp() == std::streampos(0)) {
+            EventLogHeader header;
+            std::memcpy(header.magic, kEventLogMagic, sizeof(header.magic));
+            header.version = kEventLogVersion;
+            header.recordSize = sizeof(EventRecord);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.flush();
+        }
+
+        ring.reset(new RingBuffer<EventRecord>(capacity));
+        stopFlusher = false;
+        flusherThread = std::thread(&EventLogWriter::FlusherLoop, this);
+        open = true;
+        return true;
+    }
+
+    // 写出剩余记录并关闭文件
+    void Close() {
+        if (!open) return;
+        // 先拒绝新记录，再等已在入队途中的生产者离开，此后队列里的就是全部记录
+        open = false;
+        while (activeProducers.load() != 0) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopFlusher = true;
+            wakeCv.notify_one();
+        }
+        if (flusherThread.joinable()) {
+            flusherThread.join();
+        }
+        // 刷盘线程最后一轮之后才入队的记录
+        std::vector<EventRecord> batch;
+        while (WriteBatch(batch) > 0) {
+        }
+        file.close();
+        namesFile.close();
+    }
+
+    bool IsOpen() const { return open.load(std::memory_order_relaxed); }
+
+    // 登记任务名称，返回名称编号 (同名返回同一编号)
+    // 只在提交任务时调用一次，热路径上只传递编号
+    uint32_t Intern(const std::string& name) {
+        std::lock_guard<std::mutex> lock(namesMutex);
+        auto it = nameIds.find(name);
+        if (it != nameIds.end()) return it->second;
+        uint32_t id = nextNameId++;
+        nameIds.emplace(name, id);
+        if (namesFile.is_open()) {
+            namesFile << id << '\t' << name << '\n';
+            namesFile.flush(); // 名称必须先于引用它的记录落盘
+        }
+        return id;
+    }
+
+    // 记录一个事件 (热路径：一次时钟读取 + 一次无锁入队)
+    void Record(EventType type, uint64_t taskId, uint32_t nameId) {
+        if (!IsOpen()) return;
+        // 先登记再确认仍然打开 (均为 seq_cst)：Close() 要么看到这里的登记，要么这里看到已关闭
+        activeProducers.fetch_add(1);
+        if (!open.load()) {
+            activeProducers.fetch_sub(1);
+            return;
+        }
+        EventRecord record;
+        record.timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        record.taskId = taskId;
+        record.nameId = nameId;
+        record.type = static_cast<uint16_t>(type);
+        record.reserved = 0;
+        if (ring->TryPush(record)) {
+            pushed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        activeProducers.fetch_sub(1);
+    }
+
+    // 等待调用前记录的事件全部落盘
+    void Flush() {
+        if (!IsOpen()) return;
+        unsigned long long target = pushed.load();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCv.notify_one();
+        flushedCv.wait(lock, [this, target] { return written.load() >= target || stopFlusher; });
+    }
+
+    unsigned long long GetDroppedCount() const { return dropped; }
+};
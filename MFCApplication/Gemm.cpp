@@ -0,0 +1,340 @@
+﻿#include "Gemm.h"
+#include "GemmKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GEMM_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// ==========================================
+// AlignedMatrix
+// ==========================================
+
+AlignedMatrix::AlignedMatrix(size_t r, size_t c)
+    : rows(r), cols(c), stride((c + 15) / 16 * 16),
+      data(static_cast<float*>(::operator new[]((std::max)(r * stride, size_t(1)) * sizeof(float),
+          std::align_val_t(kAlignment)))) {
+    Fill(0.0f);
+}
+
+void AlignedMatrix::Fill(float value) {
+    std::fill(data.get(), data.get() + rows * stride, value);
+}
+
+void AlignedMatrix::FillRandom(unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < cols; ++c) {
+            At(r, c) = dist(rng);
+        }
+    }
+}
+
+// ==========================================
+// 指令集检测
+// ==========================================
+
+#ifdef GEMM_X86
+static void CpuId(unsigned leaf, unsigned sub, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(sub));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(out[i]);
+#else
+    __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// 操作系统在上下文切换时保存了哪些寄存器状态 (XCR0)
+static unsigned long long XGetBv() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+static GemmIsa CpuIsa() {
+#ifdef GEMM_X86
+    unsigned regs[4];
+    CpuId(0, 0, regs);
+    unsigned maxLeaf = regs[0];
+    if (maxLeaf < 7) return GemmIsa::Scalar;
+
+    CpuId(1, 0, regs);
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool fma = (regs[2] >> 12) & 1;
+    if (!osxsave) return GemmIsa::Scalar;
+    unsigned long long xcr0 = XGetBv();
+    bool ymmState = (xcr0 & 0x6) == 0x6;          // SSE + AVX
+    bool zmmState = (xcr0 & 0xE6) == 0xE6;        // 另加 opmask 与 zmm 高位
+
+    CpuId(7, 0, regs);
+    bool avx2 = (regs[1] >> 5) & 1;
+    bool avx512f = (regs[1] >> 16) & 1;
+
+    if (avx512f && zmmState) return GemmIsa::Avx512;
+    if (avx2 && fma && ymmState) return GemmIsa::Avx2;
+#endif
+    return GemmIsa::Scalar;
+}
+
+const char* GemmIsaName(GemmIsa isa) {
+    switch (isa) {
+    case GemmIsa::Avx512: return "AVX-512";
+    case GemmIsa::Avx2: return "AVX2";
+    default: return "Scalar";
+    }
+}
+
+static bool IsaAvailable(GemmIsa isa, GemmIsa cpu) {
+    switch (isa) {
+    case GemmIsa::Avx512: return cpu == GemmIsa::Avx512 && GemmKernelAvx512() != nullptr;
+    case GemmIsa::Avx2: return cpu != GemmIsa::Scalar && GemmKernelAvx2() != nullptr;
+    default: return true;
+    }
+}
+
+static GemmIsa ClampIsa(GemmIsa wanted) {
+    static const GemmIsa cpu = CpuIsa();
+    for (int level = static_cast<int>(wanted); level > 0; --level) {
+        if (IsaAvailable(static_cast<GemmIsa>(level), cpu)) return static_cast<GemmIsa>(level);
+    }
+    return GemmIsa::Scalar;
+}
+
+GemmIsa DetectGemmIsa() {
+    static const GemmIsa detected = ClampIsa(GemmIsa::Avx512);
+    return detected;
+}
+
+static std::atomic<int> currentIsa(-1);
+
+GemmIsa GetGemmIsa() {
+    int isa = currentIsa.load(std::memory_order_relaxed);
+    return isa < 0 ? DetectGemmIsa() : static_cast<GemmIsa>(isa);
+}
+
+GemmIsa SetGemmIsa(GemmIsa isa) {
+    GemmIsa effective = ClampIsa(isa);
+    currentIsa.store(static_cast<int>(effective), std::memory_order_relaxed);
+    return effective;
+}
+
+// ==========================================
+// 标量微内核 (4 × 8)：不依赖任何扩展指令，编译器仍可自动向量化
+// ==========================================
+
+static void MicroScalar(size_t kc, const float* a, const float* b, float* c, size_t ldc) {
+    const size_t MR = 4, NR = 8;
+    float acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; ++p) {
+        for (size_t i = 0; i < MR; ++i) {
+            float ai = a[i];
+            for (size_t j = 0; j < NR; ++j) {
+                acc[i][j] += ai * b[j];
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+    for (size_t i = 0; i < MR; ++i) {
+        for (size_t j = 0; j < NR; ++j) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+static const GemmKernel kScalarKernel = { 4, 8, MicroScalar };
+
+static const GemmKernel& SelectKernel(GemmIsa isa) {
+    const GemmKernel* kernel = nullptr;
+    if (isa == GemmIsa::Avx512) kernel = GemmKernelAvx512();
+    else if (isa == GemmIsa::Avx2) kernel = GemmKernelAvx2();
+    return kernel ? *kernel : kScalarKernel;
+}
+
+// ==========================================
+// 分块与打包
+// ==========================================
+
+namespace {
+
+// 分块尺寸：KC × NR 的 B 条带留在 L1，MC × KC 的 A 块留在 L2，KC × NC 的 B 面板留在 L3
+const size_t kKC = 256;
+const size_t kMC = 120;       // 会向下取整到 MR 的倍数
+const size_t kNC = 3072;
+const size_t kMaxTile = 12 * 32; // 最大微内核 (AVX-512) 的 MR × NR
+const double kMinTileFlops = 4e6; // 并行划分时每块至少的计算量，再小就不值得一次任务调度
+
+// 打包缓冲区：每个线程一份，只增不减
+class PackBuffer {
+private:
+    struct AlignedDelete {
+        void operator()(float* p) const { ::operator delete[](p, std::align_val_t(AlignedMatrix::kAlignment)); }
+    };
+    std::unique_ptr<float[], AlignedDelete> data;
+    size_t capacity = 0;
+
+public:
+    float* Reserve(size_t count) {
+        if (count > capacity) {
+            data.reset(static_cast<float*>(::operator new[](count * sizeof(float),
+                std::align_val_t(AlignedMatrix::kAlignment))));
+            capacity = count;
+        }
+        return data.get();
+    }
+};
+
+// A 的 mc × kc 块按 mr 行一条打包：每条内按列存放，不足 mr 行的补零
+void PackA(const AlignedMatrix& a, size_t ic, size_t pc, size_t mc, size_t kc, size_t mr, float* dst) {
+    for (size_t ir = 0; ir < mc; ir += mr) {
+        size_t rows = (std::min)(mr, mc - ir);
+        for (size_t p = 0; p < kc; ++p) {
+            size_t i = 0;
+            for (; i < rows; ++i) dst[i] = a.At(ic + ir + i, pc + p);
+            for (; i < mr; ++i) dst[i] = 0.0f;
+            dst += mr;
+        }
+    }
+}
+
+// B 的 kc × nc 面板按 nr 列一条打包：每条内按行存放，不足 nr 列的补零
+void PackB(const AlignedMatrix& b, size_t pc, size_t jc, size_t kc, size_t nc, size_t nr, float* dst) {
+    for (size_t jr = 0; jr < nc; jr += nr) {
+        size_t cols = (std::min)(nr, nc - jr);
+        for (size_t p = 0; p < kc; ++p) {
+            const float* src = b.Row(pc + p) + jc + jr;
+            std::memcpy(dst, src, cols * sizeof(float));
+            std::fill(dst + cols, dst + nr, 0.0f);
+            dst += nr;
+        }
+    }
+}
+
+// 对一个已打包的 mc × nc 区域调用微内核；边缘不足一个寄存器块时先算到临时块再累加
+void MacroKernel(const GemmKernel& k, size_t mc, size_t nc, size_t kc, const float* packedA, const float* packedB,
+    float* c, size_t ldc) {
+    alignas(64) float tile[kMaxTile];
+    for (size_t jr = 0; jr < nc; jr += k.nr) {
+        size_t cols = (std::min)(k.nr, nc - jr);
+        const float* bPanel = packedB + jr * kc;
+        for (size_t ir = 0; ir < mc; ir += k.mr) {
+            size_t rows = (std::min)(k.mr, mc - ir);
+            const float* aPanel = packedA + ir * kc;
+            float* cTile = c + ir * ldc + jr;
+            if (rows == k.mr && cols == k.nr) {
+                k.micro(kc, aPanel, bPanel, cTile, ldc);
+                continue;
+            }
+            std::fill(tile, tile + k.mr * k.nr, 0.0f);
+            k.micro(kc, aPanel, bPanel, tile, k.nr);
+            for (size_t i = 0; i < rows; ++i) {
+                for (size_t j = 0; j < cols; ++j) {
+                    cTile[i * ldc + j] += tile[i * k.nr + j];
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+static size_t RoundUp(size_t value, size_t step) {
+    return (value + step - 1) / step * step;
+}
+
+void GemmComputeTile(const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c, const GemmTile& tile) {
+    for (size_t i = 0; i < tile.rows; ++i) {
+        float* row = c.Row(tile.row + i) + tile.col;
+        std::fill(row, row + tile.cols, 0.0f);
+    }
+    size_t kdim = a.Cols();
+    if (tile.rows == 0 || tile.cols == 0 || kdim == 0) return;
+
+    const GemmKernel& k = SelectKernel(GetGemmIsa());
+    size_t mcBlock = (std::max)(kMC / k.mr, size_t(1)) * k.mr;
+    size_t ncBlock = kNC / k.nr * k.nr;
+
+    static thread_local PackBuffer bufferA, bufferB;
+    float* packedB = bufferB.Reserve(kKC * ncBlock);
+    float* packedA = bufferA.Reserve(mcBlock * kKC);
+
+    size_t rowEnd = tile.row + tile.rows;
+    size_t colEnd = tile.col + tile.cols;
+    for (size_t jc = tile.col; jc < colEnd; jc += ncBlock) {
+        size_t nc = (std::min)(ncBlock, colEnd - jc);
+        for (size_t pc = 0; pc < kdim; pc += kKC) {
+            size_t kc = (std::min)(kKC, kdim - pc);
+            PackB(b, pc, jc, kc, nc, k.nr, packedB);
+            for (size_t ic = tile.row; ic < rowEnd; ic += mcBlock) {
+                size_t mc = (std::min)(mcBlock, rowEnd - ic);
+                PackA(a, ic, pc, mc, kc, k.mr, packedA);
+                MacroKernel(k, mc, nc, kc, packedA, packedB, c.Row(ic) + jc, c.Stride());
+            }
+        }
+    }
+}
+
+// 从整个 C 开始，反复把较长的一边对半切，直到块数够用或每块的计算量太小
+// 块尽量接近正方形：每个块都要重新打包自己那一条 A 和 B，行块数 × B + 列块数 × A 在正方形时最小
+std::vector<GemmTile> GemmPartition(const AlignedMatrix& a, const AlignedMatrix& b, size_t minTiles) {
+    std::vector<GemmTile> tiles;
+    if (a.Cols() != b.Rows()) return tiles;
+    size_t m = a.Rows(), n = b.Cols(), kdim = a.Cols();
+    if (m == 0 || n == 0) return tiles;
+
+    const GemmKernel& k = SelectKernel(GetGemmIsa());
+    size_t rowStep = RoundUp(m, k.mr);
+    size_t colStep = RoundUp(n, k.nr);
+    auto count = [&](size_t rs, size_t cs) { return ((m + rs - 1) / rs) * ((n + cs - 1) / cs); };
+    auto flops = [&](size_t rs, size_t cs) { return 2.0 * rs * cs * kdim; };
+
+    while (count(rowStep, colStep) < minTiles) {
+        size_t halfCols = RoundUp(colStep / 2, k.nr);
+        size_t halfRows = RoundUp(rowStep / 2, k.mr);
+        bool splitCols = colStep >= 2 * k.nr && (colStep >= rowStep || rowStep < 2 * k.mr);
+        bool splitRows = !splitCols && rowStep >= 2 * k.mr;
+        if (splitCols && flops(rowStep, halfCols) >= kMinTileFlops) colStep = halfCols;
+        else if (splitRows && flops(halfRows, colStep) >= kMinTileFlops) rowStep = halfRows;
+        else break;
+    }
+
+    for (size_t row = 0; row < m; row += rowStep) {
+        for (size_t col = 0; col < n; col += colStep) {
+            tiles.push_back(GemmTile{ row, (std::min)(rowStep, m - row), col, (std::min)(colStep, n - col) });
+        }
+    }
+    return tiles;
+}
+
+bool Gemm(const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c) {
+    if (a.Cols() != b.Rows() || c.Rows() != a.Rows() || c.Cols() != b.Cols()) return false;
+    GemmComputeTile(a, b, c, GemmTile{ 0, c.Rows(), 0, c.Cols() });
+    return true;
+}
+
+void GemmReference(const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c) {
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        for (size_t j = 0; j < b.Cols(); ++j) {
+            double sum = 0.0;
+            for (size_t p = 0; p < a.Cols(); ++p) {
+                sum += static_cast<double>(a.At(i, p)) * b.At(p, j);
+            }
+            c.At(i, j) = static_cast<float>(sum);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// 单精度矩阵乘法 (GEMM)：C = A × B，行主序
+// 分块 (按缓存分 KC/MC/NC 三级) + 打包 + 寄存器分块的微内核，
+// 微内核按运行时检测到的指令集选择 AVX-512 / AVX2+FMA / 标量实现
+
+// 64 字节对齐的行主序矩阵，每行补齐到 16 个 float (一条缓存行 / 一个 zmm 寄存器)
+class AlignedMatrix {
+public:
+    static const size_t kAlignment = 64;
+
+    AlignedMatrix() : rows(0), cols(0), stride(0) {}
+    AlignedMatrix(size_t r, size_t c);
+
+    size_t Rows() const { return rows; }
+    size_t Cols() const { return cols; }
+    size_t Stride() const { return stride; }   // 行间距 (元素个数)
+
+    float* Data() { return data.get(); }
+    const float* Data() const { return data.get(); }
+    float* Row(size_t r) { return data.get() + r * stride; }
+    const float* Row(size_t r) const { return data.get() + r * stride; }
+    float& At(size_t r, size_t c) { return data[r * stride + c]; }
+    float At(size_t r, size_t c) const { return data[r * stride + c]; }
+
+    void Fill(float value);
+    // 用固定种子填充 [-1, 1) 的伪随机数，结果可复现
+    void FillRandom(unsigned seed);
+
+private:
+    struct AlignedDelete {
+        void operator()(float* p) const { ::operator delete[](p, std::align_val_t(kAlignment)); }
+    };
+
+    size_t rows;
+    size_t cols;
+    size_t stride;
+    std::unique_ptr<float[], AlignedDelete> data;
+};
+
+enum class GemmIsa {
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+const char* GemmIsaName(GemmIsa isa);
+
+// 当前 CPU 与本次编译都支持的最高指令集
+GemmIsa DetectGemmIsa();
+
+// 当前使用的指令集 (默认为 DetectGemmIsa())；可以强制降级，用于对比和验证
+// 请求的指令集不受支持时退回到可用的最高一级，返回实际生效的值
+GemmIsa GetGemmIsa();
+GemmIsa SetGemmIsa(GemmIsa isa);
+
+// C = A × B；要求 A.Cols() == B.Rows()，C 的尺寸为 A.Rows() × B.Cols()，尺寸不符时返回 false
+bool Gemm(const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c);
+
+// C 的一个矩形块：行 [row, row + rows)，列 [col, col + cols)
+struct GemmTile {
+    size_t row;
+    size_t rows;
+    size_t col;
+    size_t cols;
+};
+
+// 把 C = A × B 划分为互不重叠的块，尽量不少于 minTiles 块 (每块仍保留足够的计算量)
+// 块边界对齐当前微内核的寄存器块；尺寸不符时返回空
+std::vector<GemmTile> GemmPartition(const AlignedMatrix& a, const AlignedMatrix& b, size_t minTiles);
+
+// 只计算 C 的一块 (覆盖写入)；不同的块互不重叠，可以在不同线程上同时计算
+// 调用者负责保证尺寸匹配 (与 GemmPartition 的输入相同)
+void GemmComputeTile(const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c, const GemmTile& tile);
+
+// 逐元素三重循环的参考实现，只用于校验
+void GemmReference(const AlignedMatrix& a, const AlignedMatrix& b, AlignedMatrix& c);
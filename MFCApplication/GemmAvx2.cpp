@@ -0,0 +1,51 @@
+﻿// 本文件单独以 AVX2 + FMA 编译 (-mavx2 -mfma / /arch:AVX2)，只有在运行时检测到支持时才会被调用
+// 不要在这里包含标准库模板：带 AVX 指令的内联实例可能被链接器选给其他翻译单元
+#include "GemmKernels.h"
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+// 6 × 16 微内核：12 个累加寄存器 + 2 个 B 行 + 1 个 A 广播，共 15 个 ymm
+static void MicroAvx2(size_t kc, const float* a, const float* b, float* c, size_t ldc) {
+#define GEMM_LOAD_ROW(i) \
+    __m256 c##i##0 = _mm256_loadu_ps(c + i * ldc); \
+    __m256 c##i##1 = _mm256_loadu_ps(c + i * ldc + 8);
+#define GEMM_FMA_ROW(i) { \
+    __m256 ai = _mm256_broadcast_ss(a + i); \
+    c##i##0 = _mm256_fmadd_ps(ai, b0, c##i##0); \
+    c##i##1 = _mm256_fmadd_ps(ai, b1, c##i##1); }
+#define GEMM_STORE_ROW(i) \
+    _mm256_storeu_ps(c + i * ldc, c##i##0); \
+    _mm256_storeu_ps(c + i * ldc + 8, c##i##1);
+
+    GEMM_LOAD_ROW(0) GEMM_LOAD_ROW(1) GEMM_LOAD_ROW(2)
+    GEMM_LOAD_ROW(3) GEMM_LOAD_ROW(4) GEMM_LOAD_ROW(5)
+    for (size_t p = 0; p < kc; ++p) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+        GEMM_FMA_ROW(0) GEMM_FMA_ROW(1) GEMM_FMA_ROW(2)
+        GEMM_FMA_ROW(3) GEMM_FMA_ROW(4) GEMM_FMA_ROW(5)
+        a += 6;
+        b += 16;
+    }
+    GEMM_STORE_ROW(0) GEMM_STORE_ROW(1) GEMM_STORE_ROW(2)
+    GEMM_STORE_ROW(3) GEMM_STORE_ROW(4) GEMM_STORE_ROW(5)
+
+#undef GEMM_LOAD_ROW
+#undef GEMM_FMA_ROW
+#undef GEMM_STORE_ROW
+}
+
+static const GemmKernel kAvx2Kernel = { 6, 16, MicroAvx2 };
+
+const GemmKernel* GemmKernelAvx2() {
+    return &kAvx2Kernel;
+}
+
+#else
+
+const GemmKernel* GemmKernelAvx2() {
+    return nullptr;
+}
+
+#endif
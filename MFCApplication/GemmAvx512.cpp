@@ -0,0 +1,54 @@
+﻿// 本文件单独以 AVX-512F 编译 (-mavx512f / /arch:AVX512)，只有在运行时检测到支持时才会被调用
+// 不要在这里包含标准库模板：带 AVX-512 指令的内联实例可能被链接器选给其他翻译单元
+#include "GemmKernels.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+// 12 × 32 微内核：24 个累加寄存器 + 2 个 B 行 + 1 个 A 广播，共 27 个 zmm
+static void MicroAvx512(size_t kc, const float* a, const float* b, float* c, size_t ldc) {
+#define GEMM_LOAD_ROW(i) \
+    __m512 c##i##_0 = _mm512_loadu_ps(c + i * ldc); \
+    __m512 c##i##_1 = _mm512_loadu_ps(c + i * ldc + 16);
+#define GEMM_FMA_ROW(i) { \
+    __m512 ai = _mm512_set1_ps(a[i]); \
+    c##i##_0 = _mm512_fmadd_ps(ai, b0, c##i##_0); \
+    c##i##_1 = _mm512_fmadd_ps(ai, b1, c##i##_1); }
+#define GEMM_STORE_ROW(i) \
+    _mm512_storeu_ps(c + i * ldc, c##i##_0); \
+    _mm512_storeu_ps(c + i * ldc + 16, c##i##_1);
+
+    GEMM_LOAD_ROW(0) GEMM_LOAD_ROW(1) GEMM_LOAD_ROW(2) GEMM_LOAD_ROW(3)
+    GEMM_LOAD_ROW(4) GEMM_LOAD_ROW(5) GEMM_LOAD_ROW(6) GEMM_LOAD_ROW(7)
+    GEMM_LOAD_ROW(8) GEMM_LOAD_ROW(9) GEMM_LOAD_ROW(10) GEMM_LOAD_ROW(11)
+    for (size_t p = 0; p < kc; ++p) {
+        __m512 b0 = _mm512_load_ps(b);
+        __m512 b1 = _mm512_load_ps(b + 16);
+        GEMM_FMA_ROW(0) GEMM_FMA_ROW(1) GEMM_FMA_ROW(2) GEMM_FMA_ROW(3)
+        GEMM_FMA_ROW(4) GEMM_FMA_ROW(5) GEMM_FMA_ROW(6) GEMM_FMA_ROW(7)
+        GEMM_FMA_ROW(8) GEMM_FMA_ROW(9) GEMM_FMA_ROW(10) GEMM_FMA_ROW(11)
+        a += 12;
+        b += 32;
+    }
+    GEMM_STORE_ROW(0) GEMM_STORE_ROW(1) GEMM_STORE_ROW(2) GEMM_STORE_ROW(3)
+    GEMM_STORE_ROW(4) GEMM_STORE_ROW(5) GEMM_STORE_ROW(6) GEMM_STORE_ROW(7)
+    GEMM_STORE_ROW(8) GEMM_STORE_ROW(9) GEMM_STORE_ROW(10) GEMM_STORE_ROW(11)
+
+#undef GEMM_LOAD_ROW
+#undef GEMM_FMA_ROW
+#undef GEMM_STORE_ROW
+}
+
+static const GemmKernel kAvx512Kernel = { 12, 32, MicroAvx512 };
+
+const GemmKernel* GemmKernelAvx512() {
+    return &kAvx512Kernel;
+}
+
+#else
+
+const GemmKernel* GemmKernelAvx512() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,18 @@
+﻿#pragma once
+#include <cstddef>
+
+// GEMM 内部接口：各指令集的微内核 (Gemm.cpp 与 GemmAvx2.cpp / GemmAvx512.cpp 共用)
+//
+// 微内核计算 C[mr × nr] += Apanel × Bpanel
+//   a: 打包后的 A 条带，kc 列，每列连续存放 mr 个元素
+//   b: 打包后的 B 条带，kc 行，每行连续存放 nr 个元素 (64 字节对齐)
+//   c: 行主序，行间距 ldc
+struct GemmKernel {
+    size_t mr;
+    size_t nr;
+    void (*micro)(size_t kc, const float* a, const float* b, float* c, size_t ldc);
+};
+
+// 编译器不支持对应指令集时返回 nullptr
+const GemmKernel* GemmKernelAvx2();
+const GemmKernel* GemmKernelAvx512();
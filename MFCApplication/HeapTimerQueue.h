@@ -0,0 +1,63 @@
+﻿#pragma once
+#include "ITimerQueue.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+// 二叉堆定时器 (原 taskQueue 的实现)：插入/弹出 O(log n)
+// 直接在 vector 上维护堆 (std::priority_queue 不开放底层容器，无法压缩失效条目)
+class HeapTimerQueue : public ITimerQueue {
+private:
+    // 使用 std::greater 配合 ScheduledTask 的 operator>，
+    // 确保时间最早的任务排在队首 (Min-Heap)
+    std::vector<ScheduledTask> heap;
+    std::greater<ScheduledTask> later;
+
+public:
+    void Push(ScheduledTask task) override {
+        heap.push_back(std::move(task));
+        std::push_heap(heap.begin(), heap.end(), later);
+    }
+
+    // 批量不小于现有规模时整体重建堆 O(n + m)，否则逐个上浮 O(m log n)
+    void PushBatch(std::vector<ScheduledTask>& tasks) override {
+        bool rebuild = tasks.size() >= heap.size();
+        heap.reserve(heap.size() + tasks.size());
+        for (auto& task : tasks) {
+            heap.push_back(std::move(task));
+            if (!rebuild) std::push_heap(heap.begin(), heap.end(), later);
+        }
+        tasks.clear();
+        if (rebuild) std::make_heap(heap.begin(), heap.end(), later);
+    }
+
+    void PopDue(SchedulerClock::time_point now, std::vector<ScheduledTask>& out) override {
+        while (!heap.empty() && heap.front().executeTime <= now) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            out.push_back(std::move(heap.back()));
+            heap.pop_back();
+        }
+    }
+
+    SchedulerClock::time_point NextExpiry() const override {
+        return heap.front().executeTime;
+    }
+
+    void TakeAll(std::vector<ScheduledTask>& out) override {
+        for (auto& task : heap) {
+            out.push_back(std::move(task));
+        }
+        heap.clear();
+    }
+
+    size_t Purge() override {
+        size_t before = heap.size();
+        heap.erase(std::remove_if(heap.begin(), heap.end(),
+            [](const ScheduledTask& t) { return !t.IsLive(); }), heap.end());
+        std::make_heap(heap.begin(), heap.end(), later);
+        return before - heap.size();
+    }
+
+    bool Empty() const override { return heap.empty(); }
+    size_t Size() const override { return heap.size(); }
+};
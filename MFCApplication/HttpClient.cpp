@@ -0,0 +1,897 @@
+﻿// 套接字头文件必须在任何 <windows.h> 之前 (否则与旧的 winsock.h 冲突)，所以放在最前面
+#include "SocketPoller.h"
+
+#include "HttpClient.h"
+#include "ITask.h"
+#include "TaskScheduler.h"
+#include "Utf8Path.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+using HttpClock = std::chrono::steady_clock;
+
+namespace {
+
+bool EqualsNoCase(const std::string& a, const char* b) {
+    size_t n = std::strlen(b);
+    if (a.size() != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+bool ContainsNoCase(const std::string& text, const char* token) {
+    std::string lower(text);
+    for (auto& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return lower.find(token) != std::string::npos;
+}
+
+std::string Trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+// http://host[:port]/path 拆分；host 可以是 [IPv6]
+struct Target {
+    std::string host;
+    std::string port;
+    std::string path;
+    std::string hostHeader;
+    std::string key;        // 连接池的键 host:port
+};
+
+bool ParseUrl(const std::string& url, Target& out, std::string& error) {
+    const std::string scheme = "http://";
+    if (url.size() < scheme.size() || !EqualsNoCase(url.substr(0, scheme.size()), scheme.c_str())) {
+        error = url.compare(0, 8, "https://") == 0 ? "https is not supported (no TLS): " + url : "not an http:// URL: " + url;
+        return false;
+    }
+    size_t begin = scheme.size();
+    size_t end = url.find_first_of("/?#", begin);
+    if (end == std::string::npos) end = url.size();
+    std::string authority = url.substr(begin, end - begin);
+    if (authority.find('@') != std::string::npos) {
+        error = "credentials in URL are not supported: " + url;
+        return false;
+    }
+
+    std::string port = "80";
+    if (!authority.empty() && authority[0] == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) { error = "bad IPv6 host: " + url; return false; }
+        out.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size()) {
+            if (authority[close + 1] != ':') { error = "bad host: " + url; return false; }
+            port = authority.substr(close + 2);
+        }
+    }
+    else {
+        size_t colon = authority.rfind(':');
+        out.host = authority.substr(0, colon);
+        if (colon != std::string::npos) port = authority.substr(colon + 1);
+    }
+    char* portEnd = nullptr;
+    long portNumber = std::strtol(port.c_str(), &portEnd, 10);
+    if (out.host.empty() || port.empty() || *portEnd != '\0' || portNumber <= 0 || portNumber > 65535) {
+        error = "bad host or port: " + url;
+        return false;
+    }
+    out.port = std::to_string(portNumber);
+    out.hostHeader = authority;
+    out.key = out.host + ":" + out.port;
+
+    size_t fragment = url.find('#', end);
+    out.path = url.substr(end, fragment == std::string::npos ? std::string::npos : fragment - end);
+    if (out.path.empty() || out.path[0] != '/') out.path.insert(0, "/");
+    return true;
+}
+
+std::string SerializeRequest(const HttpRequest& request, const Target& target) {
+    bool hasAgent = false, hasAccept = false, hasLength = false;
+    for (const auto& h : request.headers) {
+        hasAgent |= EqualsNoCase(h.first, "User-Agent");
+        hasAccept |= EqualsNoCase(h.first, "Accept");
+        hasLength |= EqualsNoCase(h.first, "Content-Length");
+    }
+    std::string wire;
+    wire.reserve(256 + request.body.size());
+    wire += request.method + " " + target.path + " HTTP/1.1\r\nHost: " + target.hostHeader + "\r\n";
+    if (!hasAgent) wire += "User-Agent: MFCApplication-Scheduler\r\n";
+    if (!hasAccept) wire += "Accept: */*\r\n";
+    for (const auto& h : request.headers) wire += h.first + ": " + h.second + "\r\n";
+    if (!hasLength && (!request.body.empty() || request.method == "POST" || request.method == "PUT")) {
+        wire += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+    }
+    wire += "\r\n";
+    wire += request.body;
+    return wire;
+}
+
+// ------------------------------------------
+// 增量响应解析：数据按到达的片段喂入，响应体解码后追加到调用者给的缓冲区
+// ------------------------------------------
+class ResponseParser {
+public:
+    enum class Result { NeedMore, Done, Error };
+
+    void Reset(bool headRequest) {
+        state = State::Head;
+        head.clear();
+        line.clear();
+        remaining = 0;
+        received = 0;
+        keepAlive = false;
+        noBody = headRequest;
+    }
+
+    bool Started() const { return received > 0; }
+    bool KeepAlive() const { return keepAlive; }
+
+    Result Feed(const char* data, size_t n, HttpResponse& response, std::string& body, std::string& error) {
+        received += n;
+        size_t pos = 0;
+        while (pos < n) {
+            switch (state) {
+            case State::Head: {
+                size_t searchFrom = head.size() >= 3 ? head.size() - 3 : 0;
+                size_t take = (std::min)(n - pos, kMaxHead - head.size() + 4);
+                head.append(data + pos, take);
+                size_t end = head.find("\r\n\r\n", searchFrom);
+                if (end == std::string::npos) {
+                    pos += take;
+                    if (head.size() > kMaxHead) { error = "response header too large"; return Result::Error; }
+                    break;
+                }
+                // 头部之后多读进来的字节退回去，由后面的状态处理
+                pos += take - (head.size() - (end + 4));
+                head.resize(end + 4);
+                if (!ParseHead(response, error)) return Result::Error;
+                break;
+            }
+            case State::Length: {
+                size_t take = static_cast<size_t>((std::min)(static_cast<uint64_t>(n - pos), remaining));
+                body.append(data + pos, take);
+                pos += take;
+                remaining -= take;
+                if (remaining == 0) state = State::Done;
+                break;
+            }
+            case State::UntilClose:
+                body.append(data + pos, n - pos);
+                pos = n;
+                break;
+            case State::ChunkSize:
+            case State::ChunkEnd:
+            case State::Trailer: {
+                const char* nl = static_cast<const char*>(std::memchr(data + pos, '\n', n - pos));
+                size_t take = nl ? static_cast<size_t>(nl - (data + pos)) + 1 : n - pos;
+                line.append(data + pos, take);
+                pos += take;
+                if (line.size() > 4096) { error = "malformed chunked encoding"; return Result::Error; }
+                if (!nl) break;
+                if (!ParseLine(error)) return Result::Error;
+                break;
+            }
+            case State::ChunkData: {
+                size_t take = static_cast<size_t>((std::min)(static_cast<uint64_t>(n - pos), remaining));
+                body.append(data + pos, take);
+                pos += take;
+                remaining -= take;
+                if (remaining == 0) state = State::ChunkEnd;
+                break;
+            }
+            case State::Done:
+                // 不做流水线，响应之后还有数据说明连接状态不可信，用完即关
+                keepAlive = false;
+                pos = n;
+                break;
+            }
+        }
+        return state == State::Done ? Result::Done : Result::NeedMore;
+    }
+
+    // 对端关闭连接：只有"读到关闭为止"的响应算完整
+    bool FinishOnClose() {
+        if (state == State::UntilClose) state = State::Done;
+        return state == State::Done;
+    }
+
+private:
+    enum class State { Head, Length, UntilClose, ChunkSize, ChunkData, ChunkEnd, Trailer, Done };
+    static const size_t kMaxHead = 64 * 1024;
+
+    State state = State::Head;
+    std::string head;
+    std::string line;
+    uint64_t remaining = 0;
+    uint64_t received = 0;
+    bool keepAlive = false;
+    bool noBody = false;
+
+    bool ParseHead(HttpResponse& response, std::string& error) {
+        size_t eol = head.find("\r\n");
+        std::string status = head.substr(0, eol);
+        if (status.compare(0, 5, "HTTP/") != 0 || status.size() < 12) {
+            error = "malformed status line: " + status.substr(0, 64);
+            return false;
+        }
+        bool http11 = status.compare(5, 3, "1.1") == 0;
+        response.status = std::atoi(status.c_str() + 9);
+        response.reason = status.size() > 13 ? status.substr(13) : std::string();
+        response.headers.clear();
+
+        bool chunked = false, hasLength = false, closeRequested = false, keepAliveRequested = false;
+        uint64_t length = 0;
+        size_t pos = eol + 2;
+        while (pos < head.size()) {
+            size_t next = head.find("\r\n", pos);
+            if (next == pos) break;
+            std::string header = head.substr(pos, next - pos);
+            pos = next + 2;
+            size_t colon = header.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = Trim(header.substr(0, colon));
+            std::string value = Trim(header.substr(colon + 1));
+            if (EqualsNoCase(name, "Transfer-Encoding")) chunked = ContainsNoCase(value, "chunked");
+            else if (EqualsNoCase(name, "Content-Length")) {
+                hasLength = true;
+                length = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (EqualsNoCase(name, "Connection")) {
+                closeRequested = ContainsNoCase(value, "close");
+                keepAliveRequested = ContainsNoCase(value, "keep-alive");
+            }
+            response.headers.emplace_back(std::move(name), std::move(value));
+        }
+        head.clear();
+
+        // 1xx (如 100 Continue) 之后还会有真正的响应
+        if (response.status >= 100 && response.status < 200 && response.status != 101) {
+            state = State::Head;
+            return true;
+        }
+        keepAlive = http11 ? !closeRequested : keepAliveRequested;
+        if (noBody || response.status == 204 || response.status == 304) state = State::Done;
+        else if (chunked) state = State::ChunkSize;
+        else if (hasLength) {
+            remaining = length;
+            state = length == 0 ? State::Done : State::Length;
+        }
+        else {
+            state = State::UntilClose;
+            keepAlive = false;
+        }
+        return true;
+    }
+
+    bool ParseLine(std::string& error) {
+        std::string text = Trim(line);
+        line.clear();
+        if (state == State::ChunkEnd) {
+            if (!text.empty()) { error = "malformed chunked encoding"; return false; }
+            state = State::ChunkSize;
+        }
+        else if (state == State::ChunkSize) {
+            char* end = nullptr;
+            remaining = std::strtoull(text.c_str(), &end, 16);
+            if (end == text.c_str()) { error = "malformed chunk size"; return false; }
+            state = remaining == 0 ? State::Trailer : State::ChunkData;
+        }
+        else if (text.empty()) {
+            state = State::Done; // 尾部头之后的空行
+        }
+        return true;
+    }
+};
+
+// 延续任务：在调度器的工作线程上执行请求的回调
+class HttpContinuationTask : public ITask {
+private:
+    HttpClient::Callback done;
+    HttpResponse response;
+
+public:
+    HttpContinuationTask(HttpClient::Callback cb, HttpResponse r) : done(std::move(cb)), response(std::move(r)) {}
+    void Execute() override { done(response); }
+    std::string GetName() const override { return "HTTP Continuation"; }
+};
+
+} // namespace
+
+// ------------------------------------------
+// 事件循环
+// ------------------------------------------
+struct HttpExchange {
+    HttpRequest request;
+    HttpClient::Callback done;
+    Target target;
+    std::string wire;
+    HttpResponse response;
+    HttpClock::time_point start;
+    HttpClock::time_point deadline;
+    std::ofstream file;
+    std::string partPath;
+    bool retried = false;
+};
+
+struct HttpHostPool;
+
+struct HttpConnection {
+    Socket socket = kInvalidSocket;
+    HttpHostPool* pool = nullptr;
+    bool connecting = false;
+    bool wantWrite = false;
+    bool reused = false;
+    size_t written = 0;
+    std::unique_ptr<HttpExchange> exchange;
+    ResponseParser parser;
+    HttpClock::time_point idleSince;
+};
+
+struct HttpHostPool {
+    Target target;
+    sockaddr_storage address{};
+    socklen_t addressLength = 0;           // 0 表示尚未解析
+    size_t open = 0;
+    std::vector<HttpConnection*> idle;     // 最近放回的在末尾，优先复用
+    std::deque<std::unique_ptr<HttpExchange>> waiting;
+};
+
+class HttpLoop {
+public:
+    explicit HttpLoop(const HttpClientOptions& o);
+    ~HttpLoop();
+
+    // 停止后返回 false，请求交还给调用者
+    bool Submit(std::unique_ptr<HttpExchange>& exchange);
+    void Stop();
+    HttpClientStats Stats() const;
+
+private:
+    HttpClientOptions options;
+    SocketRuntime runtime;                 // Windows 上的 WSAStartup/WSACleanup，须先于套接字构造
+    Poller poller;
+    Socket wakeSocket = kInvalidSocket;    // 连接到自己的回环 UDP 套接字，写一个字节即唤醒
+    std::thread thread;
+
+    std::mutex mutex;                      // 保护 incoming / stopping
+    std::vector<std::unique_ptr<HttpExchange>> incoming;
+    bool stopping = false;
+
+    // 以下只在事件循环线程上访问
+    std::unordered_map<std::string, std::unique_ptr<HttpHostPool>> pools;
+    std::unordered_map<HttpConnection*, std::unique_ptr<HttpConnection>> connections;
+    std::vector<std::unique_ptr<HttpConnection>> closed; // 本轮事件处理完才释放
+    std::vector<char> buffer;
+    std::string scratch;                   // 写文件前的响应体解码缓冲
+    size_t active = 0;                     // 已提交、尚未结束的请求
+
+    std::atomic<uint64_t> requests{ 0 };
+    std::atomic<uint64_t> completed{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+    std::atomic<uint64_t> opened{ 0 };
+    std::atomic<uint64_t> reusedCount{ 0 };
+    std::atomic<uint64_t> retries{ 0 };
+
+    void Run();
+    void Wake();
+    void Start(std::unique_ptr<HttpExchange> exchange);
+    void Open(HttpHostPool& pool, std::unique_ptr<HttpExchange> exchange);
+    void Assign(HttpConnection* conn, std::unique_ptr<HttpExchange> exchange);
+    void OnWritable(HttpConnection* conn);
+    void OnReadable(HttpConnection* conn);
+    void Complete(HttpConnection* conn);
+    void Fail(HttpConnection* conn, const std::string& error);
+    void Retry(HttpConnection* conn);
+    void Close(HttpConnection* conn);
+    void Release(HttpHostPool& pool);
+    void Finish(std::unique_ptr<HttpExchange> exchange, const std::string& error);
+    void Sweep(HttpClock::time_point now);
+    void CancelAll();
+    void SetWantWrite(HttpConnection* conn, bool want);
+};
+
+HttpLoop::HttpLoop(const HttpClientOptions& o) : options(o), buffer(256 * 1024) {
+    if (options.maxConnectionsPerHost == 0) options.maxConnectionsPerHost = 1;
+    if (options.maxIdlePerHost == 0) options.maxIdlePerHost = options.maxConnectionsPerHost;
+    wakeSocket = OpenWakeSocket();
+    if (wakeSocket != kInvalidSocket && !poller.Add(wakeSocket, nullptr, kPollRead)) {
+        CloseSocket(wakeSocket);
+        wakeSocket = kInvalidSocket; // 没有唤醒套接字时事件循环改为短周期轮询
+    }
+    thread = std::thread(&HttpLoop::Run, this);
+}
+
+HttpLoop::~HttpLoop() {
+    Stop();
+    if (wakeSocket != kInvalidSocket) CloseSocket(wakeSocket);
+}
+
+bool HttpLoop::Submit(std::unique_ptr<HttpExchange>& exchange) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return false;
+        incoming.push_back(std::move(exchange));
+    }
+    requests++;
+    Wake();
+    return true;
+}
+
+void HttpLoop::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    Wake();
+    if (thread.joinable()) thread.join();
+}
+
+HttpClientStats HttpLoop::Stats() const {
+    HttpClientStats s;
+    s.requests = requests.load();
+    s.completed = completed.load();
+    s.failed = failed.load();
+    s.connectionsOpened = opened.load();
+    s.connectionsReused = reusedCount.load();
+    s.retries = retries.load();
+    return s;
+}
+
+void HttpLoop::Wake() {
+    if (wakeSocket != kInvalidSocket) SignalWakeSocket(wakeSocket);
+}
+
+void HttpLoop::Run() {
+    std::vector<PollEvent> events;
+    std::vector<std::unique_ptr<HttpExchange>> batch;
+    auto nextSweep = HttpClock::now();
+    for (;;) {
+        // 有请求在途时 50 ms 检查一次超时；只剩空闲连接时 1 s 检查一次过期
+        int timeoutMs = -1;
+        if (active > 0 || wakeSocket == kInvalidSocket) timeoutMs = 50;
+        else if (!connections.empty()) timeoutMs = 1000;
+
+        events.clear();
+        poller.Wait(timeoutMs, events);
+        for (const PollEvent& ev : events) {
+            if (ev.tag == nullptr) {
+                DrainWakeSocket(wakeSocket);
+                continue;
+            }
+            auto* conn = static_cast<HttpConnection*>(ev.tag);
+            if (conn->socket == kInvalidSocket) continue; // 本轮中已被关闭
+            if ((ev.writable || ev.error) && (conn->connecting || conn->wantWrite)) OnWritable(conn);
+            if (conn->socket != kInvalidSocket && (ev.readable || ev.error)) OnReadable(conn);
+        }
+
+        bool stop;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batch.swap(incoming);
+            stop = stopping;
+        }
+        for (auto& exchange : batch) {
+            ++active;
+            Start(std::move(exchange));
+        }
+        batch.clear();
+
+        auto now = HttpClock::now();
+        if (now >= nextSweep) {
+            Sweep(now);
+            nextSweep = now + std::chrono::milliseconds(50);
+        }
+        closed.clear();
+        if (stop) break;
+    }
+    CancelAll();
+}
+
+void HttpLoop::Start(std::unique_ptr<HttpExchange> exchange) {
+    std::string error;
+    if (!ParseUrl(exchange->request.url, exchange->target, error)) {
+        Finish(std::move(exchange), error);
+        return;
+    }
+    if (!exchange->request.saveTo.empty()) {
+        exchange->partPath = exchange->request.saveTo + ".part";
+        exchange->file.open(exchange->partPath, std::ios::binary | std::ios::trunc);
+        if (!exchange->file) {
+            Finish(std::move(exchange), "cannot write " + exchange->partPath);
+            return;
+        }
+    }
+    exchange->wire = SerializeRequest(exchange->request, exchange->target);
+
+    auto& slot = pools[exchange->target.key];
+    if (!slot) {
+        slot.reset(new HttpHostPool());
+        slot->target = exchange->target;
+    }
+    HttpHostPool& pool = *slot;
+    if (!pool.idle.empty()) {
+        HttpConnection* conn = pool.idle.back();
+        pool.idle.pop_back();
+        Assign(conn, std::move(exchange));
+    }
+    else if (pool.open < options.maxConnectionsPerHost) {
+        Open(pool, std::move(exchange));
+    }
+    else {
+        pool.waiting.push_back(std::move(exchange));
+    }
+}
+
+void HttpLoop::Open(HttpHostPool& pool, std::unique_ptr<HttpExchange> exchange) {
+    if (pool.addressLength == 0) {
+        // 域名解析是阻塞调用，每个主机只解析一次；本地端点通常是数字地址，不会真正查询
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(pool.target.host.c_str(), pool.target.port.c_str(), &hints, &result) != 0 || !result) {
+            Finish(std::move(exchange), "cannot resolve host: " + pool.target.host);
+            return;
+        }
+        std::memcpy(&pool.address, result->ai_addr, result->ai_addrlen);
+        pool.addressLength = static_cast<socklen_t>(result->ai_addrlen);
+        freeaddrinfo(result);
+    }
+
+    Socket s = socket(pool.address.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalidSocket) {
+        Finish(std::move(exchange), "socket: " + SocketErrorText(LastSocketError()));
+        return;
+    }
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    bool connecting = false;
+    if (!SetNonBlocking(s)) {
+        CloseSocket(s);
+        Finish(std::move(exchange), "cannot make socket non-blocking");
+        return;
+    }
+    if (connect(s, reinterpret_cast<const sockaddr*>(&pool.address), pool.addressLength) != 0) {
+        int e = LastSocketError();
+        if (!ConnectPending(e)) {
+            CloseSocket(s);
+            Finish(std::move(exchange), "connect " + pool.target.key + ": " + SocketErrorText(e));
+            return;
+        }
+        connecting = true;
+    }
+
+    auto owned = std::make_unique<HttpConnection>();
+    HttpConnection* conn = owned.get();
+    conn->socket = s;
+    conn->pool = &pool;
+    conn->connecting = connecting;
+    conn->wantWrite = true;
+    if (!poller.Add(s, conn, kPollRead | kPollWrite)) {
+        CloseSocket(s);
+        Finish(std::move(exchange), "cannot register socket");
+        return;
+    }
+    connections.emplace(conn, std::move(owned));
+    pool.open++;
+    opened++;
+    Assign(conn, std::move(exchange));
+}
+
+void HttpLoop::Assign(HttpConnection* conn, std::unique_ptr<HttpExchange> exchange) {
+    if (conn->reused) reusedCount++;
+    exchange->response.reusedConnection = conn->reused;
+    conn->parser.Reset(exchange->request.method == "HEAD");
+    conn->written = 0;
+    conn->exchange = std::move(exchange);
+    SetWantWrite(conn, true);
+}
+
+void HttpLoop::SetWantWrite(HttpConnection* conn, bool want) {
+    if (conn->wantWrite == want) return;
+    conn->wantWrite = want;
+    poller.Modify(conn->socket, conn, kPollRead | (want ? kPollWrite : 0));
+}
+
+void HttpLoop::OnWritable(HttpConnection* conn) {
+    if (conn->connecting) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(conn->socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &len);
+        if (err != 0) {
+            Fail(conn, "connect " + conn->pool->target.key + ": " + SocketErrorText(err));
+            return;
+        }
+        conn->connecting = false;
+    }
+    if (!conn->exchange) {
+        SetWantWrite(conn, false);
+        return;
+    }
+    const std::string& wire = conn->exchange->wire;
+    while (conn->written < wire.size()) {
+        auto n = send(conn->socket, wire.data() + conn->written, static_cast<IoSize>(wire.size() - conn->written), kSendFlags);
+        if (n > 0) {
+            conn->written += static_cast<size_t>(n);
+            continue;
+        }
+        int e = LastSocketError();
+        if (n < 0 && WouldBlock(e)) return; // 发送缓冲区满，等下一次可写
+        if (conn->reused && !conn->parser.Started() && !conn->exchange->retried) Retry(conn);
+        else Fail(conn, "send: " + SocketErrorText(e));
+        return;
+    }
+    SetWantWrite(conn, false);
+}
+
+void HttpLoop::OnReadable(HttpConnection* conn) {
+    if (!conn->exchange) {
+        // 空闲连接可读：对端关闭了 keep-alive 连接 (或发来了不该有的数据)
+        HttpHostPool& pool = *conn->pool;
+        Close(conn);
+        Release(pool);
+        return;
+    }
+    HttpExchange& ex = *conn->exchange;
+    // 水平触发，每次事件最多读几轮，避免一个大响应独占事件循环
+    for (int round = 0; round < 4; ++round) {
+        auto n = recv(conn->socket, buffer.data(), static_cast<IoSize>(buffer.size()), 0);
+        if (n > 0) {
+            std::string& sink = ex.file.is_open() ? scratch : ex.response.body;
+            size_t before = sink.size();
+            std::string error;
+            auto result = conn->parser.Feed(buffer.data(), static_cast<size_t>(n), ex.response, sink, error);
+            ex.response.bodyBytes += sink.size() - before;
+            if (ex.file.is_open() && !scratch.empty()) {
+                ex.file.write(scratch.data(), static_cast<std::streamsize>(scratch.size()));
+                scratch.clear();
+                if (!ex.file) {
+                    Fail(conn, "write failed: " + ex.partPath);
+                    return;
+                }
+            }
+            if (result == ResponseParser::Result::Error) { Fail(conn, error); return; }
+            if (result == ResponseParser::Result::Done) { Complete(conn); return; }
+            continue;
+        }
+        if (n == 0) {
+            if (conn->parser.FinishOnClose()) Complete(conn);
+            else if (conn->reused && !conn->parser.Started() && !ex.retried) Retry(conn);
+            else Fail(conn, "connection closed before the response was complete");
+            return;
+        }
+        int e = LastSocketError();
+        if (WouldBlock(e)) return;
+        if (conn->reused && !conn->parser.Started() && !ex.retried) Retry(conn);
+        else Fail(conn, "recv: " + SocketErrorText(e));
+        return;
+    }
+}
+
+void HttpLoop::Complete(HttpConnection* conn) {
+    std::unique_ptr<HttpExchange> exchange = std::move(conn->exchange);
+    HttpHostPool& pool = *conn->pool;
+    bool keep = conn->parser.KeepAlive();
+
+    std::string error;
+    if (exchange->file.is_open()) {
+        exchange->file.close();
+        std::error_code ec;
+        if (exchange->response.status >= 200 && exchange->response.status < 300) {
+            fs::rename(PathFromUtf8(exchange->partPath), PathFromUtf8(exchange->request.saveTo), ec);
+            if (ec) error = "cannot rename " + exchange->partPath + ": " + ec.message();
+        }
+        else {
+            fs::remove(PathFromUtf8(exchange->partPath), ec);
+        }
+    }
+
+    // 连接先回到池中 (或直接接手排队的请求)，再执行回调
+    if (keep) {
+        conn->reused = true;
+        if (!pool.waiting.empty()) {
+            auto next = std::move(pool.waiting.front());
+            pool.waiting.pop_front();
+            Assign(conn, std::move(next));
+        }
+        else if (pool.idle.size() < options.maxIdlePerHost) {
+            conn->idleSince = HttpClock::now();
+            SetWantWrite(conn, false);
+            pool.idle.push_back(conn);
+        }
+        else {
+            Close(conn);
+        }
+    }
+    else {
+        Close(conn);
+        Release(pool);
+    }
+    Finish(std::move(exchange), error);
+}
+
+void HttpLoop::Fail(HttpConnection* conn, const std::string& error) {
+    std::unique_ptr<HttpExchange> exchange = std::move(conn->exchange);
+    HttpHostPool& pool = *conn->pool;
+    Close(conn);
+    if (exchange) Finish(std::move(exchange), error);
+    Release(pool);
+}
+
+// 复用的连接在发出请求前后被对端关闭 (keep-alive 超时)，一个字节都没收到：换新连接重发一次
+void HttpLoop::Retry(HttpConnection* conn) {
+    std::unique_ptr<HttpExchange> exchange = std::move(conn->exchange);
+    HttpHostPool& pool = *conn->pool;
+    Close(conn);
+    retries++;
+    exchange->retried = true;
+    Open(pool, std::move(exchange));
+}
+
+void HttpLoop::Close(HttpConnection* conn) {
+    if (conn->socket == kInvalidSocket) return;
+    poller.Remove(conn->socket);
+    CloseSocket(conn->socket);
+    conn->socket = kInvalidSocket;
+    HttpHostPool& pool = *conn->pool;
+    pool.open--;
+    auto it = std::find(pool.idle.begin(), pool.idle.end(), conn);
+    if (it != pool.idle.end()) pool.idle.erase(it);
+    auto owned = connections.find(conn);
+    if (owned != connections.end()) {
+        closed.push_back(std::move(owned->second));
+        connections.erase(owned);
+    }
+}
+
+// 有连接名额空出来时，为排队的请求开新连接
+void HttpLoop::Release(HttpHostPool& pool) {
+    while (!pool.waiting.empty() && pool.open < options.maxConnectionsPerHost) {
+        auto next = std::move(pool.waiting.front());
+        pool.waiting.pop_front();
+        Open(pool, std::move(next));
+    }
+}
+
+void HttpLoop::Finish(std::unique_ptr<HttpExchange> exchange, const std::string& error) {
+    --active;
+    HttpResponse& response = exchange->response;
+    response.ok = error.empty();
+    response.error = error;
+    response.seconds = std::chrono::duration<double>(HttpClock::now() - exchange->start).count();
+    if (!response.ok && exchange->file.is_open()) {
+        exchange->file.close();
+        std::error_code ec;
+        fs::remove(PathFromUtf8(exchange->partPath), ec);
+    }
+    (response.ok ? completed : failed)++;
+    try {
+        if (exchange->done) exchange->done(response);
+    }
+    catch (...) {
+        // 回调的异常不能打断事件循环
+    }
+}
+
+void HttpLoop::Sweep(HttpClock::time_point now) {
+    std::vector<HttpConnection*> expired;
+    for (auto& entry : connections) {
+        HttpConnection* conn = entry.first;
+        if (conn->exchange ? now >= conn->exchange->deadline : now - conn->idleSince >= options.idleTimeout) {
+            expired.push_back(conn);
+        }
+    }
+    for (HttpConnection* conn : expired) {
+        if (conn->exchange) Fail(conn, "timeout");
+        else {
+            HttpHostPool& pool = *conn->pool;
+            Close(conn);
+            Release(pool);
+        }
+    }
+    for (auto& entry : pools) {
+        auto& waiting = entry.second->waiting;
+        for (auto it = waiting.begin(); it != waiting.end();) {
+            if (now >= (*it)->deadline) {
+                auto exchange = std::move(*it);
+                it = waiting.erase(it);
+                Finish(std::move(exchange), "timeout");
+            }
+            else ++it;
+        }
+    }
+}
+
+void HttpLoop::CancelAll() {
+    std::vector<HttpConnection*> all;
+    for (auto& entry : connections) all.push_back(entry.first);
+    for (HttpConnection* conn : all) {
+        std::unique_ptr<HttpExchange> exchange = std::move(conn->exchange);
+        Close(conn);
+        if (exchange) Finish(std::move(exchange), "cancelled");
+    }
+    for (auto& entry : pools) {
+        while (!entry.second->waiting.empty()) {
+            auto exchange = std::move(entry.second->waiting.front());
+            entry.second->waiting.pop_front();
+            Finish(std::move(exchange), "cancelled");
+        }
+    }
+    std::vector<std::unique_ptr<HttpExchange>> late;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        late.swap(incoming);
+    }
+    for (auto& exchange : late) {
+        ++active;
+        Finish(std::move(exchange), "cancelled");
+    }
+    closed.clear();
+}
+
+// ------------------------------------------
+// HttpClient
+// ------------------------------------------
+std::string HttpResponse::Header(const std::string& name) const {
+    for (const auto& h : headers) {
+        if (EqualsNoCase(h.first, name.c_str())) return h.second;
+    }
+    return std::string();
+}
+
+HttpClient::HttpClient(const HttpClientOptions& options) : loop(new HttpLoop(options)) {}
+
+HttpClient::~HttpClient() = default;
+
+HttpClient& HttpClient::Shared() {
+    static HttpClient client;
+    return client;
+}
+
+void HttpClient::Send(HttpRequest request, Callback done) {
+    auto exchange = std::make_unique<HttpExchange>();
+    exchange->start = HttpClock::now();
+    exchange->deadline = exchange->start + request.timeout;
+    exchange->request = std::move(request);
+    exchange->done = std::move(done);
+    if (!loop->Submit(exchange)) {
+        exchange->response.error = "cancelled";
+        if (exchange->done) exchange->done(exchange->response);
+    }
+}
+
+void HttpClient::Send(HttpRequest request, TaskScheduler& scheduler, Callback done, TaskPriority priority) {
+    TaskScheduler* target = &scheduler;
+    Send(std::move(request), [target, done, priority](HttpResponse& response) {
+        TaskSpec spec;
+        spec.task = std::make_shared<HttpContinuationTask>(done, std::move(response));
+        spec.priority = priority;
+        target->AddTask(spec);
+    });
+}
+
+void HttpClient::Stop() {
+    loop->Stop();
+}
+
+HttpClientStats HttpClient::GetStats() const {
+    return loop->Stats();
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include "TaskPriority.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TaskScheduler;
+class HttpLoop;
+
+// 一次 HTTP/1.1 请求；只支持 http:// (没有 TLS)
+struct HttpRequest {
+    std::string method = "GET";
+    std::string url;                 // http://host[:port]/path
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    std::string saveTo;              // 非空时响应体边收边写入该文件 (先写 .part，2xx 才改名覆盖)
+    std::chrono::milliseconds timeout{ 10000 }; // 从提交到收完响应
+};
+
+struct HttpResponse {
+    bool ok = false;                 // 收到了完整的响应 (不论状态码)
+    std::string error;
+    int status = 0;
+    std::string reason;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;                // saveTo 为空时的响应体
+    uint64_t bodyBytes = 0;          // 解码后的响应体长度 (chunked 已去掉分块头)
+    bool reusedConnection = false;   // 复用了连接池中的 keep-alive 连接
+    double seconds = 0.0;            // 从提交到完成
+
+    // 按名字查找响应头 (不区分大小写)，没有时返回空串
+    std::string Header(const std::string& name) const;
+};
+
+struct HttpClientOptions {
+    size_t maxConnectionsPerHost = 16;  // 超出的请求在该主机的队列中等待空闲连接
+    size_t maxIdlePerHost = 0;          // 空闲时保留的连接数，0 表示与 maxConnectionsPerHost 相同
+    std::chrono::milliseconds idleTimeout{ 30000 };
+};
+
+struct HttpClientStats {
+    uint64_t requests = 0;
+    uint64_t completed = 0;
+    uint64_t failed = 0;
+    uint64_t connectionsOpened = 0;
+    uint64_t connectionsReused = 0;
+    uint64_t retries = 0;            // 复用的连接已被对端关闭，换新连接重发
+};
+
+// 对应设计模式：Reactor (反应器)
+// 异步 HTTP 客户端：一个事件循环线程 (Linux 上为 epoll，其他平台为 poll/WSAPoll) 管理所有非阻塞套接字，
+// Send 只登记请求就返回，等待网络期间不占用调用者 (包括调度器的工作线程)；
+// 按 host:port 维护 keep-alive 连接池，同一主机可以有多条连接、大量请求同时在途
+class HttpClient {
+public:
+    using Callback = std::function<void(HttpResponse&)>;
+
+    explicit HttpClient(const HttpClientOptions& options = HttpClientOptions());
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    // 进程内共享的实例 (HttpTask 使用)，第一次调用时启动
+    static HttpClient& Shared();
+
+    // 线程安全，立即返回；done 在事件循环线程上执行，不能阻塞
+    void Send(HttpRequest request, Callback done);
+
+    // 同上，但 done 作为延续任务提交给调度器，在工作线程上执行
+    void Send(HttpRequest request, TaskScheduler& scheduler, Callback done,
+        TaskPriority priority = TaskPriority::Normal);
+
+    // 停止事件循环，未完成的请求以 "cancelled" 结束 (回调照常执行)；之后的 Send 直接失败
+    void Stop();
+
+    HttpClientStats GetStats() const;
+
+private:
+    std::unique_ptr<HttpLoop> loop;
+};
@@ -0,0 +1,39 @@
+﻿#pragma once
+#include "ScheduledTask.h"
+#include <chrono>
+#include <vector>
+
+// 对应设计模式：Strategy (策略模式)
+// 定时器后端接口：调度器只通过它存取尚未到期的任务，可在二叉堆与时间轮之间切换
+// 实现本身不加锁，由 TaskScheduler 的 queueMutex 保护
+class ITimerQueue {
+public:
+    virtual ~ITimerQueue() = default;
+
+    // 插入一个等待到期的任务
+    virtual void Push(ScheduledTask task) = 0;
+
+    // 批量插入 (AddTasks / 切换后端)，默认逐个 Push；取走 tasks 中的全部元素
+    virtual void PushBatch(std::vector<ScheduledTask>& tasks) {
+        for (auto& task : tasks) {
+            Push(std::move(task));
+        }
+        tasks.clear();
+    }
+
+    // 取出所有 executeTime <= now 的任务，追加到 out 末尾
+    virtual void PopDue(SchedulerClock::time_point now, std::vector<ScheduledTask>& out) = 0;
+
+    // 下一次需要检查的时间点 (不晚于最早任务的到期时间)，队列为空时不应调用
+    virtual SchedulerClock::time_point NextExpiry() const = 0;
+
+    // 取出全部任务 (切换后端时迁移用)
+    virtual void TakeAll(std::vector<ScheduledTask>& out) = 0;
+
+    // 删除所有已取消/已重新调度的失效条目，返回删除的数量
+    // 失效条目过多时由调度器调用，避免长期运行时内存只增不减
+    virtual size_t Purge() = 0;
+
+    virtual bool Empty() const = 0;
+    virtual size_t Size() const = 0;
+};
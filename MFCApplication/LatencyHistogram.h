@@ -0,0 +1,132 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// HDR 风格的对数-线性直方图 (单位：纳秒)
+// 每个 2 的幂区间再等分为 16 个子桶，相对误差约 6%；
+// 0 ~ 2^43 ns (约 2.4 小时) 共 640 个桶，更大的值计入最后一个桶。
+// 记录只是一次下标计算和一次计数自增，没有浮点运算和分支预测不友好的循环。
+namespace LatencyBuckets {
+    static const int kSubBucketBits = 4;
+    static const uint64_t kSubBucketCount = 1ull << kSubBucketBits;
+    static const int kMaxValueBits = 43;
+    static const size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+    static const uint64_t kMaxValue = (1ull << kMaxValueBits) - 1;
+
+    inline int HighestBit(uint64_t v) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, v);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    inline size_t IndexOf(uint64_t v) {
+        if (v > kMaxValue) v = kMaxValue;
+        if (v < kSubBucketCount) return static_cast<size_t>(v);
+        int msb = HighestBit(v);
+        int shift = msb - kSubBucketBits;
+        return static_cast<size_t>((shift + 1) * kSubBucketCount + ((v >> shift) & (kSubBucketCount - 1)));
+    }
+
+    // 桶内最大的值，百分位数按它报告 (与 HdrHistogram 的 highestEquivalentValue 一致)
+    inline uint64_t UpperBound(size_t index) {
+        if (index < kSubBucketCount) return index;
+        uint64_t octave = index / kSubBucketCount;
+        uint64_t sub = index % kSubBucketCount;
+        int shift = static_cast<int>(octave) - 1;
+        return ((kSubBucketCount + sub + 1) << shift) - 1;
+    }
+}
+
+// 直方图快照：普通整数，可以合并、计算百分位数
+struct HistogramSnapshot {
+    std::vector<uint64_t> counts;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+
+    HistogramSnapshot() : counts(LatencyBuckets::kBucketCount, 0), count(0), sum(0), min(UINT64_MAX), max(0) {}
+
+    void Merge(const HistogramSnapshot& other) {
+        for (size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+        count += other.count;
+        sum += other.sum;
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+
+    double Mean() const {
+        return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+    }
+
+    uint64_t Min() const { return count ? min : 0; }
+
+    // p 取 0 ~ 100
+    uint64_t Percentile(double p) const {
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > count) rank = count;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t value = LatencyBuckets::UpperBound(i);
+                return value < max ? value : max;
+            }
+        }
+        return max;
+    }
+};
+
+// 线程私有的直方图分片：只有所属线程写入，其他线程只在合并时读取
+// 单写者不需要 lock 前缀的原子加，读-改-写都用 relaxed 即可，读者最多看到稍旧的计数
+class LatencyHistogram {
+private:
+    std::atomic<uint64_t> counts[LatencyBuckets::kBucketCount];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> min;
+    std::atomic<uint64_t> max;
+
+    static void Bump(std::atomic<uint64_t>& cell, uint64_t delta) {
+        cell.store(cell.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+public:
+    LatencyHistogram() : count(0), sum(0), min(UINT64_MAX), max(0) {
+        for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(uint64_t valueNs) {
+        Bump(counts[LatencyBuckets::IndexOf(valueNs)], 1);
+        Bump(sum, valueNs);
+        if (valueNs < min.load(std::memory_order_relaxed)) min.store(valueNs, std::memory_order_relaxed);
+        if (valueNs > max.load(std::memory_order_relaxed)) max.store(valueNs, std::memory_order_relaxed);
+        Bump(count, 1);
+    }
+
+    void MergeInto(HistogramSnapshot& out) const {
+        for (size_t i = 0; i < LatencyBuckets::kBucketCount; ++i) {
+            out.counts[i] += counts[i].load(std::memory_order_relaxed);
+        }
+        out.count += count.load(std::memory_order_relaxed);
+        out.sum += sum.load(std::memory_order_relaxed);
+        uint64_t lo = min.load(std::memory_order_relaxed);
+        uint64_t hi = max.load(std::memory_order_relaxed);
+        if (lo < out.min) out.min = lo;
+        if (hi > out.max) out.max = hi;
+    }
+};
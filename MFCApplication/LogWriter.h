@@ -1,18 +1,133 @@
 #pragma once
+#include "RingBuffer.h"
+#include "SegmentedLog.h"
 #include <fstream>
 #include <string>
 #include <mutex>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+
+// 첽ģʽ¶дʱĴʽ
+enum class LogOverflowPolicy {
+    Block,       // ߵȴˢ߳ڳռ (־)
+    DropOldest,  // ɵһµ
+    CountDrops   // ǰֻ
+};
 
 // RAII װļд룬򿪡Զر [cite: 206]
+// Ĭͬд룻EnableAsync() ֻϢζУ
+// ɶˢ߳дÿֻһϵͳ
 class LogWriter {
 private:
+    std::string filename;
     std::ofstream logFile;
-    std::mutex mtx; // ֤߳д밲ȫ
+    std::mutex mtx; // ֤߳д밲ȫ (ͬģʽˢʱʹ)
+
+    // תΪдڴӳķֶļ׷ֻ memcpy
+    std::unique_ptr<SegmentedLogFile> segments;
+
+    // ---- 첽ģʽ ----
+    std::unique_ptr<RingBuffer<std::string>> ring;
+    std::atomic<bool> asyncEnabled;
+    LogOverflowPolicy overflowPolicy;
+    std::thread flusherThread;
+    std::atomic<bool> stopFlusher;
+
+    std::mutex wakeMutex;                  // ֻˢ߳/
+    std::condition_variable wakeCv;        // ˢ߳
+    std::condition_variable flushedCv;     // ֪ͨ Flush() ĵȴ
+    std::atomic<bool> flusherSleeping;     // ˢ߳Ƿߣֻڴʱ֪ͨ ( wakeMutex )
+    std::atomic<bool> flusherRunning;
+    std::atomic<int> activeProducers;      // 첽дStop() 뿪һſ
+
+    std::atomic<unsigned long long> pushed;    // ɹӵ
+    std::atomic<unsigned long long> consumed;  // д""Ƴ
+    std::atomic<unsigned long long> dropped;   // 
+
+    static const size_t kBatchLimit = 4096;    // 
+
+    // ˢ߳ (ʱ)
+    //  FlusherLoop еդԣҪô￴ flusherSleepingҪôˢ߳˯ǰзǿ
+    void WakeFlusher() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (flusherSleeping.load()) {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            wakeCv.notify_one();
+        }
+    }
+
+    // ȡһϢƴһһд
+    size_t WriteBatch(std::string& buffer) {
+        std::string message;
+        size_t count = 0;
+        buffer.clear();
+        while (count < kBatchLimit && ring->TryPop(message)) {
+            buffer += message;
+            buffer += '\n';
+            ++count;
+        }
+        if (count > 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (segments) {
+                segments->Append(buffer.data(), buffer.size());
+            }
+            else if (logFile.is_open()) {
+                logFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                logFile.flush();
+            }
+            consumed.fetch_add(count);
+        }
+        return count;
+    }
+
+    // ˢ̣߳ݾͳдûо
+    void FlusherLoop() {
+        std::string buffer;
+        while (true) {
+            if (WriteBatch(buffer) > 0) {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                flushedCv.notify_all();
+                continue;
+            }
+            if (stopFlusher.load()) {
+                break; // ѿյֹͣ
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            flushedCv.notify_all();
+            // ߣٸУ֮ӵһῴ־֪ͨᶪʧ
+            flusherSleeping = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wakeCv.wait(lock, [this] {
+                return stopFlusher.load() || !ring->Empty();
+                });
+            flusherSleeping = false;
+        }
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        flusherRunning = false;
+        flushedCv.notify_all();
+    }
+
+    void WriteSync(const std::string& message) {
+        std::lock_guard<std::mutex> lock(mtx); // Զ
+        if (segments) {
+            segments->Append(message.data(), message.size());
+            segments->Append("\n", 1);
+        }
+        else if (logFile.is_open()) {
+            logFile << message << std::endl;
+        }
+    }
 
 public:
     // 캯ļ
-    LogWriter(const std::string& filename) {
+    LogWriter(const std::string& filename)
+        : filename(filename), asyncEnabled(false), overflowPolicy(LogOverflowPolicy::Block), stopFlusher(false),
+          flusherSleeping(false), flusherRunning(false), activeProducers(0), pushed(0), consumed(0), dropped(0) {
         // ios::app ʾ׷ģʽ (append)
         logFile.open(filename, std::ios::app);
         if (!logFile.is_open()) {
@@ -21,18 +136,125 @@ public:
         }
     }
 
-    // رļ (RAII )
+    // Ȱ첽е־ȫдٹرļ (RAII )
     ~LogWriter() {
+        Stop();
+        segments.reset(); // ضϲرյǰֶ
         if (logFile.is_open()) {
             logFile.close();
         }
     }
 
-    // д־ķ
-    void Write(const std::string& message) {
-        std::lock_guard<std::mutex> lock(mtx); // Զ
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    // ðС/ʱתķֶ־ (ֶ scheduler_log.000001.txt)
+    // ԭĵ־ļ׷
+    bool EnableRotation(const LogRotationOptions& options = LogRotationOptions()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (segments) return true;
+        std::unique_ptr<SegmentedLogFile> file(new SegmentedLogFile(filename, options));
+        if (!file->IsOpen()) {
+            std::cerr << "Failed to create log segment for: " << filename << std::endl;
+            return false;
+        }
+        segments = std::move(file);
         if (logFile.is_open()) {
-            logFile << message << std::endl;
+            logFile.close();
+        }
+        return true;
+    }
+
+    // л첽ģʽ
+    // capacity: ζpolicy: дʱĴʽ
+    void EnableAsync(size_t capacity = 8192, LogOverflowPolicy policy = LogOverflowPolicy::Block) {
+        if (asyncEnabled) return;
+        if (!ring) {
+            ring.reset(new RingBuffer<std::string>(capacity)); // ʱԭ
+        }
+        overflowPolicy = policy;
+        stopFlusher = false;
+        flusherRunning = true;
+        flusherThread = std::thread(&LogWriter::FlusherLoop, this);
+        asyncEnabled = true;
+    }
+
+    // д־ķ
+    void Write(std::string message) {
+        // ȵǼټģʽ (Ϊ seq_cst)Stop() ر첽ģʽҪôĵǼǣҪô￴ѹر
+        activeProducers.fetch_add(1);
+        if (!asyncEnabled.load()) {
+            activeProducers.fetch_sub(1);
+            WriteSync(message);
+            return;
+        }
+
+        while (!ring->TryPush(message)) {
+            if (overflowPolicy == LogOverflowPolicy::CountDrops) {
+                dropped.fetch_add(1);
+                activeProducers.fetch_sub(1);
+                return;
+            }
+            if (overflowPolicy == LogOverflowPolicy::DropOldest) {
+                std::string oldest;
+                if (ring->TryPop(oldest)) {
+                    consumed.fetch_add(1);
+                    dropped.fetch_add(1);
+                }
+                continue;
+            }
+            // Blockߴˢ̣߳óʱƬ
+            WakeFlusher();
+            std::this_thread::yield();
         }
+        pushed.fetch_add(1);
+        WakeFlusher();
+        activeProducers.fetch_sub(1);
     }
-};
\ No newline at end of file
+
+    // ȴǰд־ȫ (ͬģʽֻˢļ)
+    void Flush() {
+        if (!asyncEnabled) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (segments) segments->Sync();
+            if (logFile.is_open()) logFile.flush();
+            return;
+        }
+        unsigned long long target = pushed.load();
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCv.notify_one();
+        flushedCv.wait(lock, [this, target] {
+            return consumed.load() >= target || !flusherRunning.load();
+            });
+    }
+
+    // дʣ־ֹͣˢ̣֮߳صͬģʽ
+    void Stop() {
+        if (!asyncEnabled) return;
+        // ȹر첽ģʽ߸Ϊͬдٵ;ϡ
+        // ˢ̴߳ʱУBlock ģʽµȴռ߲Ῠ
+        asyncEnabled = false;
+        while (activeProducers.load() != 0) {
+            WakeFlusher();
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopFlusher = true;
+            wakeCv.notify_one();
+        }
+        if (flusherThread.joinable()) {
+            flusherThread.join();
+        }
+
+        // ˢ߳һ֮ӵ־ͬд (˺󲻻)
+        std::string buffer;
+        while (WriteBatch(buffer) > 0) {
+        }
+    }
+
+    bool IsAsync() const { return asyncEnabled; }
+
+    // д־
+    unsigned long long GetDroppedCount() const { return dropped; }
+};
@@ -6,6 +6,7 @@
 #include "framework.h"
 #include "MFCApplication.h"
 #include "MFCApplicationDlg.h"
+#include "TaskScheduler.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -71,6 +72,14 @@ BOOL CMFCApplicationApp::InitInstance()
 	// 例如修改为公司或组织名
 	SetRegistryKey(_T("应用程序向导生成的本地应用程序"));
 
+	// 调度器日志按大小/时间轮转，改为异步批量写出，任务线程不再为每行日志等待磁盘
+	TaskScheduler::GetInstance()->GetLogger().EnableRotation();
+	TaskScheduler::GetInstance()->GetLogger().EnableAsync();
+	// 界面通知改由投递线程成批回调，工作线程不再等待界面；同一批中重复的 "[Running]" 状态只显示最新一条
+	TaskScheduler::GetInstance()->GetObserverHub().EnableAsync();
+	// 每 10 秒把各类任务的排队延迟/执行耗时/吞吐导出为 JSON
+	TaskScheduler::GetInstance()->GetMetrics().StartPeriodicDump("scheduler_metrics.json", std::chrono::seconds(10));
+
 	CMFCApplicationDlg dlg;
 	m_pMainWnd = &dlg;
 	INT_PTR nResponse = dlg.DoModal();
@@ -96,6 +105,13 @@ BOOL CMFCApplicationApp::InitInstance()
 		delete pShellManager;
 	}
 
+	// 退出前先停止调度器 (工作线程、定时线程、看门狗)，再停止投递线程，
+	// 最后写出最终的指标快照和异步日志队列中剩余的内容；顺序反过来会有线程往已停止的日志里写
+	TaskScheduler::GetInstance()->Stop();
+	TaskScheduler::GetInstance()->GetObserverHub().Stop();
+	TaskScheduler::GetInstance()->GetMetrics().StopPeriodicDump();
+	TaskScheduler::GetInstance()->GetLogger().Stop();
+
 #if !defined(_AFXDLL) && !defined(_AFX_NO_MFC_CONTROLS_IN_DIALOGS)
 	ControlBarCleanUp();
 #endif
@@ -8,6 +8,7 @@
 #include "MFCApplicationDlg.h"
 #include "TaskScheduler.h"
 #include "TaskFactory.h"
+#include "TaskGraph.h"
 #include "afxdialogex.h"
 
 #ifdef _DEBUG
@@ -73,12 +74,13 @@ BEGIN_MESSAGE_MAP(CMFCApplicationDlg, CDialogEx)
 	ON_WM_SYSCOMMAND()
 	ON_WM_PAINT()
 	ON_WM_QUERYDRAGICON()
+	ON_WM_DESTROY()
+	ON_WM_TIMER()
 	ON_BN_CLICKED(IDC_BTN_START, &CMFCApplicationDlg::OnBnClickedBtnStart)
 	ON_BN_CLICKED(IDC_BTN_MATRIX, &CMFCApplicationDlg::OnBnClickedBtnMatrix)
 	ON_BN_CLICKED(IDC_BTN_REMIND, &CMFCApplicationDlg::OnBnClickedBtnRemind)
 	ON_BN_CLICKED(IDC_BTN_STATS, &CMFCApplicationDlg::OnBnClickedBtnStats)
 	ON_BN_CLICKED(IDC_BTN_HTTP, &CMFCApplicationDlg::OnBnClickedBtnHttp)
-	ON_MESSAGE(WM_UPDATE_LOG, &CMFCApplicationDlg::OnUpdateLog)
 	ON_BN_CLICKED(IDC_BTN_BACKUP, &CMFCApplicationDlg::OnBnClickedBtnBackup)
 	ON_BN_CLICKED(IDC_BTN_TEST_BAD, &CMFCApplicationDlg::OnBnClickedBtnTestBad)
 	ON_BN_CLICKED(IDC_BTN_TEST_GOOD, &CMFCApplicationDlg::OnBnClickedBtnTestGood)
@@ -117,17 +119,24 @@ BOOL CMFCApplicationDlg::OnInitDialog()
 	SetIcon(m_hIcon, FALSE);		// 设置小图标
 
     TODO:
-	TaskScheduler::GetInstance()->AttachObserver(this);
+	TaskScheduler::GetInstance()->AttachObserver(&m_logSink);
+	m_resultToken = TaskScheduler::GetInstance()->GetResults().Subscribe([this](const TaskResult& result) {
+		TaskResult item = result;
+		while (!m_results.TryPush(item)) {
+			TaskResult oldest;
+			m_results.TryPop(oldest); // 积压时只保留最新的结果
+		}
+	});
+	SetTimer(kLogTimerId, kLogFrameMs, nullptr);
 	return TRUE;  // 除非将焦点设置到控件，否则返回 TRUE
 }
-void CMFCApplicationDlg::OnLogUpdate(const std::string& message)
+void CMFCApplicationDlg::OnDestroy()
 {
-	// 注意：这里是在后台线程被调用的，不能直接更新 UI 控件！
-	// 必须把消息复制一份，发送给主线程处理
-
-	// 动态分配字符串，传给主线程（记得在主线程释放）
-	std::string* pMsg = new std::string(message);
-	PostMessage(WM_UPDATE_LOG, 0, (LPARAM)pMsg);
+	// 窗口销毁后不能再收到通知：Detach 返回时正在进行的回调都已结束
+	KillTimer(kLogTimerId);
+	TaskScheduler::GetInstance()->DetachObserver(&m_logSink);
+	TaskScheduler::GetInstance()->GetResults().Unsubscribe(m_resultToken);
+	CDialogEx::OnDestroy();
 }
 void CMFCApplicationDlg::OnSysCommand(UINT nID, LPARAM lParam)
 {
@@ -193,8 +202,14 @@ void CMFCApplicationDlg::OnBnClickedBtnMatrix()
 	// 使用工厂创建任务
 	auto task = TaskFactory::CreateTask("Matrix");
 	if (task) {
-		// 添加到调度器：延迟 0ms 执行，非周期
-		TaskScheduler::GetInstance()->AddTask(task, 0,true,5000);
+		// 添加到调度器：延迟 0ms 执行，周期 5000ms
+		// 后台计算任务使用低优先级，到期任务积压时让位给界面提醒
+		TaskSpec spec;
+		spec.task = task;
+		spec.periodic = true;
+		spec.intervalMs = 5000;
+		spec.priority = TaskPriority::Low;
+		TaskScheduler::GetInstance()->AddTask(spec);
 		
 	}
 }
@@ -205,54 +220,77 @@ void CMFCApplicationDlg::OnBnClickedBtnRemind()
 	if (task) {
 		// 添加到调度器：延迟 1000ms 执行，周期性 true，间隔 5000ms (5秒)
 		// 这样每隔 5 秒就会弹出一个窗口
-		TaskScheduler::GetInstance()->AddTask(task, 1000, true, 2000);
+		// 面向用户的提醒使用高优先级，到期后 200ms 内应开始执行
+		TaskSpec spec;
+		spec.task = task;
+		spec.delayMs = 1000;
+		spec.periodic = true;
+		spec.intervalMs = 2000;
+		spec.priority = TaskPriority::High;
+		spec.deadlineMs = 200;
+		TaskScheduler::GetInstance()->AddTask(spec);
 		
 	}
 }
-LRESULT CMFCApplicationDlg::OnUpdateLog(WPARAM wParam, LPARAM lParam)
+// 日志帧：后台线程只往 m_logSink 里推消息，这里每帧取出一整批，列表框只重绘一次
+void CMFCApplicationDlg::OnTimer(UINT_PTR nIDEvent)
 {
-	std::string* pMsg = (std::string*)lParam;
-	if (!pMsg) return 0;
-	std::string msg = *pMsg;
-
+	if (nIDEvent != kLogTimerId) {
+		CDialogEx::OnTimer(nIDEvent);
+		return;
+	}
 
-	// 1. 常规日志显示 (保留)
+	// 1. 常规日志显示：先删掉超出上限的最旧行，再追加本帧的新行
 	CListBox* pList = (CListBox*)GetDlgItem(IDC_LIST_LOG);
-	if (pList) {
-		CString strMsg = CA2T(msg.c_str());
-		int nIndex = pList->AddString(strMsg);
-		pList->SetCurSel(nIndex);
+	if (pList && m_logSink.PollFrame(m_logFrame)) {
+		pList->SetRedraw(FALSE);
+		for (size_t i = 0; i < m_logFrame.evict; ++i) {
+			pList->DeleteString(0);
+		}
+		for (const std::string& line : m_logFrame.lines) {
+			pList->AddString(CString(CA2T(line.c_str())));
+		}
+		pList->SetCurSel(pList->GetCount() - 1);
+		pList->SetRedraw(TRUE);
+		pList->Invalidate();
 	}
 
-	// 2. ★★★ 结果可视化逻辑 (解析数据并上屏) ★★★
-	CString strFullMsg = CA2T(msg.c_str());
-
-	// 检查是不是矩阵数据
-	if (msg.find("[DATA-MATRIX]") != std::string::npos) {
-		// 去掉前缀，只显示后面的内容
-		m_resMatrix = strFullMsg.Mid(13); // 13 是 "[DATA-MATRIX] " 的长度
-		UpdateData(FALSE); // 刷新界面
-	}
-	// 检查是不是HTTP数据
-	else if (msg.find("[DATA-HTTP]") != std::string::npos) {
-		m_resHttp = strFullMsg.Mid(11);
-		UpdateData(FALSE);
+	// 2. 结果可视化：整帧只刷新一次界面
+	bool resultChanged = false;
+	bool demoPassed = false;
+	TaskResult result;
+	while (m_results.TryPop(result)) {
+		ShowResult(result, resultChanged, demoPassed);
 	}
-	// 检查是不是统计数据
-	else if (msg.find("[DATA-STATS]") != std::string::npos) {
-		m_resStats = strFullMsg.Mid(12);
-		UpdateData(FALSE);
-	}
-	
-	if (msg.find("证明上一个任务虽崩但未死锁") != std::string::npos) {
-		// 只有在防死锁成功时，才会弹出这个框
+	if (resultChanged) UpdateData(FALSE);
+	if (demoPassed) {
+		// 只有在防死锁成功时，才会弹出这个框 (放在最后：消息框的模态循环里定时器还会触发)
 		::MessageBox(NULL,
 			_T("演示成功！\n\n尽管前一个任务发生了“崩溃异常”，\n但 RAII 机制自动清理了现场，\n后续任务得以正常运行！"),
 			_T("防死锁验证通过"),
 			MB_OK | MB_ICONINFORMATION);
 	}
-	delete pMsg;
-	return 0;
+}
+
+// ★★★ 结果可视化逻辑：按结果类型直接取字段上屏，不解析日志文本 ★★★
+void CMFCApplicationDlg::ShowResult(const TaskResult& result, bool& resultChanged, bool& demoPassed)
+{
+	if (const auto* matrix = std::get_if<MatrixResult>(&result.value)) {
+		m_resMatrix = CA2T(Describe(*matrix).c_str());
+		resultChanged = true;
+	}
+	else if (const auto* http = std::get_if<HttpFetchResult>(&result.value)) {
+		m_resHttp = CA2T(Describe(*http).c_str());
+		resultChanged = true;
+	}
+	else if (const auto* stats = std::get_if<StatsResult>(&result.value)) {
+		m_resStats = CA2T(Describe(*stats).c_str());
+		resultChanged = true;
+	}
+	else if (const auto* demo = std::get_if<LockDemoResult>(&result.value)) {
+		// 普通任务在崩溃任务之后拿到了锁：证明上一个任务虽崩但未死锁
+		demoPassed = demoPassed || demo->acquired; // 同一帧里有多条结果时，任意一条成功即可
+	}
 }
 
 void CMFCApplicationDlg::OnBnClickedBtnStats()
@@ -294,19 +332,27 @@ void CMFCApplicationDlg::OnBnClickedBtnBackup()
 		// 我们设置延迟 3秒 (3000ms) 执行，体现 "Delayed" 的特性
 		TaskScheduler::GetInstance()->AddTask(task, 0);
 
-		AfxMessageBox(_T("备份任务已添加在E:\\请查看。\n请确保 C:\\Data 文件夹存在！"));
+		AfxMessageBox(_T("备份任务已添加：压缩当前工作目录，归档写入临时目录下的 scheduler_backup.zip。"));
 	}
 }
 void CMFCApplicationDlg::OnBnClickedBtnTestBad()
 {
 	// 必须匹配 TaskFactory 里的字符串 "Crash" 和 "Normal"
-	TaskScheduler::GetInstance()->AddTask(TaskFactory::CreateTask("Crash"), 2);
-	TaskScheduler::GetInstance()->AddTask(TaskFactory::CreateTask("Normal"), 2);
+	// 用依赖图保证 Normal 在 Crash 结束 (抛出异常) 之后才执行，不再依赖相同的延迟碰运气
+	TaskGraph graph;
+	TaskGraph::NodeId crash = graph.AddNode(TaskFactory::CreateTask("Crash"));
+	TaskGraph::NodeId normal = graph.AddNode(TaskFactory::CreateTask("Normal"));
+	graph.Precede(crash, normal, DependencyKind::OnCompletion);
+	graph.Submit(*TaskScheduler::GetInstance());
 }
 
 void CMFCApplicationDlg::OnBnClickedBtnTestGood()
 {
 	// 必须匹配 TaskFactory 里的字符串 "SafeCrash" 和 "Normal"
-	TaskScheduler::GetInstance()->AddTask(TaskFactory::CreateTask("SafeCrash"), 2);
-	TaskScheduler::GetInstance()->AddTask(TaskFactory::CreateTask("Normal"), 2);
+	// SafeCrash 一定会抛出异常，所以用 OnCompletion：不论成败，结束后都执行 Normal
+	TaskGraph graph;
+	TaskGraph::NodeId safe = graph.AddNode(TaskFactory::CreateTask("SafeCrash"));
+	TaskGraph::NodeId normal = graph.AddNode(TaskFactory::CreateTask("Normal"));
+	graph.Precede(safe, normal, DependencyKind::OnCompletion);
+	graph.Submit(*TaskScheduler::GetInstance());
 }
\ No newline at end of file
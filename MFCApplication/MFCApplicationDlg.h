@@ -3,17 +3,17 @@
 //
 
 #pragma once
-#include "IObserver.h"
+#include "RingBuffer.h"
+#include "TaskResult.h"
+#include "UiLogSink.h"
 
 // CMFCApplicationDlg 对话框
-class CMFCApplicationDlg : public CDialogEx,public IObserver
+class CMFCApplicationDlg : public CDialogEx
 {
 // 构造
 public:
 	CMFCApplicationDlg(CWnd* pParent = nullptr);	// 标准构造函数
-	virtual void OnLogUpdate(const std::string& message) override;
 // 对话框数据
-#define WM_UPDATE_LOG (WM_USER + 100)
 #ifdef AFX_DESIGN_TIME
 	enum { IDD = IDD_MFCAPPLICATION_DIALOG };
 #endif
@@ -25,14 +25,24 @@ public:
 // 实现
 protected:	
 	HICON m_hIcon;
+	// 日志由 m_logSink 缓冲，定时器按固定帧率一次取出一批显示
+	static const UINT_PTR kLogTimerId = 1;
+	static const UINT kLogFrameMs = 33;
+	UiLogSink m_logSink;
+	UiLogFrame m_logFrame;
+	// 结构化结果与日志分开：订阅回调只把结果推入队列，同一个定时器里取出上屏
+	RingBuffer<TaskResult> m_results{ 64 };
+	TaskResultChannel::Token m_resultToken = 0;
+	void ShowResult(const TaskResult& result, bool& resultChanged, bool& demoPassed);
 	// 生成的消息映射函数
 	virtual BOOL OnInitDialog();
 	afx_msg void OnSysCommand(UINT nID, LPARAM lParam);
 	afx_msg void OnPaint();
 	afx_msg HCURSOR OnQueryDragIcon();
+	afx_msg void OnDestroy();
+	afx_msg void OnTimer(UINT_PTR nIDEvent);
 	DECLARE_MESSAGE_MAP()
 public:
-	afx_msg LRESULT OnUpdateLog(WPARAM wParam, LPARAM lParam);
 	afx_msg void OnBnClickedBtnStart();
 	afx_msg void OnBnClickedBtnMatrix();
 	afx_msg void OnBnClickedBtnRemind();
@@ -0,0 +1,234 @@
+﻿// 调度器核心不依赖 MFC，也不使用预编译头
+#include "ObserverHub.h"
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+
+ObserverHub::ObserverHub()
+    : current(new ObserverList()), observerCount(0), epoch(0), asyncEnabled(false), batchInterval(16), stopDelivery(false),
+      deliverySleeping(false), deliveryRunning(false), activeProducers(0), published(0), consumed(0), delivered(0), coalesced(0),
+      dropped(0), batches(0) {
+    readers[0] = 0;
+    readers[1] = 0;
+}
+
+ObserverHub::~ObserverHub() {
+    Stop();
+    delete current.load();
+}
+
+// ------------------------------------------
+// 观察者列表：读方只做两次原子加减，不加锁
+// ------------------------------------------
+unsigned ObserverHub::BeginRead() {
+    unsigned slot = epoch.load() & 1u;
+    readers[slot].fetch_add(1);
+    return slot;
+}
+
+void ObserverHub::EndRead(unsigned slot) {
+    readers[slot].fetch_sub(1);
+}
+
+void ObserverHub::ReplaceList(const ObserverList* list) {
+    observerCount.store(list->size(), std::memory_order_relaxed);
+    const ObserverList* old = current.exchange(list);
+    // 宽限期：两次翻转纪元，每次等旧纪元上的通知全部结束。
+    // 只翻转一次不够：上一次 Detach 之后仍停留在另一个纪元上的读方可能还拿着旧列表
+    for (int round = 0; round < 2; ++round) {
+        unsigned slot = epoch.fetch_add(1) & 1u;
+        while (readers[slot].load() != 0) std::this_thread::yield();
+    }
+    delete old;
+}
+
+void ObserverHub::Attach(IObserver* observer) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const ObserverList* list = current.load();
+    if (std::find(list->begin(), list->end(), observer) != list->end()) return;
+    ObserverList* next = new ObserverList(*list);
+    next->push_back(observer);
+    ReplaceList(next);
+}
+
+void ObserverHub::Detach(IObserver* observer) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    ObserverList* next = new ObserverList(*current.load());
+    next->erase(std::remove(next->begin(), next->end(), observer), next->end());
+    ReplaceList(next);
+}
+
+void ObserverHub::DeliverNow(const std::string& message) {
+    ReadScope scope(*this);
+    for (IObserver* observer : *current.load()) {
+        if (!observer) continue;
+        try {
+            observer->OnLogUpdate(message);
+        }
+        catch (...) {
+            // 一个观察者出错不影响其他观察者，也不能让发布方 (工作线程) 的任务因此失败
+        }
+    }
+}
+
+// ------------------------------------------
+// 发布
+// ------------------------------------------
+void ObserverHub::Publish(std::string message, std::string key) {
+    if (Empty()) return; // 没有观察者，不入队也不投递
+    // 先登记再检查模式 (均为 seq_cst)：Stop() 关闭异步模式后要么看到这里的登记，要么这里看到已关闭
+    activeProducers.fetch_add(1);
+    if (!asyncEnabled.load()) {
+        activeProducers.fetch_sub(1);
+        DeliverNow(message);
+        return;
+    }
+    Message item{ std::move(message), std::move(key) };
+    while (!ring->TryPush(item)) {
+        Message oldest;
+        if (ring->TryPop(oldest)) {
+            consumed.fetch_add(1);
+            dropped.fetch_add(1);
+        }
+    }
+    published.fetch_add(1);
+    WakeDelivery();
+    activeProducers.fetch_sub(1);
+}
+
+// 与 DeliveryLoop 中的栅栏配对：要么这里看到 deliverySleeping，要么投递线程入睡前看到队列非空
+void ObserverHub::WakeDelivery() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (deliverySleeping.load()) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCv.notify_one();
+    }
+}
+
+// ------------------------------------------
+// 异步投递
+// ------------------------------------------
+void ObserverHub::EnableAsync(size_t capacity, std::chrono::milliseconds interval) {
+    if (asyncEnabled) return;
+    if (!ring) {
+        ring.reset(new RingBuffer<Message>(capacity)); // 重新启用时沿用原队列
+    }
+    batchInterval = interval;
+    stopDelivery = false;
+    deliveryRunning = true;
+    deliveryThread = std::thread(&ObserverHub::DeliveryLoop, this);
+    asyncEnabled = true;
+}
+
+// 取出一批消息，合并同 key 的状态后一次性回调；返回取出的条数
+size_t ObserverHub::DeliverBatch(std::vector<Message>& batch) {
+    batch.clear();
+    Message item;
+    while (batch.size() < kBatchLimit && ring->TryPop(item)) batch.push_back(std::move(item));
+    if (batch.empty()) return 0;
+
+    // 从后往前：同 key 的消息只保留最后一条，位置也取最后一条的位置
+    std::vector<bool> skip(batch.size(), false);
+    std::unordered_set<std::string_view> seen;
+    size_t merged = 0;
+    for (size_t i = batch.size(); i-- > 0;) {
+        if (batch[i].key.empty()) continue;
+        if (!seen.insert(batch[i].key).second) {
+            skip[i] = true;
+            ++merged;
+        }
+    }
+
+    {
+        ReadScope scope(*this);
+        const ObserverList& list = *current.load();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (skip[i]) continue;
+            for (IObserver* observer : list) {
+                if (!observer) continue;
+                try {
+                    observer->OnLogUpdate(batch[i].text);
+                }
+                catch (...) {
+                    // 观察者的异常不能终止投递线程
+                }
+            }
+        }
+    }
+    delivered.fetch_add(batch.size() - merged);
+    coalesced.fetch_add(merged);
+    batches.fetch_add(1);
+    consumed.fetch_add(batch.size());
+    return batch.size();
+}
+
+// 投递线程：有消息就投递一批，然后至少间隔 batchInterval 再取下一批；没有消息就休眠
+void ObserverHub::DeliveryLoop() {
+    std::vector<Message> batch;
+    while (true) {
+        if (DeliverBatch(batch) > 0) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            deliveredCv.notify_all();
+            wakeCv.wait_for(lock, batchInterval, [this] { return stopDelivery.load(); });
+            continue;
+        }
+        if (stopDelivery.load()) {
+            break; // 队列已空且收到停止请求
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        deliveredCv.notify_all();
+        // 先在锁内宣布休眠，再复查队列：之后入队的发布方一定会看到标志并在锁内通知，不会丢失唤醒
+        deliverySleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wakeCv.wait(lock, [this] {
+            return stopDelivery.load() || !ring->Empty();
+            });
+        deliverySleeping = false;
+    }
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    deliveryRunning = false;
+    deliveredCv.notify_all();
+}
+
+void ObserverHub::Flush() {
+    if (!asyncEnabled) return;
+    uint64_t target = published.load();
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wakeCv.notify_one();
+    deliveredCv.wait(lock, [this, target] {
+        return consumed.load() >= target || !deliveryRunning.load();
+        });
+}
+
+void ObserverHub::Stop() {
+    if (!asyncEnabled) return;
+    // 先关闭异步模式，新来的发布方改为同步投递；再等已在途的发布方入队完毕 (发布方从不等待，很快就会离开)
+    asyncEnabled = false;
+    while (activeProducers.load() != 0) {
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopDelivery = true;
+        wakeCv.notify_one();
+    }
+    if (deliveryThread.joinable()) {
+        deliveryThread.join();
+    }
+
+    // 投递线程最后一轮之后才入队的消息，在这里投递 (此后不会再有发布方入队)
+    std::vector<Message> batch;
+    while (DeliverBatch(batch) > 0) {
+    }
+}
+
+ObserverHubStats ObserverHub::GetStats() const {
+    ObserverHubStats stats;
+    stats.published = published.load();
+    stats.delivered = delivered.load();
+    stats.coalesced = coalesced.load();
+    stats.dropped = dropped.load();
+    stats.batches = batches.load();
+    return stats;
+}
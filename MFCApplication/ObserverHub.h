@@ -0,0 +1,109 @@
+﻿#pragma once
+#include "IObserver.h"
+#include "RingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ObserverHubStats {
+    uint64_t published = 0;   // 进入异步队列的条数 (同步模式不计)
+    uint64_t delivered = 0;   // 交给观察者的条数 (每条消息只计一次，不乘观察者个数)
+    uint64_t coalesced = 0;   // 同一批中被同 key 的新消息取代的条数
+    uint64_t dropped = 0;     // 队列写满时丢弃的最旧消息条数
+    uint64_t batches = 0;     // 异步投递的批数
+};
+
+// 对应设计模式：Observer (观察者模式) - 主题
+// 观察者列表写时复制：Attach/Detach 发布一份新列表，通知方无锁遍历当前列表；
+// Detach 等待已经开始的通知结束 (类似 RCU 的宽限期) 后才返回，之后不会再回调被移除的观察者。
+//
+// 默认同步投递：在调用 Publish 的线程上回调 OnLogUpdate。
+// EnableAsync() 后 Publish 只把消息推入无锁环形队列，由投递线程成批回调；
+// 同一批中 key 相同的状态消息只投递最新的一条。队列写满时丢弃最旧的消息，发布方永远不等待观察者。
+class ObserverHub {
+public:
+    ObserverHub();
+    ~ObserverHub();
+
+    ObserverHub(const ObserverHub&) = delete;
+    ObserverHub& operator=(const ObserverHub&) = delete;
+
+    void Attach(IObserver* observer);
+    // 不能在 OnLogUpdate 内调用 (会等待自己所在的通知结束)
+    void Detach(IObserver* observer);
+
+    // key 为空的消息从不合并
+    void Publish(std::string message, std::string key = std::string());
+
+    // capacity: 环形队列容量；interval: 两批之间的最短间隔，期间到达的同 key 消息会被合并
+    void EnableAsync(size_t capacity = 8192, std::chrono::milliseconds interval = std::chrono::milliseconds(16));
+    // 投递队列中剩余的消息并停止投递线程，之后回到同步模式
+    void Stop();
+    // 等待调用前发布的消息全部投递 (同步模式下立即返回)
+    void Flush();
+
+    bool IsAsync() const { return asyncEnabled.load(std::memory_order_acquire); }
+    // 没有观察者时发布方可以连消息都不拼 (只是提示，刚 Attach 的观察者可能错过这一条)
+    bool Empty() const { return observerCount.load(std::memory_order_relaxed) == 0; }
+    ObserverHubStats GetStats() const;
+    // 异步队列写满时丢弃的最旧消息条数
+    uint64_t GetDroppedCount() const { return dropped.load(); }
+
+private:
+    using ObserverList = std::vector<IObserver*>;
+
+    struct Message {
+        std::string text;
+        std::string key;
+    };
+
+    // ---- 观察者列表 ----
+    std::mutex writerMutex;                    // 串行化 Attach/Detach
+    std::atomic<const ObserverList*> current;
+    std::atomic<size_t> observerCount;         // current 的长度，供 Empty() 不进入读区间就能查询
+    std::atomic<uint64_t> readers[2];          // 按纪元奇偶分开的在途通知数
+    std::atomic<unsigned> epoch;
+
+    unsigned BeginRead();
+    void EndRead(unsigned slot);
+    struct ReadScope {
+        ObserverHub& hub;
+        unsigned slot;
+        explicit ReadScope(ObserverHub& h) : hub(h), slot(h.BeginRead()) {}
+        ~ReadScope() { hub.EndRead(slot); }
+    };
+    void ReplaceList(const ObserverList* list); // 换上新列表并等待宽限期，之后释放旧列表 (需持有 writerMutex)
+    void DeliverNow(const std::string& message);
+
+    // ---- 异步模式 ----
+    std::unique_ptr<RingBuffer<Message>> ring;
+    std::atomic<bool> asyncEnabled;
+    std::chrono::milliseconds batchInterval;
+    std::thread deliveryThread;
+    std::atomic<bool> stopDelivery;
+    std::atomic<bool> deliverySleeping;        // 投递线程是否在休眠，发布方只在此时才通知 (在 wakeMutex 内设置)
+    std::atomic<bool> deliveryRunning;
+    std::atomic<int> activeProducers;          // 正在异步发布的线程数，Stop() 等它们离开后才做最后一次投递
+    std::mutex wakeMutex;                      // 只用于投递线程休眠/唤醒
+    std::condition_variable wakeCv;
+    std::condition_variable deliveredCv;       // 通知 Flush() 的等待者
+
+    std::atomic<uint64_t> published;
+    std::atomic<uint64_t> consumed;            // 已投递、被合并或被丢弃的条数
+    std::atomic<uint64_t> delivered;
+    std::atomic<uint64_t> coalesced;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> batches;
+
+    static const size_t kBatchLimit = 4096;    // 单批最多条数
+
+    void WakeDelivery();
+    size_t DeliverBatch(std::vector<Message>& batch);
+    void DeliveryLoop();
+};
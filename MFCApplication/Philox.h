@@ -0,0 +1,36 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Philox4x32-10 计数器随机数发生器 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11)
+// 输出只取决于 (密钥, 计数器)：没有内部状态链，任意位置可以 O(1) 跳转，
+// 因此每个数据块可以有自己的流，无论分给几个线程、按什么顺序生成，得到的样本都相同。
+// 批量生成时按 8 个计数器一组交错计算 (结构数组)，乘法与异或可被编译器向量化。
+class PhiloxStream {
+public:
+    // 一次 Philox 运算产出 128 位 (4 个 uint32)，称为一个块
+    struct Block {
+        uint32_t v[4];
+    };
+
+    // seed 作为密钥；stream 占计数器高 64 位，不同 stream 互不重叠；低 64 位为块编号
+    PhiloxStream(uint64_t seed, uint64_t stream);
+
+    // 跳到第 block 个块 (O(1))
+    void Seek(uint64_t block) { position = block; }
+    uint64_t Position() const { return position; }
+
+    // 单个块：参考实现，也用于校验
+    static Block Generate(uint64_t counterLo, uint64_t counterHi, uint64_t key);
+
+    void FillBits(Block* out, size_t blocks);
+    // [0, 1) 均匀分布，52 位精度；每个块产出 2 个值
+    void FillUniform(double* out, size_t n);
+    // 正态分布 (Box-Muller)；每个块产出 2 个值
+    void FillNormal(double* out, size_t n, double mean, double sd);
+
+private:
+    uint32_t key[2];
+    uint32_t streamHi[2]; // 计数器的高 64 位
+    uint64_t position;    // 计数器的低 64 位
+};
@@ -0,0 +1,103 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 有界无锁环形队列 (Vyukov 算法)
+// 每个槽带一个序号，生产者/消费者通过 CAS 抢占位置，不需要任何互斥锁。
+// 主要用作多生产者、单消费者 (刷盘线程)；但出队同样是多线程安全的，
+// 因为 "丢弃最旧" 策略下生产者也会出队腾出空间。
+template <typename T>
+class RingBuffer {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    // 生产者与消费者的游标分别独占缓存行，避免伪共享
+    char pad0[64];
+    std::atomic<size_t> enqueuePos;
+    char pad1[64];
+    std::atomic<size_t> dequeuePos;
+    char pad2[64];
+
+    static size_t RoundUpPowerOfTwo(size_t value) {
+        const size_t kMaxCapacity = size_t(1) << 30; // 防止溢出
+        if (value > kMaxCapacity) value = kMaxCapacity;
+        size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+public:
+    // capacity 会向上取整为 2 的幂
+    explicit RingBuffer(size_t capacity)
+        : cells(new Cell[RoundUpPowerOfTwo(capacity)]), mask(RoundUpPowerOfTwo(capacity) - 1),
+          enqueuePos(0), dequeuePos(0) {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // 队列已满时返回 false，value 保持不变
+    bool TryPush(T& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // 满
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 队列为空时返回 false
+    bool TryPop(T& out) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.data);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // 空
+            }
+            else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 近似值，只用于判断是否需要唤醒消费者
+    bool Empty() const {
+        return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return mask + 1; }
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "ITask.h"
+#include "TaskHandle.h"
+#include "SchedulerClock.h"
 #include <memory>
 #include <chrono>
 
@@ -9,8 +11,12 @@ struct ScheduledTask {
     // ʹ std::shared_ptr 
     std::shared_ptr<ITask> task;
 
-    // ƻִеʱ
-    std::chrono::system_clock::time_point executeTime;
+    // ƻִеʱ (ʱ)
+    SchedulerClock::time_point executeTime;
+
+    // ȼֹʱ (ûнֹʱʱΪ time_point::max())
+    TaskPriority priority;
+    SchedulerClock::time_point deadline;
 
     // ǷΪ [cite: 206]
     bool isPeriodic;
@@ -18,9 +24,30 @@ struct ScheduledTask {
     // ڵļ룩
     std::chrono::milliseconds interval;
 
+    // ƿ (ȡ/µ)ΪձʾĿȡ
+    std::shared_ptr<TaskControl> control;
+
+    // ʱƿĴƿ鵱ǰһ˵ѱµ
+    uint64_t generation;
+
     // 캯
-    ScheduledTask(std::shared_ptr<ITask> t, std::chrono::system_clock::time_point time, bool periodic = false, int intervalMs = 0)
-        : task(t), executeTime(time), isPeriodic(periodic), interval(intervalMs) {
+    ScheduledTask(std::shared_ptr<ITask> t, SchedulerClock::time_point time, bool periodic = false, int intervalMs = 0)
+        : task(t), executeTime(time), priority(TaskPriority::Normal), deadline(SchedulerClock::time_point::max()),
+          isPeriodic(periodic), interval(intervalMs), generation(0) {
+    }
+
+    bool HasDeadline() const {
+        return deadline != SchedulerClock::time_point::max();
+    }
+
+    // еݣнֹʱ䰴ֹʱ䣬򰴵ʱ
+    SchedulerClock::time_point ReadyKey() const {
+        return HasDeadline() ? deadline : executeTime;
+    }
+
+    // ĿǷȻЧ (δȡδµ)
+    bool IsLive() const {
+        return !control || (!control->cancelled && control->generation == generation);
     }
 
     //  > ȶе
@@ -0,0 +1,40 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+
+// 调度器统一使用单调时钟：系统时间被 NTP/手动/夏令时调整时，
+// 延迟任务不会提前或推迟，周期任务也不会连发或停摆。
+// 只有写给人看的时间戳 (事件日志) 仍然使用 system_clock。
+using SchedulerClock = std::chrono::steady_clock;
+
+// 粗粒度的"当前时间"缓存
+// 定时线程每分发一批、工作线程每执行完一个任务时发布一次 (这两处本来就要读时钟)，
+// 其他地方读取缓存只是一次原子 load。误差不超过一个分发批次/一个任务的执行时间。
+class CoarseClock {
+private:
+    static inline std::atomic<SchedulerClock::rep> cached{ 0 };
+
+    // 与上次发布相差不足该值时不写，避免多个工作线程反复写同一条缓存行
+    static constexpr SchedulerClock::rep kPublishGranularity =
+        std::chrono::duration_cast<SchedulerClock::duration>(std::chrono::microseconds(50)).count();
+
+public:
+    static SchedulerClock::time_point Now() {
+        return SchedulerClock::time_point(SchedulerClock::duration(cached.load(std::memory_order_relaxed)));
+    }
+
+    // 只前进不后退
+    static void Publish(SchedulerClock::time_point now) {
+        SchedulerClock::rep value = now.time_since_epoch().count();
+        SchedulerClock::rep current = cached.load(std::memory_order_relaxed);
+        while (value - current >= kPublishGranularity &&
+            !cached.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static SchedulerClock::time_point Refresh() {
+        SchedulerClock::time_point now = SchedulerClock::now();
+        Publish(now);
+        return now;
+    }
+};
@@ -0,0 +1,343 @@
+﻿#include "SegmentedLog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// ==========================================
+// MappedFile
+// ==========================================
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : data(nullptr), capacity(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {
+}
+
+bool MappedFile::Create(const std::string& filePath, size_t size) {
+    path = filePath;
+    HANDLE file = ::CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(size);
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READWRITE, length.HighPart, length.LowPart, nullptr);
+    if (mapping == nullptr) {
+        ::CloseHandle(file);
+        ::DeleteFileA(filePath.c_str()); // 不留下半成品的空分段
+        return false;
+    }
+    void* view = ::MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (view == nullptr) {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        ::DeleteFileA(filePath.c_str());
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<char*>(view);
+    capacity = size;
+    return true;
+}
+
+void MappedFile::Close(size_t usedBytes) {
+    if (data == nullptr) return;
+    ::FlushViewOfFile(data, usedBytes);
+    ::UnmapViewOfFile(data);
+    ::CloseHandle(mappingHandle);
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(usedBytes);
+    ::SetFilePointerEx(fileHandle, length, nullptr, FILE_BEGIN);
+    ::SetEndOfFile(fileHandle); // 去掉预分配但未使用的部分
+    ::CloseHandle(fileHandle);
+    data = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::SyncAsync() {
+    if (data != nullptr) ::FlushViewOfFile(data, 0); // 只发起回写，不等待落盘
+}
+
+#else
+
+MappedFile::MappedFile() : data(nullptr), capacity(0), fd(-1) {
+}
+
+bool MappedFile::Create(const std::string& filePath, size_t size) {
+    path = filePath;
+    int file = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) return false;
+
+    // 真正分配磁盘块，磁盘满在这里就能发现，而不是写入时触发 SIGBUS
+    // posix_fallocate 直接返回错误码 (不设置 errno)；只有文件系统不支持时才退回 ftruncate (稀疏文件)，
+    // ENOSPC 等其他错误一律视为创建失败，不能把稀疏文件映射进来
+    int err = ::posix_fallocate(file, 0, static_cast<off_t>(size));
+    if (err == EOPNOTSUPP || err == EINVAL) {
+        err = ::ftruncate(file, static_cast<off_t>(size)) != 0 ? errno : 0;
+    }
+    if (err != 0) {
+        ::close(file);
+        ::unlink(filePath.c_str()); // 不留下半成品的空分段
+        return false;
+    }
+    void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) {
+        ::close(file);
+        ::unlink(filePath.c_str());
+        return false;
+    }
+    fd = file;
+    data = static_cast<char*>(view);
+    capacity = size;
+    return true;
+}
+
+void MappedFile::Close(size_t usedBytes) {
+    if (data == nullptr) return;
+    ::munmap(data, capacity);
+    if (::ftruncate(fd, static_cast<off_t>(usedBytes)) != 0) {
+        std::perror("ftruncate");
+    }
+    ::close(fd);
+    data = nullptr;
+    fd = -1;
+}
+
+void MappedFile::SyncAsync() {
+    if (data != nullptr) ::msync(data, capacity, MS_ASYNC);
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    // 未显式 Close 时保留全部容量，内容不会丢
+    Close(capacity);
+}
+
+// ==========================================
+// SegmentedLogFile
+// ==========================================
+
+SegmentedLogFile::SegmentedLogFile(const std::string& basePath, const LogRotationOptions& rotation)
+    : options(rotation), currentUsed(0), rotationFailures(0), nextSequence(1), needStandby(true),
+      stopMaintenance(false) {
+    if (options.segmentBytes < 4096) options.segmentBytes = 4096;
+    if (options.maxSegments < 1) options.maxSegments = 1;
+
+    fs::path base(basePath);
+    directory = base.has_parent_path() ? base.parent_path().string() : std::string(".");
+    stem = base.stem().string();
+    extension = base.extension().string();
+
+    // 接着已有分段的最大序号往下编，避免覆盖上次运行的日志
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        unsigned long long sequence;
+        if (ParseSegmentName(entry.path().filename().string(), sequence) && sequence >= nextSequence) {
+            nextSequence = sequence + 1;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex);
+        current = CreateSegment();
+    }
+    currentOpened = std::chrono::steady_clock::now();
+    maintenanceThread = std::thread(&SegmentedLogFile::MaintenanceLoop, this);
+}
+
+SegmentedLogFile::~SegmentedLogFile() {
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex);
+        stopMaintenance = true;
+    }
+    maintenanceCv.notify_one();
+    if (maintenanceThread.joinable()) {
+        maintenanceThread.join();
+    }
+
+    if (current) current->Close(currentUsed);
+    if (fallback.is_open()) fallback.close();
+    // 后台线程已退出，这里不会再有人交出或创建 standby
+    if (standby) {
+        // 预先创建但从未使用的分段直接删掉
+        std::string unused = standby->Path();
+        standby->Close(0);
+        standby.reset();
+        std::error_code ec;
+        fs::remove(unused, ec);
+    }
+}
+
+// 解析 <主名>.<序号><扩展名>，不是本日志的分段返回 false
+bool SegmentedLogFile::ParseSegmentName(const std::string& name, unsigned long long& sequence) const {
+    if (name.size() <= stem.size() + 1 + extension.size() ||
+        name.compare(0, stem.size() + 1, stem + ".") != 0 ||
+        name.compare(name.size() - extension.size(), extension.size(), extension) != 0) {
+        return false;
+    }
+    std::string digits = name.substr(stem.size() + 1, name.size() - stem.size() - 1 - extension.size());
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+    sequence = std::stoull(digits);
+    return true;
+}
+
+std::string SegmentedLogFile::SegmentPath(unsigned long long sequence) const {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%06llu", sequence);
+    return (fs::path(directory) / (stem + "." + number + extension)).string();
+}
+
+std::unique_ptr<MappedFile> SegmentedLogFile::CreateSegment() {
+    auto segment = std::make_unique<MappedFile>();
+    if (!segment->Create(SegmentPath(nextSequence++), options.segmentBytes)) {
+        return nullptr;
+    }
+    return segment;
+}
+
+void SegmentedLogFile::Append(const char* bytes, size_t size) {
+    while (size > 0) {
+        if (!current) {
+            // 降级模式：每秒最多重试一次换回映射分段，其余时间直接写普通文件
+            bool retry = std::chrono::steady_clock::now() - currentOpened >= std::chrono::seconds(1);
+            if (fallback.is_open() && (!retry || !Rotate())) {
+                fallback.write(bytes, static_cast<std::streamsize>(size));
+                fallback.flush();
+            }
+            if (!current) return;
+            continue;
+        }
+        bool expired = std::chrono::steady_clock::now() - currentOpened >= options.maxAge;
+        if (currentUsed == current->Capacity() || (expired && currentUsed > 0)) {
+            Rotate();
+            continue;
+        }
+        size_t chunk = (std::min)(size, current->Capacity() - currentUsed);
+        std::memcpy(current->Data() + currentUsed, bytes, chunk);
+        currentUsed += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+void SegmentedLogFile::Sync() {
+    if (current) current->SyncAsync();
+    else if (fallback.is_open()) fallback.flush();
+}
+
+// 轮转：换上后台准备好的分段，旧分段交给后台线程收尾
+// 拿不到新分段时保留当前分段 (还有空间时) 或改写普通文件，并让后台重试
+bool SegmentedLogFile::Rotate() {
+    std::unique_lock<std::mutex> lock(maintenanceMutex);
+    std::unique_ptr<MappedFile> next = std::move(standby);
+    if (!next && current) {
+        next = CreateSegment(); // 后台还没准备好 (极少见)，只能当场创建
+    }
+    needStandby = true;
+    bool rotated = next != nullptr;
+    if (rotated) {
+        if (current) retired.push_back(RetiredSegment{ std::move(current), currentUsed });
+        current = std::move(next);
+        currentUsed = 0;
+        if (fallback.is_open()) fallback.close();
+    }
+    else if (current) {
+        ++rotationFailures;
+        if (currentUsed == current->Capacity()) {
+            // 当前分段已写满：交给后台截断关闭，之后的日志追加到普通文件
+            fallbackPath = SegmentPath(nextSequence++);
+            retired.push_back(RetiredSegment{ std::move(current), currentUsed });
+            fallback.open(fallbackPath, std::ios::binary | std::ios::app);
+        }
+        std::cerr << "Failed to create log segment, "
+            << (current ? "keep writing " + current->Path() : "falling back to " + fallbackPath) << std::endl;
+    }
+    currentOpened = std::chrono::steady_clock::now(); // 失败时也重新计时，不会每次追加都重试
+    lock.unlock();
+    maintenanceCv.notify_one();
+    return rotated;
+}
+
+// 按序号删除超出保留数量的旧分段
+void SegmentedLogFile::DeleteOldSegments() {
+    // 扫描与删除都在锁内完成：期间写入方无法交换 standby/current，不会误删刚换上的分段
+    std::lock_guard<std::mutex> lock(maintenanceMutex);
+    std::vector<std::pair<unsigned long long, fs::path>> segments;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        unsigned long long sequence;
+        if (ParseSegmentName(entry.path().filename().string(), sequence)) {
+            segments.emplace_back(sequence, entry.path());
+        }
+    }
+
+    std::string standbyPath = standby ? standby->Path() : std::string();
+    std::string currentPath = current ? current->Path() : fallbackPath;
+
+    std::sort(segments.begin(), segments.end());
+    size_t kept = 0;
+    for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+        if (it->second.string() == standbyPath) continue; // 预备分段不计入保留数量
+        if (++kept > options.maxSegments && it->second.string() != currentPath) {
+            fs::remove(it->second, ec);
+        }
+    }
+}
+
+void SegmentedLogFile::MaintenanceLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(maintenanceMutex);
+        maintenanceCv.wait(lock, [this] {
+            return stopMaintenance || needStandby || !retired.empty();
+            });
+
+        // 先准备下一个分段，保证写入方随时有可用的 standby
+        if (needStandby && !stopMaintenance) {
+            needStandby = false;
+            unsigned long long sequence = nextSequence++;
+            lock.unlock();
+            auto segment = std::make_unique<MappedFile>();
+            bool created = segment->Create(SegmentPath(sequence), options.segmentBytes);
+            lock.lock();
+            if (created && stopMaintenance) {
+                // 创建期间已经开始关闭，这个分段不会再用到
+                std::string unused = segment->Path();
+                segment->Close(0);
+                std::error_code ec;
+                fs::remove(unused, ec);
+            }
+            else if (created) {
+                standby = std::move(segment);
+            }
+        }
+
+        std::deque<RetiredSegment> toClose;
+        toClose.swap(retired);
+        bool stopping = stopMaintenance;
+        lock.unlock();
+
+        if (!toClose.empty()) {
+            for (auto& segment : toClose) {
+                segment.file->Close(segment.used); // 截断到实际长度，耗时操作放在后台
+            }
+            DeleteOldSegments();
+        }
+        if (stopping) break;
+    }
+}
@@ -0,0 +1,107 @@
+﻿#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 日志分段轮转参数
+struct LogRotationOptions {
+    size_t segmentBytes = 16 * 1024 * 1024;          // 单个分段大小 (创建时预分配)
+    std::chrono::seconds maxAge = std::chrono::hours(1); // 分段最长使用时间，到时即使未写满也轮转
+    size_t maxSegments = 8;                          // 最多保留的分段数 (含当前分段)，更旧的在后台删除
+};
+
+// 内存映射文件：创建时预分配到固定大小，之后的追加只是 memcpy，没有系统调用
+// 关闭时截断到实际写入的长度
+class MappedFile {
+private:
+    std::string path;
+    char* data;
+    size_t capacity;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Create(const std::string& filePath, size_t size);
+    void Close(size_t usedBytes);  // 解除映射并截断到 usedBytes
+    void SyncAsync();              // 通知内核尽快回写脏页，不等待完成
+
+    char* Data() const { return data; }
+    size_t Capacity() const { return capacity; }
+    const std::string& Path() const { return path; }
+    bool IsOpen() const { return data != nullptr; }
+};
+
+// 按大小/时间轮转的分段日志文件
+// 分段命名为 <主名>.<6 位序号><扩展名>，如 scheduler_log.000001.txt
+// 下一个分段由后台线程提前创建并映射好 (standby)，轮转时只需交换指针；
+// 旧分段的截断、关闭以及超出保留数量的删除都在后台线程完成，写入方不会卡住
+// 拿不到新分段 (如磁盘满) 时不丢日志：当前分段还有空间就继续写，写满后改为追加到普通文件，之后再重试
+class SegmentedLogFile {
+private:
+    struct RetiredSegment {
+        std::unique_ptr<MappedFile> file;
+        size_t used;
+    };
+
+    std::string directory;
+    std::string stem;
+    std::string extension;
+    LogRotationOptions options;
+
+    std::unique_ptr<MappedFile> current;
+    size_t currentUsed;
+    std::chrono::steady_clock::time_point currentOpened;
+    std::ofstream fallback;                 // 无法创建映射分段时的降级输出
+    std::string fallbackPath;
+    unsigned long long rotationFailures;    // 轮转失败次数
+
+    // 以下由 maintenanceMutex 保护
+    std::unique_ptr<MappedFile> standby;
+    std::deque<RetiredSegment> retired;
+    unsigned long long nextSequence;
+    bool needStandby;
+    bool stopMaintenance;
+    std::mutex maintenanceMutex;
+    std::condition_variable maintenanceCv;
+    std::thread maintenanceThread;
+
+    std::string SegmentPath(unsigned long long sequence) const;
+    bool ParseSegmentName(const std::string& name, unsigned long long& sequence) const;
+    std::unique_ptr<MappedFile> CreateSegment();   // 调用者持有 maintenanceMutex
+    bool Rotate();                                 // 拿不到新分段时返回 false
+    void DeleteOldSegments();
+    void MaintenanceLoop();
+
+public:
+    SegmentedLogFile(const std::string& basePath, const LogRotationOptions& rotation);
+    ~SegmentedLogFile();
+    SegmentedLogFile(const SegmentedLogFile&) = delete;
+    SegmentedLogFile& operator=(const SegmentedLogFile&) = delete;
+
+    // 追加数据，写满或超时会自动轮转；调用者负责串行化 (LogWriter 持锁调用)
+    void Append(const char* bytes, size_t size);
+
+    // 请求把已写入的内容回写到磁盘 (异步)
+    void Sync();
+
+    bool IsOpen() const { return current != nullptr || fallback.is_open(); }
+    std::string CurrentPath() const { return current ? current->Path() : fallbackPath; }
+
+    // 轮转失败 (换不上新分段) 的次数，非 0 说明曾降级写入普通文件
+    unsigned long long GetRotationFailures() const { return rotationFailures; }
+};
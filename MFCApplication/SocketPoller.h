@@ -0,0 +1,213 @@
+﻿#pragma once
+// 非阻塞套接字的平台差异与就绪等待 (HttpClient 的事件循环、协程的 I/O 等待共用)
+// 只在 .cpp 中包含，并且要放在第一个：套接字头文件必须先于任何 <windows.h>，否则与旧的 winsock.h 冲突
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// ------------------------------------------
+// 平台差异：套接字类型、错误码、非阻塞
+// ------------------------------------------
+#ifdef _WIN32
+using Socket = SOCKET;
+const Socket kInvalidSocket = INVALID_SOCKET;
+using IoSize = int;
+inline void CloseSocket(Socket s) { closesocket(s); }
+inline int LastSocketError() { return WSAGetLastError(); }
+inline bool WouldBlock(int e) { return e == WSAEWOULDBLOCK; }
+inline bool ConnectPending(int e) { return e == WSAEWOULDBLOCK || e == WSAEINPROGRESS; }
+inline bool SetNonBlocking(Socket s) { u_long on = 1; return ioctlsocket(s, FIONBIO, &on) == 0; }
+inline std::string SocketErrorText(int e) { return "socket error " + std::to_string(e); }
+#else
+using Socket = int;
+const Socket kInvalidSocket = -1;
+using IoSize = size_t;
+inline void CloseSocket(Socket s) { ::close(s); }
+inline int LastSocketError() { return errno; }
+inline bool WouldBlock(int e) { return e == EAGAIN || e == EWOULDBLOCK || e == EINTR; }
+inline bool ConnectPending(int e) { return e == EINPROGRESS; }
+inline bool SetNonBlocking(Socket s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+inline std::string SocketErrorText(int e) { return std::strerror(e); }
+#endif
+
+#ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL; // 对端已关闭时返回 EPIPE 而不是 SIGPIPE
+#else
+const int kSendFlags = 0;
+#endif
+
+// Windows 上套接字库要先初始化 (引用计数)，其他平台什么也不做
+class SocketRuntime {
+public:
+    SocketRuntime() {
+#ifdef _WIN32
+        WSADATA wsa;
+        WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+    }
+    ~SocketRuntime() {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+    SocketRuntime(const SocketRuntime&) = delete;
+    SocketRuntime& operator=(const SocketRuntime&) = delete;
+};
+
+// 唤醒套接字：连接到自己的回环 UDP 套接字，另一个线程写一个字节即可打断 Poller::Wait
+// 两个平台同一套做法；失败时返回 kInvalidSocket，调用者改为短周期轮询
+inline Socket OpenWakeSocket() {
+    Socket s = socket(AF_INET, SOCK_DGRAM, 0);
+    if (s == kInvalidSocket) return s;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bool ok = bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+        getsockname(s, reinterpret_cast<sockaddr*>(&addr), &len) == 0 &&
+        connect(s, reinterpret_cast<sockaddr*>(&addr), len) == 0 && SetNonBlocking(s);
+    if (!ok) {
+        CloseSocket(s);
+        return kInvalidSocket;
+    }
+    return s;
+}
+
+inline void SignalWakeSocket(Socket s) {
+    char byte = 1;
+    send(s, &byte, 1, 0);
+}
+
+inline void DrainWakeSocket(Socket s) {
+    char drain[64];
+    while (recv(s, drain, sizeof(drain), 0) > 0) {}
+}
+
+// ------------------------------------------
+// 就绪等待：水平触发，每个套接字带一个 tag (nullptr 留给唤醒套接字)
+// ------------------------------------------
+const unsigned kPollRead = 1;
+const unsigned kPollWrite = 2;
+
+struct PollEvent {
+    void* tag;
+    bool readable;
+    bool writable;
+    bool error;      // 出错或对端挂断；调用者通过读写拿到具体错误
+};
+
+#ifdef __linux__
+class Poller {
+private:
+    int ep;
+
+    bool Control(int op, Socket s, void* tag, unsigned interest) {
+        epoll_event ev{};
+        ev.events = ((interest & kPollRead) ? EPOLLIN | EPOLLRDHUP : 0u) | ((interest & kPollWrite) ? EPOLLOUT : 0u);
+        ev.data.ptr = tag;
+        return epoll_ctl(ep, op, s, &ev) == 0;
+    }
+
+public:
+    Poller() : ep(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~Poller() { if (ep >= 0) ::close(ep); }
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    bool Add(Socket s, void* tag, unsigned interest) { return Control(EPOLL_CTL_ADD, s, tag, interest); }
+    bool Modify(Socket s, void* tag, unsigned interest) { return Control(EPOLL_CTL_MOD, s, tag, interest); }
+    void Remove(Socket s) {
+        epoll_event ev{};
+        epoll_ctl(ep, EPOLL_CTL_DEL, s, &ev);
+    }
+
+    void Wait(int timeoutMs, std::vector<PollEvent>& out) {
+        epoll_event events[256];
+        int n = epoll_wait(ep, events, 256, timeoutMs);
+        for (int i = 0; i < n; ++i) {
+            uint32_t e = events[i].events;
+            out.push_back({ events[i].data.ptr, (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0,
+                (e & EPOLLOUT) != 0, (e & (EPOLLERR | EPOLLHUP)) != 0 });
+        }
+    }
+};
+#else
+// 其他平台用 poll / WSAPoll：每次等待重建 pollfd 数组，套接字不多时足够
+class Poller {
+private:
+    struct Entry {
+        Socket socket;
+        void* tag;
+        unsigned interest;
+    };
+    std::vector<Entry> entries;
+    std::vector<pollfd> fds;
+
+public:
+    Poller() = default;
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    bool Add(Socket s, void* tag, unsigned interest) {
+        entries.push_back({ s, tag, interest });
+        return true;
+    }
+    bool Modify(Socket s, void* tag, unsigned interest) {
+        for (auto& e : entries) {
+            if (e.socket == s) { e.tag = tag; e.interest = interest; return true; }
+        }
+        return false;
+    }
+    void Remove(Socket s) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+            [s](const Entry& e) { return e.socket == s; }), entries.end());
+    }
+
+    void Wait(int timeoutMs, std::vector<PollEvent>& out) {
+        fds.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            fds[i].fd = entries[i].socket;
+            fds[i].events = static_cast<short>(((entries[i].interest & kPollRead) ? POLLIN : 0) |
+                ((entries[i].interest & kPollWrite) ? POLLOUT : 0));
+            fds[i].revents = 0;
+        }
+#ifdef _WIN32
+        int n = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+        int n = ::poll(fds.data(), fds.size(), timeoutMs);
+#endif
+        for (size_t i = 0; i < fds.size() && n > 0; ++i) {
+            short e = fds[i].revents;
+            if (e == 0) continue;
+            --n;
+            out.push_back({ entries[i].tag, (e & (POLLIN | POLLHUP)) != 0,
+                (e & POLLOUT) != 0, (e & (POLLERR | POLLHUP | POLLNVAL)) != 0 });
+        }
+    }
+};
+#endif
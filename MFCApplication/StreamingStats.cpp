@@ -0,0 +1,244 @@
+﻿#include "StreamingStats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// ==========================================
+// RunningStats
+// ==========================================
+
+namespace {
+const size_t kLanes = 8;    // 块内并行的累加路数 (AVX-512 一个寄存器 / AVX2 两个寄存器)
+const size_t kBlock = 1024; // 块大小：两遍扫描时第二遍仍命中 L1
+}
+
+RunningStats::RunningStats()
+    : count(0), mean(0.0), m2(0.0), min(std::numeric_limits<double>::infinity()),
+      max(-std::numeric_limits<double>::infinity()) {
+}
+
+void RunningStats::Add(double x) {
+    ++count;
+    double delta = x - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (x - mean);
+    if (x < min) min = x;
+    if (x > max) max = x;
+}
+
+// Chan 等人的合并公式：两组的均值差按权重修正平方和
+void RunningStats::MergeBlock(uint64_t n, double blockMean, double blockM2, double blockMin, double blockMax) {
+    if (n == 0) return;
+    if (blockMin < min) min = blockMin;
+    if (blockMax > max) max = blockMax;
+    if (count == 0) {
+        count = n;
+        mean = blockMean;
+        m2 = blockM2;
+        return;
+    }
+    double na = static_cast<double>(count);
+    double nb = static_cast<double>(n);
+    double total = na + nb;
+    double delta = blockMean - mean;
+    mean += delta * (nb / total);
+    m2 += blockM2 + delta * delta * (na * nb / total);
+    count += n;
+}
+
+void RunningStats::AddBatch(const double* data, size_t n) {
+    for (size_t start = 0; start < n; start += kBlock) {
+        const double* x = data + start;
+        size_t len = (std::min)(kBlock, n - start);
+        size_t body = len / kLanes * kLanes;
+
+        // 第一遍：各路独立求和与最值，没有跨迭代依赖
+        double sum[kLanes] = {};
+        double lo[kLanes], hi[kLanes];
+        for (size_t j = 0; j < kLanes; ++j) {
+            lo[j] = std::numeric_limits<double>::infinity();
+            hi[j] = -std::numeric_limits<double>::infinity();
+        }
+        for (size_t i = 0; i < body; i += kLanes) {
+            for (size_t j = 0; j < kLanes; ++j) {
+                double v = x[i + j];
+                sum[j] += v;
+                lo[j] = v < lo[j] ? v : lo[j];
+                hi[j] = v > hi[j] ? v : hi[j];
+            }
+        }
+        for (size_t i = body; i < len; ++i) {
+            sum[0] += x[i];
+            lo[0] = x[i] < lo[0] ? x[i] : lo[0];
+            hi[0] = x[i] > hi[0] ? x[i] : hi[0];
+        }
+        double total = 0.0, blockMin = lo[0], blockMax = hi[0];
+        for (size_t j = 0; j < kLanes; ++j) {
+            total += sum[j];
+            blockMin = (std::min)(blockMin, lo[j]);
+            blockMax = (std::max)(blockMax, hi[j]);
+        }
+        double blockMean = total / static_cast<double>(len);
+
+        // 第二遍 (数据仍在 L1)：以块均值为中心的平方和
+        // 同时累加偏差本身，用 (Σd)² / n 补偿块均值的舍入误差 (修正两遍算法)
+        double sq[kLanes] = {};
+        double comp[kLanes] = {};
+        for (size_t i = 0; i < body; i += kLanes) {
+            for (size_t j = 0; j < kLanes; ++j) {
+                double d = x[i + j] - blockMean;
+                sq[j] += d * d;
+                comp[j] += d;
+            }
+        }
+        for (size_t i = body; i < len; ++i) {
+            double d = x[i] - blockMean;
+            sq[0] += d * d;
+            comp[0] += d;
+        }
+        double sqTotal = 0.0, compTotal = 0.0;
+        for (size_t j = 0; j < kLanes; ++j) {
+            sqTotal += sq[j];
+            compTotal += comp[j];
+        }
+        double blockM2 = sqTotal - compTotal * compTotal / static_cast<double>(len);
+
+        MergeBlock(len, blockMean, (std::max)(blockM2, 0.0), blockMin, blockMax);
+    }
+}
+
+void RunningStats::Merge(const RunningStats& other) {
+    MergeBlock(other.count, other.mean, other.m2, other.min, other.max);
+}
+
+double RunningStats::Variance() const {
+    return count > 0 ? m2 / static_cast<double>(count) : 0.0;
+}
+
+double RunningStats::SampleVariance() const {
+    return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0;
+}
+
+double RunningStats::StdDev() const {
+    return std::sqrt(SampleVariance());
+}
+
+// ==========================================
+// KllSketch
+// ==========================================
+
+KllSketch::KllSketch(size_t kParam)
+    : k((std::max)(kParam, size_t(8))), levels(1), count(0), retained(0), capacity(0),
+      min(std::numeric_limits<double>::infinity()), max(-std::numeric_limits<double>::infinity()),
+      coin(0x9E3779B97F4A7C15ull) {
+    UpdateCapacity();
+}
+
+// 最上层容量为 k，往下每层乘 2/3，最少 8 个 (底层太小会导致几乎每次插入都要排序压缩)
+void KllSketch::UpdateCapacity() {
+    levelCapacity.resize(levels.size());
+    capacity = 0;
+    for (size_t h = 0; h < levels.size(); ++h) {
+        size_t depth = levels.size() - 1 - h;
+        double cap = static_cast<double>(k) * std::pow(2.0 / 3.0, static_cast<double>(depth));
+        levelCapacity[h] = (std::max)(static_cast<size_t>(std::ceil(cap)), size_t(8));
+        capacity += levelCapacity[h];
+    }
+}
+
+// 压缩最低的一个满层：排序后随机保留奇数位或偶数位升入上一层，权重翻倍，总秩保持无偏
+void KllSketch::CompactOne() {
+    size_t h = 0;
+    while (h < levels.size() && levels[h].size() < levelCapacity[h]) ++h;
+    if (h == levels.size()) return;
+    if (h + 1 == levels.size()) {
+        levels.emplace_back();
+        UpdateCapacity();
+    }
+
+    std::vector<double>& level = levels[h];
+    std::sort(level.begin(), level.end());
+    // 奇数个时留下最大的一个，剩下的成对压缩
+    double leftover = 0.0;
+    bool hasLeftover = (level.size() % 2) != 0;
+    if (hasLeftover) {
+        leftover = level.back();
+        level.pop_back();
+    }
+
+    coin ^= coin << 13;
+    coin ^= coin >> 7;
+    coin ^= coin << 17;
+    size_t offset = static_cast<size_t>(coin & 1);
+
+    std::vector<double>& above = levels[h + 1];
+    for (size_t i = offset; i < level.size(); i += 2) above.push_back(level[i]);
+    retained -= level.size() / 2;
+    level.clear();
+    if (hasLeftover) level.push_back(leftover);
+}
+
+void KllSketch::Compress() {
+    while (retained > capacity) CompactOne();
+}
+
+void KllSketch::AddBatch(const double* data, size_t n) {
+    for (size_t i = 0; i < n; ++i) Add(data[i]);
+}
+
+void KllSketch::Merge(const KllSketch& other) {
+    if (other.count == 0) return;
+    if (&other == this) {
+        KllSketch copy(other); // 自身合并：插入时源区间不能属于被插入的同一层
+        Merge(copy);
+        return;
+    }
+    while (levels.size() < other.levels.size()) levels.emplace_back();
+    for (size_t h = 0; h < other.levels.size(); ++h) {
+        levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+    }
+    count += other.count;
+    retained += other.retained;
+    min = (std::min)(min, other.min);
+    max = (std::max)(max, other.max);
+    UpdateCapacity();
+    Compress();
+}
+
+std::vector<double> KllSketch::Quantiles(const std::vector<double>& qs) const {
+    std::vector<double> out(qs.size(), 0.0);
+    if (count == 0) return out;
+
+    // (值, 权重) 按值排序后累加权重，第一个累计权重达到 q × 总权重的值即为所求
+    std::vector<std::pair<double, uint64_t>> items;
+    items.reserve(retained);
+    uint64_t totalWeight = 0;
+    for (size_t h = 0; h < levels.size(); ++h) {
+        uint64_t weight = uint64_t(1) << h;
+        for (double v : levels[h]) items.emplace_back(v, weight);
+        totalWeight += weight * levels[h].size();
+    }
+    std::sort(items.begin(), items.end());
+
+    for (size_t i = 0; i < qs.size(); ++i) {
+        double q = qs[i];
+        if (q <= 0.0) { out[i] = min; continue; }
+        if (q >= 1.0) { out[i] = max; continue; }
+        double target = q * static_cast<double>(totalWeight);
+        uint64_t cumulative = 0;
+        out[i] = items.back().first;
+        for (const auto& item : items) {
+            cumulative += item.second;
+            if (static_cast<double>(cumulative) >= target) {
+                out[i] = item.first;
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+double KllSketch::Quantile(double q) const {
+    return Quantiles(std::vector<double>(1, q))[0];
+}
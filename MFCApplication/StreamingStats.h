@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 单遍流式统计：数据按块到达，任何时候都不需要把全部输入放进内存
+// 每个线程各自累加一份，最后用 Merge() 合并；合并结果与顺序处理全部数据等价 (分位数为近似值)
+
+// 均值 / 方差 / 最值
+// 单个值按 Welford 递推；批量输入按块处理：块内多路并行求和与最值 (编译器可向量化)，
+// 以块均值为中心求平方和并做补偿，再按 Chan 的公式并入总量，长序列上也不会出现大数相消
+class RunningStats {
+private:
+    uint64_t count;
+    double mean;
+    double m2;      // 与均值之差的平方和
+    double min;
+    double max;
+
+    void MergeBlock(uint64_t n, double blockMean, double blockM2, double blockMin, double blockMax);
+
+public:
+    RunningStats();
+
+    void Add(double x);
+    void AddBatch(const double* data, size_t n);
+    void Merge(const RunningStats& other);
+
+    uint64_t Count() const { return count; }
+    double Mean() const { return mean; }
+    double Variance() const;          // 总体方差 (除以 n)
+    double SampleVariance() const;    // 样本方差 (除以 n - 1)
+    double StdDev() const;
+    double Min() const { return min; }
+    double Max() const { return max; }
+};
+
+// KLL 分位数草图：固定内存 (约 3 × k 个值)，秩误差约 1.7 / k，可以合并
+// 第 h 层的每个值代表 2^h 个原始样本；某层满了就排序后随机保留奇数位或偶数位，一半升入上一层
+class KllSketch {
+private:
+    size_t k;
+    std::vector<std::vector<double>> levels;
+    std::vector<size_t> levelCapacity; // 随层数变化，层数改变时重新计算
+    uint64_t count;
+    size_t retained;   // 所有层的值的总数
+    size_t capacity;   // 当前层数下允许保留的总数，超过时压缩
+    double min;
+    double max;
+    uint64_t coin;     // 压缩时选奇偶位的随机位 (xorshift)
+
+    void UpdateCapacity();
+    void CompactOne();
+    void Compress();
+
+public:
+    explicit KllSketch(size_t k = 200);
+
+    // NaN 无法排序 (会破坏压缩时的 std::sort)，直接忽略，不计入 Count()
+    void Add(double x) {
+        if (std::isnan(x)) return;
+        levels[0].push_back(x);
+        if (x < min) min = x;
+        if (x > max) max = x;
+        ++count;
+        if (++retained > capacity) Compress();
+    }
+    void AddBatch(const double* data, size_t n);
+    // 各层权重只取决于层号，k 不同的草图也可以合并：结果沿用本草图的 k，误差以两者中较小的 k 为准
+    void Merge(const KllSketch& other);
+
+    // q ∈ [0, 1]；空草图返回 0
+    double Quantile(double q) const;
+    // 一次排序回答多个分位数
+    std::vector<double> Quantiles(const std::vector<double>& qs) const;
+
+    size_t K() const { return k; }
+    uint64_t Count() const { return count; }
+    size_t Retained() const { return retained; }
+};
+
+// 矩统计 + 分位数草图
+struct StreamingStats {
+    RunningStats moments;
+    KllSketch quantiles;
+
+    void AddBatch(const double* data, size_t n) {
+        moments.AddBatch(data, n);
+        quantiles.AddBatch(data, n);
+    }
+    void Merge(const StreamingStats& other) {
+        moments.Merge(other.moments);
+        quantiles.Merge(other.quantiles);
+    }
+};
@@ -0,0 +1,257 @@
+﻿#include "TaskGraph.h"
+#include "TaskScheduler.h"
+
+static const char* const kJoinName = "Graph Join";
+
+// 图节点在调度器中的包装：执行原任务，结束后通知图释放后继
+// 名称沿用原任务，日志与指标按原任务统计；没有任务的节点只起汇合作用
+class GraphNodeTask : public ITask {
+private:
+    std::shared_ptr<GraphExecution> execution;
+    TaskGraph::NodeId id;
+    std::shared_ptr<ITask> task;
+
+public:
+    GraphNodeTask(std::shared_ptr<GraphExecution> e, TaskGraph::NodeId nodeId, std::shared_ptr<ITask> t)
+        : execution(std::move(e)), id(nodeId), task(std::move(t)) {
+    }
+
+    void Execute() override {
+        if (!execution->MarkRunning(id)) {
+            execution->Abandon(id); // 图已取消
+            return;
+        }
+        try {
+            if (task) task->Execute();
+        }
+        catch (...) {
+            execution->Finish(id, false);
+            throw; // 仍由调度器记录失败
+        }
+        execution->Finish(id, true);
+    }
+
+    std::string GetName() const override { return task ? task->GetName() : kJoinName; }
+};
+
+// ==========================================
+// TaskGraph
+// ==========================================
+
+TaskGraph::NodeId TaskGraph::AddNode(std::shared_ptr<ITask> task, TaskPriority priority) {
+    nodes.push_back(Node{ std::move(task), priority, {}, 0 });
+    return nodes.size() - 1;
+}
+
+bool TaskGraph::Precede(NodeId before, NodeId after, DependencyKind kind) {
+    if (before >= nodes.size() || after >= nodes.size() || before == after) return false;
+    nodes[before].successors.push_back(Edge{ after, kind });
+    nodes[after].predecessors++;
+    return true;
+}
+
+bool TaskGraph::IsAcyclic() const {
+    std::vector<size_t> indegree(nodes.size());
+    std::vector<NodeId> ready;
+    for (NodeId i = 0; i < nodes.size(); ++i) {
+        indegree[i] = nodes[i].predecessors;
+        if (indegree[i] == 0) ready.push_back(i);
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+        NodeId n = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (const auto& edge : nodes[n].successors) {
+            if (--indegree[edge.to] == 0) ready.push_back(edge.to);
+        }
+    }
+    return visited == nodes.size();
+}
+
+std::shared_ptr<GraphExecution> TaskGraph::Submit(TaskScheduler& scheduler) const {
+    if (!IsAcyclic()) {
+        scheduler.GetLogger().Write("[Graph] Rejected graph with a dependency cycle");
+        return nullptr;
+    }
+    auto execution = std::make_shared<GraphExecution>(*this, scheduler);
+    execution->Start();
+    return execution;
+}
+
+// ==========================================
+// GraphExecution
+// ==========================================
+
+GraphExecution::GraphExecution(const TaskGraph& graph, TaskScheduler& s)
+    : nodes(graph.nodes), runtime(new Runtime[graph.nodes.size()]), scheduler(s),
+      remaining(graph.nodes.size()), succeeded(0), failed(0), skipped(0), cancelled(false),
+      handles(graph.nodes.size()), done(graph.nodes.empty()) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        runtime[i].pending.store(nodes[i].predecessors, std::memory_order_relaxed);
+        runtime[i].blocked.store(false, std::memory_order_relaxed);
+        runtime[i].state.store(static_cast<uint8_t>(NodeState::Pending), std::memory_order_relaxed);
+    }
+}
+
+void GraphExecution::Start() {
+    std::vector<TaskGraph::NodeId> roots;
+    for (TaskGraph::NodeId i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].predecessors == 0) roots.push_back(i);
+    }
+    scheduler.GetLogger().Write("[Graph] Submitted " + std::to_string(nodes.size()) + " tasks, " +
+        std::to_string(roots.size()) + " ready");
+    Dispatch(roots);
+}
+
+void GraphExecution::Dispatch(const std::vector<TaskGraph::NodeId>& ready) {
+    if (ready.empty()) return;
+    if (cancelled) {
+        for (TaskGraph::NodeId id : ready) Abandon(id);
+        return;
+    }
+    std::vector<TaskSpec> specs;
+    specs.reserve(ready.size());
+    auto self = shared_from_this(); // 包装任务持有执行状态，图执行完之前不会被释放
+    for (TaskGraph::NodeId id : ready) {
+        TaskSpec spec;
+        spec.task = std::make_shared<GraphNodeTask>(self, id, nodes[id].task);
+        spec.priority = nodes[id].priority;
+        specs.push_back(std::move(spec));
+    }
+    std::vector<TaskHandle> submitted = scheduler.AddTasks(specs); // 在工作线程上调用时直接进入本地队列，空闲线程窃取后并行执行
+    {
+        // 根节点由 Start 提交，可能整张图都已结束、句柄已清空，此时不再登记
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        if (remaining.load() != 0) {
+            for (size_t i = 0; i < ready.size(); ++i) handles[ready[i]] = submitted[i];
+        }
+    }
+    // 与 Cancel 交错时：要么它看到这里登记的句柄，要么这里看到已取消
+    if (cancelled) {
+        for (size_t i = 0; i < ready.size(); ++i) {
+            submitted[i].Cancel();
+            Abandon(ready[i]);
+        }
+    }
+}
+
+void GraphExecution::Cancel() {
+    if (cancelled.exchange(true)) return;
+    scheduler.GetLogger().Write("[Graph] Cancelled graph execution");
+
+    // 已提交的节点：撤销队列中的条目并直接记为跳过 (已开始执行的节点 Abandon 不生效，照常完成)
+    std::vector<std::pair<TaskGraph::NodeId, TaskHandle>> submitted;
+    {
+        std::lock_guard<std::mutex> lock(handlesMutex);
+        for (TaskGraph::NodeId id = 0; id < handles.size(); ++id) {
+            if (handles[id].IsValid()) submitted.emplace_back(id, handles[id]);
+        }
+    }
+    for (auto& [id, handle] : submitted) {
+        handle.Cancel();
+        Abandon(id);
+    }
+}
+
+bool GraphExecution::MarkRunning(TaskGraph::NodeId id) {
+    if (cancelled) return false;
+    uint8_t expected = static_cast<uint8_t>(NodeState::Pending);
+    return runtime[id].state.compare_exchange_strong(expected, static_cast<uint8_t>(NodeState::Running),
+        std::memory_order_relaxed);
+}
+
+void GraphExecution::Finish(TaskGraph::NodeId id, bool ok) {
+    runtime[id].state.store(static_cast<uint8_t>(ok ? NodeState::Succeeded : NodeState::Failed),
+        std::memory_order_release);
+    (ok ? succeeded : failed).fetch_add(1);
+
+    std::vector<TaskGraph::NodeId> ready;
+    size_t ended = Propagate(id, ok, false, ready);
+    Dispatch(ready);
+    Settle(ended);
+}
+
+void GraphExecution::Abandon(TaskGraph::NodeId id) {
+    uint8_t expected = static_cast<uint8_t>(NodeState::Pending);
+    if (!runtime[id].state.compare_exchange_strong(expected, static_cast<uint8_t>(NodeState::Skipped),
+        std::memory_order_acq_rel)) {
+        return; // 已经执行或已经结束
+    }
+    skipped.fetch_add(1);
+
+    std::vector<TaskGraph::NodeId> ready;
+    size_t ended = Propagate(id, false, true, ready); // 被放弃的节点阻塞所有后继，ready 一定为空
+    Settle(ended);
+}
+
+size_t GraphExecution::Propagate(TaskGraph::NodeId id, bool ok, bool abandoned,
+    std::vector<TaskGraph::NodeId>& ready) {
+    // 被跳过的节点同样要通知它的后继，用工作表代替递归
+    // 失败的节点只阻塞 OnSuccess 后继；被放弃的节点没有真正结束，阻塞全部后继
+    std::vector<std::pair<TaskGraph::NodeId, bool>> finished{ { id, ok } };
+    size_t ended = 0;
+    while (!finished.empty()) {
+        auto [node, nodeOk] = finished.back();
+        finished.pop_back();
+        ++ended;
+        for (const auto& edge : nodes[node].successors) {
+            Runtime& next = runtime[edge.to];
+            if (abandoned || (!nodeOk && edge.kind == DependencyKind::OnSuccess)) {
+                next.blocked.store(true, std::memory_order_relaxed); // 随下面的 acq_rel 递减对释放者可见
+            }
+            if (next.pending.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+
+            // 最后一个前驱：由本线程决定执行还是跳过
+            if (next.blocked.load(std::memory_order_relaxed)) {
+                next.state.store(static_cast<uint8_t>(NodeState::Skipped), std::memory_order_release);
+                skipped.fetch_add(1);
+                if (!abandoned) {
+                    const auto& task = nodes[edge.to].task;
+                    scheduler.GetLogger().Write("[Graph] Skipped task (dependency failed): " +
+                        (task ? task->GetName() : std::string(kJoinName)));
+                }
+                finished.emplace_back(edge.to, false);
+            }
+            else {
+                ready.push_back(edge.to);
+            }
+        }
+    }
+    return ended;
+}
+
+void GraphExecution::Settle(size_t ended) {
+    if (remaining.fetch_sub(ended, std::memory_order_acq_rel) == ended) {
+        // 句柄经任务控制块引用本执行，这里释放以免循环引用
+        {
+            std::lock_guard<std::mutex> lock(handlesMutex);
+            handles.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done = true;
+        }
+        doneCv.notify_all();
+    }
+}
+
+void GraphExecution::Wait() {
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCv.wait(lock, [this] { return done; });
+}
+
+bool GraphExecution::WaitFor(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(doneMutex);
+    return doneCv.wait_for(lock, timeout, [this] { return done; });
+}
+
+bool GraphExecution::IsDone() const {
+    std::lock_guard<std::mutex> lock(doneMutex);
+    return done;
+}
+
+NodeState GraphExecution::GetState(TaskGraph::NodeId id) const {
+    if (id >= nodes.size()) return NodeState::Pending;
+    return static_cast<NodeState>(runtime[id].state.load(std::memory_order_acquire));
+}
@@ -0,0 +1,134 @@
+﻿#pragma once
+#include "ITask.h"
+#include "TaskHandle.h"
+#include "TaskPriority.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class TaskScheduler;
+class GraphExecution;
+
+// 依赖类型
+// OnSuccess:    前驱成功后才执行，前驱失败 (或被跳过) 时本节点及其后继被跳过
+// OnCompletion: 前驱结束后就执行，不论成败 (例如清理、验证类任务)
+enum class DependencyKind {
+    OnSuccess,
+    OnCompletion
+};
+
+enum class NodeState : uint8_t {
+    Pending,
+    Running,
+    Succeeded,
+    Failed,
+    Skipped
+};
+
+// 对应设计模式：Builder (建造者)
+// 任务依赖图 (DAG)：先描述节点和依赖，再整体提交给调度器执行
+// 同一张图可以多次提交，每次提交得到一个独立的 GraphExecution
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    // task 为空的节点不执行任何操作，只用来汇合多条分支
+    NodeId AddNode(std::shared_ptr<ITask> task, TaskPriority priority = TaskPriority::Normal);
+
+    // before 结束后才能执行 after；编号无效或自环时返回 false
+    bool Precede(NodeId before, NodeId after, DependencyKind kind = DependencyKind::OnSuccess);
+
+    size_t Size() const { return nodes.size(); }
+
+    // 拓扑排序检查是否有环
+    bool IsAcyclic() const;
+
+    // 提交：没有前驱的节点立即进入调度器，其余节点在最后一个前驱结束时释放
+    // 有环时返回 nullptr；调度器需已启动
+    std::shared_ptr<GraphExecution> Submit(TaskScheduler& scheduler) const;
+
+private:
+    friend class GraphExecution;
+
+    struct Edge {
+        NodeId to;
+        DependencyKind kind;
+    };
+
+    struct Node {
+        std::shared_ptr<ITask> task;
+        TaskPriority priority;
+        std::vector<Edge> successors;
+        size_t predecessors;
+    };
+
+    std::vector<Node> nodes;
+};
+
+// 一次图执行的状态
+// 每个节点一个原子计数 (未结束的前驱数)，前驱结束时递减，减到 0 的线程负责释放该节点：
+// 不轮询、不加全局锁；同时就绪的独立分支一次批量提交，由各工作线程并行执行
+// 图被取消后尚未开始的节点记为跳过，依赖它们的后继也都被跳过，Wait() 不会因此卡住
+class GraphExecution : public std::enable_shared_from_this<GraphExecution> {
+public:
+    // 等待所有节点结束 (成功、失败或被跳过)
+    // 已提交的节点要等调度器执行；调度器没有运行时请用 WaitFor 或先 Cancel
+    void Wait();
+    bool WaitFor(std::chrono::milliseconds timeout);
+    bool IsDone() const;
+
+    // 取消尚未开始的节点：已入队的撤销，尚未释放的不再释放，都记为跳过；正在执行的节点照常完成
+    void Cancel();
+    bool IsCancelled() const { return cancelled.load(); }
+
+    NodeState GetState(TaskGraph::NodeId id) const;
+    size_t SucceededCount() const { return succeeded.load(); }
+    size_t FailedCount() const { return failed.load(); }
+    size_t SkippedCount() const { return skipped.load(); }
+
+    GraphExecution(const TaskGraph& graph, TaskScheduler& scheduler);
+
+private:
+    friend class TaskGraph;
+    friend class GraphNodeTask;
+
+    struct Runtime {
+        std::atomic<size_t> pending;   // 尚未结束的前驱数
+        std::atomic<bool> blocked;     // 有 OnSuccess 前驱没有成功
+        std::atomic<uint8_t> state;    // NodeState
+    };
+
+    std::vector<TaskGraph::Node> nodes;   // 提交时拷贝的拓扑，执行期间只读
+    std::unique_ptr<Runtime[]> runtime;
+    TaskScheduler& scheduler;
+
+    std::atomic<size_t> remaining;        // 尚未结束的节点数
+    std::atomic<size_t> succeeded;
+    std::atomic<size_t> failed;
+    std::atomic<size_t> skipped;
+    std::atomic<bool> cancelled;
+
+    std::mutex handlesMutex;              // 保护 handles (提交与取消时使用，不在热路径上)
+    std::vector<TaskHandle> handles;      // 每个已提交节点在调度器中的句柄，供 Cancel 撤销
+
+    mutable std::mutex doneMutex;
+    std::condition_variable doneCv;
+    bool done;
+
+    void Start();
+    // Pending -> Running；图已取消或节点已被跳过时返回 false，不应再执行
+    bool MarkRunning(TaskGraph::NodeId id);
+    // 节点结束 (在执行它的工作线程上调用)：递减后继的计数，释放就绪的后继
+    void Finish(TaskGraph::NodeId id, bool ok);
+    // 已释放的节点因图被取消而不再执行：记为跳过并向下传递，不提交任何任务
+    void Abandon(TaskGraph::NodeId id);
+    // 从一个已结束的节点向下传递，返回结束的节点数；ready 收集可以执行的后继
+    size_t Propagate(TaskGraph::NodeId id, bool ok, bool abandoned, std::vector<TaskGraph::NodeId>& ready);
+    void Settle(size_t ended);
+    void Dispatch(const std::vector<TaskGraph::NodeId>& ready);
+};
@@ -0,0 +1,69 @@
+﻿#pragma once
+#include "ITask.h"
+#include "TaskPriority.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// 周期任务的续期方式
+// FixedDelay: 下一次 = 本次执行结束 + 间隔，执行耗时会累积成漂移
+// FixedRate:  下一次 = 本次计划时间 + 间隔，不漂移；错过的周期直接跳过，不会连发补齐
+enum class PeriodicMode {
+    FixedDelay,
+    FixedRate
+};
+
+// 任务控制块：由句柄与队列中的 ScheduledTask 共享
+// 定时器队列不支持随机删除，取消/重新调度采用"惰性删除"：
+// 只修改控制块，旧的队列条目在出队或压缩时被识别并丢弃
+struct TaskControl {
+    uint64_t id;
+    std::shared_ptr<ITask> task;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;        // 已执行完且没有待执行的条目 (一次性任务跑完，或周期任务不再续期)
+    std::atomic<uint64_t> generation;  // 每次重新调度 +1，代数不符的队列条目即为失效条目
+    std::atomic<bool> periodic;
+    std::atomic<int> intervalMs;       // 周期间隔，下一次续期时生效
+    PeriodicMode mode;
+    TaskPriority priority;
+    int deadlineMs;                    // 相对到期时间的截止期限 (最迟开始)，0 表示没有
+    uint32_t nameId;                   // 事件日志中登记的名称编号，0 表示未登记
+    uint32_t metricId;                 // 指标注册表中的任务类型编号
+    bool quiet;                        // 内部延续 (协程恢复)：不写添加/开始/完成日志与事件，不通知观察者
+    bool timerQueued;                  // 当前代的条目是否还在定时器队列中 (由 queueMutex 保护)，取消时据此计数失效条目
+
+    TaskControl(uint64_t taskId, std::shared_ptr<ITask> t, bool isPeriodic, int interval,
+        PeriodicMode periodicMode = PeriodicMode::FixedDelay)
+        : id(taskId), task(std::move(t)), cancelled(false), finished(false), generation(0), periodic(isPeriodic), intervalMs(interval),
+          mode(periodicMode), priority(TaskPriority::Normal), deadlineMs(0), nameId(0), metricId(0),
+          quiet(false), timerQueued(false) {
+    }
+};
+
+// AddTask 返回的轻量句柄 (只持有一个 shared_ptr)，可随意拷贝
+// 所有操作都是 O(1)：只改控制块，必要时向定时器队列插入一个新条目
+class TaskHandle {
+private:
+    std::shared_ptr<TaskControl> control;
+
+public:
+    TaskHandle() = default;
+    explicit TaskHandle(std::shared_ptr<TaskControl> c) : control(std::move(c)) {}
+
+    bool IsValid() const { return control != nullptr; }
+    uint64_t GetId() const { return control ? control->id : 0; }
+    bool IsCancelled() const { return control && control->cancelled; }
+    bool IsFinished() const { return control && control->finished; }
+
+    // 取消任务：尚未执行的不再执行，周期任务不再续期
+    bool Cancel();
+
+    // 重新调度：从现在起 delayMs 毫秒后执行，原来的计划作废
+    // 已取消或已结束 (IsFinished) 的任务返回 false，不会被复活；执行中的任务可以重新调度
+    bool Reschedule(int delayMs);
+
+    // 修改周期任务的间隔，下一次续期时生效
+    bool SetInterval(int intervalMs);
+
+    const std::shared_ptr<TaskControl>& GetControl() const { return control; }
+};
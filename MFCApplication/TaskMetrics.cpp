@@ -0,0 +1,317 @@
+﻿#include "TaskMetrics.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static std::atomic<uint64_t> nextRegistrySerial(1);
+
+TaskMetrics::TaskMetrics()
+    : serial(nextRegistrySerial.fetch_add(1)), createdAt(std::chrono::steady_clock::now()),
+      stopDump(false), dumpInterval(0), dumpFormat(MetricsFormat::Json) {
+}
+
+TaskMetrics::~TaskMetrics() {
+    StopPeriodicDump();
+}
+
+// 登记任务类型
+uint32_t TaskMetrics::Register(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) return it->second;
+
+    if (names.size() >= kMaxTaskTypes - 1) {
+        // 类型过多：其余的合并到最后一个编号，分片大小保持固定
+        if (names.size() < kMaxTaskTypes) names.push_back("(other)");
+        return kMaxTaskTypes - 1;
+    }
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    nameIds[name] = id;
+    return id;
+}
+
+std::string TaskMetrics::GetName(uint32_t typeId) const {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return typeId < names.size() ? names[typeId] : std::string();
+}
+
+// 取一个空闲分片 (之前的线程已退出)，没有就新建
+std::shared_ptr<TaskMetrics::Shard> TaskMetrics::AcquireShard() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& shard : shards) {
+        bool expected = false;
+        if (shard->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return shard;
+        }
+    }
+    shards.push_back(std::make_shared<Shard>());
+    return shards.back();
+}
+
+// 当前线程的分片：第一次记录时取得，线程退出时归还
+// 线程局部变量持有 shared_ptr，即使注册表先析构，分片也不会悬空
+TaskMetrics::Shard& TaskMetrics::LocalShard() {
+    struct Slot {
+        uint64_t owner = 0;
+        std::shared_ptr<Shard> shard;
+        ~Slot() {
+            if (shard) shard->inUse.store(false, std::memory_order_release);
+        }
+    };
+    static thread_local Slot slot;
+
+    if (slot.owner != serial) {
+        if (slot.shard) slot.shard->inUse.store(false, std::memory_order_release);
+        slot.shard = AcquireShard();
+        slot.owner = serial;
+    }
+    return *slot.shard;
+}
+
+// 记录一次执行：只触碰本线程的分片
+void TaskMetrics::Record(uint32_t typeId, size_t priorityClass, std::chrono::nanoseconds queueDelay,
+    std::chrono::nanoseconds execTime, bool failed, bool missedDeadline) {
+    if (typeId >= kMaxTaskTypes) typeId = kMaxTaskTypes - 1;
+    if (priorityClass >= kPriorityClasses) priorityClass = kPriorityClasses - 1;
+
+    Shard& shard = LocalShard();
+    Cell* cell = shard.cells[typeId].load(std::memory_order_relaxed);
+    if (cell == nullptr) {
+        cell = new Cell();
+        shard.cells[typeId].store(cell, std::memory_order_release); // 读者用 acquire 读到完整构造的 Cell
+    }
+
+    uint64_t delayNs = queueDelay.count() > 0 ? static_cast<uint64_t>(queueDelay.count()) : 0;
+    cell->queueDelay.Record(delayNs);
+    ClassCell& cls = shard.classes[priorityClass];
+    cls.queueDelay.Record(delayNs);
+    if (missedDeadline) {
+        cls.deadlineMisses.store(cls.deadlineMisses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    cell->execTime.Record(execTime.count() > 0 ? static_cast<uint64_t>(execTime.count()) : 0);
+    if (failed) {
+        cell->failures.store(cell->failures.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+// 合并所有分片
+MetricsSnapshot TaskMetrics::Snapshot() const {
+    MetricsSnapshot snapshot;
+    snapshot.takenAt = std::chrono::steady_clock::now();
+    snapshot.uptimeSec = std::chrono::duration<double>(snapshot.takenAt - createdAt).count();
+
+    // 锁内只复制名称和分片列表 (分片由 shared_ptr 保活)，合并直方图放在锁外，不挡住新任务类型的登记
+    std::vector<std::shared_ptr<Shard>> shardList;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        snapshot.types.resize(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            snapshot.types[i].name = names[i];
+        }
+        shardList = shards;
+    }
+    snapshot.classes.resize(kPriorityClasses);
+    for (size_t c = 0; c < kPriorityClasses; ++c) {
+        snapshot.classes[c].name = PriorityName(c);
+    }
+    for (const auto& shard : shardList) {
+        for (size_t c = 0; c < kPriorityClasses; ++c) {
+            shard->classes[c].queueDelay.MergeInto(snapshot.classes[c].queueDelay);
+            snapshot.classes[c].deadlineMisses += shard->classes[c].deadlineMisses.load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < snapshot.types.size(); ++i) {
+            const Cell* cell = shard->cells[i].load(std::memory_order_acquire);
+            if (cell == nullptr) continue;
+            cell->queueDelay.MergeInto(snapshot.types[i].queueDelay);
+            cell->execTime.MergeInto(snapshot.types[i].execTime);
+            snapshot.types[i].failures += cell->failures.load(std::memory_order_relaxed);
+        }
+    }
+    for (auto& type : snapshot.types) {
+        type.completed = type.execTime.count;
+        type.ratePerSec = snapshot.uptimeSec > 0.0 ? static_cast<double>(type.completed) / snapshot.uptimeSec : 0.0;
+    }
+    return snapshot;
+}
+
+void TaskMetrics::ComputeRecentRates(const MetricsSnapshot& previous, MetricsSnapshot& current) {
+    double elapsed = std::chrono::duration<double>(current.takenAt - previous.takenAt).count();
+    for (size_t i = 0; i < current.types.size(); ++i) {
+        uint64_t before = i < previous.types.size() ? previous.types[i].completed : 0;
+        uint64_t delta = current.types[i].completed - before;
+        current.types[i].recentPerSec = elapsed > 0.0 ? static_cast<double>(delta) / elapsed : 0.0;
+    }
+}
+
+// ==========================================
+// 导出格式
+// ==========================================
+
+static double ToMicros(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+std::string TaskMetrics::FormatText(const MetricsSnapshot& snapshot) {
+    std::string out;
+    char line[256];
+    std::snprintf(line, sizeof(line), "[Metrics] uptime %.1f s\n", snapshot.uptimeSec);
+    out += line;
+    std::snprintf(line, sizeof(line), "%-24s %10s %6s %9s %9s | %10s %10s %10s | %10s %10s %10s\n",
+        "task", "runs", "fail", "rate/s", "recent/s",
+        "queue p50", "p99", "max(us)", "exec p50", "p99", "max(us)");
+    out += line;
+    for (const auto& type : snapshot.types) {
+        std::snprintf(line, sizeof(line),
+            "%-24.24s %10llu %6llu %9.2f %9.2f | %10.1f %10.1f %10.1f | %10.1f %10.1f %10.1f\n",
+            type.name.c_str(),
+            static_cast<unsigned long long>(type.completed), static_cast<unsigned long long>(type.failures),
+            type.ratePerSec, type.recentPerSec,
+            ToMicros(type.queueDelay.Percentile(50)), ToMicros(type.queueDelay.Percentile(99)),
+            ToMicros(type.queueDelay.max),
+            ToMicros(type.execTime.Percentile(50)), ToMicros(type.execTime.Percentile(99)),
+            ToMicros(type.execTime.max));
+        out += line;
+    }
+    std::snprintf(line, sizeof(line), "%-24s %10s %10s | %10s %10s %10s\n",
+        "priority", "runs", "missed", "queue p50", "p99", "max(us)");
+    out += line;
+    for (const auto& cls : snapshot.classes) {
+        std::snprintf(line, sizeof(line), "%-24.24s %10llu %10llu | %10.1f %10.1f %10.1f\n",
+            cls.name.c_str(),
+            static_cast<unsigned long long>(cls.queueDelay.count), static_cast<unsigned long long>(cls.deadlineMisses),
+            ToMicros(cls.queueDelay.Percentile(50)), ToMicros(cls.queueDelay.Percentile(99)),
+            ToMicros(cls.queueDelay.max));
+        out += line;
+    }
+    return out;
+}
+
+static std::string JsonEscape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 2);
+    for (char ch : s) {
+        switch (ch) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(ch));
+                out += buf;
+            }
+            else {
+                out += ch;
+            }
+        }
+    }
+    return out;
+}
+
+static std::string JsonHistogram(const HistogramSnapshot& h) {
+    char buf[320];
+    std::snprintf(buf, sizeof(buf),
+        "{\"count\":%llu,\"mean\":%.3f,\"min\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f}",
+        static_cast<unsigned long long>(h.count), h.Mean() / 1000.0, ToMicros(h.Min()),
+        ToMicros(h.Percentile(50)), ToMicros(h.Percentile(90)), ToMicros(h.Percentile(99)),
+        ToMicros(h.Percentile(99.9)), ToMicros(h.max));
+    return buf;
+}
+
+std::string TaskMetrics::FormatJson(const MetricsSnapshot& snapshot) {
+    std::string out;
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "{\"uptimeSec\":%.3f,\"unit\":\"us\",\"tasks\":[", snapshot.uptimeSec);
+    out += buf;
+    for (size_t i = 0; i < snapshot.types.size(); ++i) {
+        const auto& type = snapshot.types[i];
+        if (i > 0) out += ",";
+        out += "\n  {\"name\":\"" + JsonEscape(type.name) + "\",";
+        std::snprintf(buf, sizeof(buf), "\"completed\":%llu,\"failures\":%llu,\"ratePerSec\":%.3f,\"recentPerSec\":%.3f,",
+            static_cast<unsigned long long>(type.completed), static_cast<unsigned long long>(type.failures),
+            type.ratePerSec, type.recentPerSec);
+        out += buf;
+        out += "\"queueDelay\":" + JsonHistogram(type.queueDelay) + ",";
+        out += "\"execTime\":" + JsonHistogram(type.execTime) + "}";
+    }
+    out += "\n],\"priorities\":[";
+    for (size_t i = 0; i < snapshot.classes.size(); ++i) {
+        const auto& cls = snapshot.classes[i];
+        if (i > 0) out += ",";
+        std::snprintf(buf, sizeof(buf), "\n  {\"name\":\"%s\",\"deadlineMisses\":%llu,", cls.name.c_str(),
+            static_cast<unsigned long long>(cls.deadlineMisses));
+        out += buf;
+        out += "\"queueDelay\":" + JsonHistogram(cls.queueDelay) + "}";
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+// ==========================================
+// 周期性导出
+// ==========================================
+
+bool TaskMetrics::StartPeriodicDump(const std::string& path, std::chrono::milliseconds interval, MetricsFormat format) {
+    StopPeriodicDump();
+    {
+        std::ofstream probe(path, std::ios::app); // 提前发现路径不可写
+        if (!probe.is_open()) return false;
+    }
+    std::lock_guard<std::mutex> lock(dumpMutex);
+    dumpPath = path;
+    dumpInterval = interval.count() > 0 ? interval : std::chrono::milliseconds(1000);
+    dumpFormat = format;
+    stopDump = false;
+    dumpThread = std::thread(&TaskMetrics::DumpLoop, this);
+    return true;
+}
+
+void TaskMetrics::StopPeriodicDump() {
+    {
+        std::lock_guard<std::mutex> lock(dumpMutex);
+        stopDump = true;
+    }
+    dumpCv.notify_all();
+    if (dumpThread.joinable()) {
+        dumpThread.join();
+    }
+}
+
+void TaskMetrics::DumpLoop() {
+    MetricsSnapshot previous = Snapshot();
+    std::unique_lock<std::mutex> lock(dumpMutex);
+    while (true) {
+        dumpCv.wait_for(lock, dumpInterval, [this] { return stopDump; });
+        bool stopping = stopDump; // 第一个周期之前就停止也至少导出一次，留下最终结果
+        lock.unlock();
+        MetricsSnapshot current = Snapshot();
+        ComputeRecentRates(previous, current);
+        WriteDump(current);
+        previous = std::move(current);
+        lock.lock();
+        if (stopping) break;
+    }
+}
+
+// 先写临时文件再改名，外部读者不会看到写了一半的内容
+bool TaskMetrics::WriteDump(const MetricsSnapshot& snapshot) {
+    std::string tmpPath = dumpPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+        if (!out.is_open()) return false;
+        out << (dumpFormat == MetricsFormat::Json ? FormatJson(snapshot) : FormatText(snapshot));
+        if (!out) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, dumpPath, ec);
+    if (ec) {
+        fs::remove(dumpPath, ec);
+        fs::rename(tmpPath, dumpPath, ec);
+    }
+    return !ec;
+}
@@ -0,0 +1,138 @@
+﻿#pragma once
+#include "LatencyHistogram.h"
+#include "TaskPriority.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 单个任务类型 (按 GetName() 区分) 的指标快照
+struct TaskTypeMetrics {
+    std::string name;
+    HistogramSnapshot queueDelay;  // 计划执行时间到实际开始之间的排队延迟 (ns)
+    HistogramSnapshot execTime;    // Execute() 的耗时 (ns)，失败的执行也计入
+    uint64_t completed;            // 执行次数 (含失败)
+    uint64_t failures;             // 抛出异常的次数
+    double ratePerSec;             // 自指标启用以来的平均吞吐
+    double recentPerSec;           // 与上一次快照之间的吞吐，由 ComputeRecentRates 填写
+
+    TaskTypeMetrics() : completed(0), failures(0), ratePerSec(0.0), recentPerSec(0.0) {}
+};
+
+// 单个优先级的排队延迟快照：同一优先级内不分任务类型
+struct PriorityClassMetrics {
+    std::string name;
+    HistogramSnapshot queueDelay;
+    uint64_t deadlineMisses;       // 开始时已超过截止时间的次数
+
+    PriorityClassMetrics() : deadlineMisses(0) {}
+};
+
+struct MetricsSnapshot {
+    std::chrono::steady_clock::time_point takenAt;
+    double uptimeSec;
+    std::vector<TaskTypeMetrics> types;  // 按登记顺序排列
+    std::vector<PriorityClassMetrics> classes; // 按优先级从高到低排列
+
+    MetricsSnapshot() : uptimeSec(0.0) {}
+};
+
+enum class MetricsFormat {
+    Text,
+    Json
+};
+
+// 任务指标注册表
+// 每个线程写自己的分片，热路径不加锁、不共享缓存行；读取时合并所有分片。
+// 任务类型在提交时登记一次，之后只用编号索引，执行时不再查找字符串。
+class TaskMetrics {
+public:
+    static const uint32_t kMaxTaskTypes = 256;  // 超出的类型统一计入最后一个 "(other)"
+
+private:
+    struct Cell {
+        LatencyHistogram queueDelay;
+        LatencyHistogram execTime;
+        std::atomic<uint64_t> failures;
+        Cell() : failures(0) {}
+    };
+
+    struct ClassCell {
+        LatencyHistogram queueDelay;
+        std::atomic<uint64_t> deadlineMisses;
+        ClassCell() : deadlineMisses(0) {}
+    };
+
+    // 一个线程的分片；线程退出后分片归还注册表，计数保留，由下一个新线程接着使用
+    struct Shard {
+        std::atomic<Cell*> cells[kMaxTaskTypes];
+        ClassCell classes[kPriorityClasses];
+        std::atomic<bool> inUse;
+        Shard() : inUse(true) {
+            for (auto& c : cells) c.store(nullptr, std::memory_order_relaxed);
+        }
+        ~Shard() {
+            for (auto& c : cells) delete c.load(std::memory_order_relaxed);
+        }
+    };
+
+    const uint64_t serial;   // 注册表编号，线程局部缓存据此判断分片属于哪个注册表
+    const std::chrono::steady_clock::time_point createdAt;
+
+    mutable std::mutex registryMutex;   // 保护 names/nameIds/shards，热路径不使用
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> nameIds;
+    std::vector<std::shared_ptr<Shard>> shards;
+
+    // 周期性导出
+    std::thread dumpThread;
+    std::mutex dumpMutex;
+    std::condition_variable dumpCv;
+    bool stopDump;
+    std::string dumpPath;
+    std::chrono::milliseconds dumpInterval;
+    MetricsFormat dumpFormat;
+
+    Shard& LocalShard();
+    std::shared_ptr<Shard> AcquireShard();
+    void DumpLoop();
+    bool WriteDump(const MetricsSnapshot& snapshot);
+
+public:
+    TaskMetrics();
+    ~TaskMetrics();
+
+    TaskMetrics(const TaskMetrics&) = delete;
+    TaskMetrics& operator=(const TaskMetrics&) = delete;
+
+    // 登记任务类型，返回编号 (同名返回同一编号)；只在提交任务时调用
+    uint32_t Register(const std::string& name);
+
+    // 记录一次执行，在执行任务的线程上调用
+    // priorityClass 为 TaskPriority 的数值，排队延迟同时计入该优先级的汇总
+    void Record(uint32_t typeId, size_t priorityClass, std::chrono::nanoseconds queueDelay,
+        std::chrono::nanoseconds execTime, bool failed, bool missedDeadline = false);
+
+    // 任务类型名称；编号无效时返回空串
+    std::string GetName(uint32_t typeId) const;
+
+    // 合并所有线程的分片
+    MetricsSnapshot Snapshot() const;
+
+    // 用上一次快照计算区间吞吐
+    static void ComputeRecentRates(const MetricsSnapshot& previous, MetricsSnapshot& current);
+
+    static std::string FormatText(const MetricsSnapshot& snapshot);
+    static std::string FormatJson(const MetricsSnapshot& snapshot);
+
+    // 每隔 interval 把快照写入 path (整体替换文件)；停止时再写一次最终结果
+    bool StartPeriodicDump(const std::string& path, std::chrono::milliseconds interval,
+        MetricsFormat format = MetricsFormat::Json);
+    void StopPeriodicDump();
+};
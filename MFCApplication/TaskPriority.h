@@ -0,0 +1,17 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 优先级：到期任务较多时，就绪队列先取高优先级，同级内按截止时间 (EDF)
+// 等待过久的低优先级任务会逐级提升 (见 TaskScheduler::SetPriorityAging)
+enum class TaskPriority : uint8_t {
+    High = 0,     // 面向界面、对延迟敏感的任务
+    Normal = 1,
+    Low = 2       // 批量计算等后台任务
+};
+const size_t kPriorityClasses = 3;
+
+inline const char* PriorityName(size_t priorityClass) {
+    static const char* const names[kPriorityClasses] = { "High", "Normal", "Low" };
+    return priorityClass < kPriorityClasses ? names[priorityClass] : "?";
+}
@@ -0,0 +1,102 @@
+﻿// 调度器核心不依赖 MFC，也不使用预编译头
+#include "TaskResult.h"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+std::string Describe(const MatrixResult& r) {
+    std::ostringstream out;
+    out << r.size << "x" << r.size << " GEMM: " << std::fixed << std::setprecision(1) << r.ms << " ms, "
+        << r.gflops << " GFLOP/s (" << r.isa << ", " << r.tiles << " tiles)";
+    return out.str();
+}
+
+std::string Describe(const HttpFetchResult& r) {
+    if (!r.ok) return "请求失败: " + r.error;
+    std::ostringstream out;
+    out << "状态: " << r.status << " " << r.reason << " (已保存 " << r.savedTo << ", " << r.bytes << " B, "
+        << std::fixed << std::setprecision(1) << r.ms << " ms)";
+    return out.str();
+}
+
+std::string Describe(const StatsResult& r) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << "n=" << r.count << " mean=" << r.mean << " sd=" << r.sd
+        << " min=" << r.min << " max=" << r.max << " p50=" << r.p50 << " p90=" << r.p90 << " p99=" << r.p99
+        << std::setprecision(1) << " (" << r.ms << " ms)";
+    return out.str();
+}
+
+std::string Describe(const BackupResult& r) {
+    if (!r.ok) return "备份失败: " + r.error;
+    std::ostringstream out;
+    out << r.files << " files, " << std::fixed << std::setprecision(1) << r.bytesIn / 1e6 << " MB -> "
+        << r.bytesOut / 1e6 << " MB (" << std::setprecision(0) << r.Ratio() * 100 << "%), "
+        << std::setprecision(1) << r.ThroughputMBps() << " MB/s";
+    if (r.skipped > 0) out << ", " << r.skipped << " skipped";
+    out << " -> " << r.archive;
+    return out.str();
+}
+
+std::string Describe(const LockDemoResult& r) {
+    return r.acquired ? "成功执行！(锁未遗弃)" : "未能获得锁";
+}
+
+std::string Describe(const TaskResultValue& value) {
+    return std::visit([](const auto& r) { return Describe(r); }, value);
+}
+
+TaskResultChannel::Token TaskResultChannel::Add(Where where, uint64_t key, Callback fn) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    Token token = nextToken++;
+    Entry entry{ token, std::move(fn) };
+    if (where == Where::All) all.push_back(std::move(entry));
+    else if (where == Where::Task) byTask[key].push_back(std::move(entry));
+    else byKind[key].push_back(std::move(entry));
+    locations.emplace(token, std::make_pair(where, key));
+    return token;
+}
+
+TaskResultChannel::Token TaskResultChannel::Subscribe(Callback fn) {
+    return Add(Where::All, 0, std::move(fn));
+}
+
+TaskResultChannel::Token TaskResultChannel::SubscribeTask(uint64_t taskId, Callback fn) {
+    return Add(Where::Task, taskId, std::move(fn));
+}
+
+void TaskResultChannel::Unsubscribe(Token token) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = locations.find(token);
+    if (it == locations.end()) return;
+    auto [where, key] = it->second;
+    locations.erase(it);
+    auto drop = [token](std::vector<Entry>& entries) {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [token](const Entry& e) { return e.token == token; }),
+            entries.end());
+    };
+    if (where == Where::All) {
+        drop(all);
+    }
+    else if (where == Where::Task) {
+        auto found = byTask.find(key);
+        if (found != byTask.end()) {
+            drop(found->second);
+            if (found->second.empty()) byTask.erase(found);
+        }
+    }
+    else {
+        drop(byKind[key]);
+    }
+}
+
+void TaskResultChannel::Publish(const TaskResult& result) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const Entry& entry : byKind[result.value.index()]) entry.fn(result);
+    auto found = byTask.find(result.taskId);
+    if (found != byTask.end()) {
+        for (const Entry& entry : found->second) entry.fn(result);
+    }
+    for (const Entry& entry : all) entry.fn(result);
+}
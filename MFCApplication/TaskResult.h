@@ -0,0 +1,111 @@
+﻿#pragma once
+#include "BackupEngine.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// 任务的结构化结果：界面直接读字段，不再从 "[DATA-*]" 日志文本里解析
+struct MatrixResult {
+    size_t size = 0;
+    double ms = 0.0;
+    double gflops = 0.0;
+    std::string isa;
+    size_t tiles = 0;
+};
+
+struct HttpFetchResult {
+    bool ok = false;
+    std::string error;
+    int status = 0;
+    std::string reason;
+    std::string savedTo;
+    uint64_t bytes = 0;
+    double ms = 0.0;
+};
+
+struct StatsResult {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double sd = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double ms = 0.0;
+};
+
+// 防死锁演示：普通任务拿到了全局资源锁
+struct LockDemoResult {
+    bool acquired = false;
+};
+
+using TaskResultValue = std::variant<MatrixResult, HttpFetchResult, StatsResult, BackupResult, LockDemoResult>;
+
+struct TaskResult {
+    uint64_t taskId = 0;             // 产生结果的任务编号 (TaskHandle::GetId())
+    TaskResultValue value;
+};
+
+// 一行摘要，日志与界面共用
+std::string Describe(const MatrixResult& r);
+std::string Describe(const HttpFetchResult& r);
+std::string Describe(const StatsResult& r);
+std::string Describe(const BackupResult& r);
+std::string Describe(const LockDemoResult& r);
+std::string Describe(const TaskResultValue& value);
+
+// 对应设计模式：Observer (观察者模式) - 按任务编号/结果类型路由的发布订阅
+// 订阅可以针对某个任务编号、某一种结果类型或全部结果，发布时按编号和类型各查一次表，
+// 与订阅总数无关。回调在发布结果的线程上执行，应当很快 (例如只把结果交给界面线程)。
+// 结果很少，用读写锁即可：发布之间互不阻塞，Unsubscribe 返回后不会再回调。
+// 回调内不能再订阅或退订。
+class TaskResultChannel {
+public:
+    using Token = uint64_t;
+    using Callback = std::function<void(const TaskResult&)>;
+
+    Token Subscribe(Callback fn);                         // 全部结果
+    Token SubscribeTask(uint64_t taskId, Callback fn);    // 某个任务 (周期任务的每一次)
+
+    // 某一种结果类型，如 SubscribeKind<MatrixResult>(...)
+    template <typename T>
+    Token SubscribeKind(std::function<void(uint64_t taskId, const T&)> fn) {
+        return Add(Where::Kind, KindOf<T>(), [fn = std::move(fn)](const TaskResult& result) {
+            fn(result.taskId, std::get<T>(result.value));
+        });
+    }
+
+    void Unsubscribe(Token token);
+    void Publish(const TaskResult& result);
+
+private:
+    enum class Where { All, Task, Kind };
+    struct Entry {
+        Token token;
+        Callback fn;
+    };
+
+    template <typename T, size_t I = 0>
+    static constexpr size_t KindOf() {
+        static_assert(I < std::variant_size_v<TaskResultValue>, "not a TaskResultValue alternative");
+        if constexpr (std::is_same_v<std::variant_alternative_t<I, TaskResultValue>, T>) return I;
+        else return KindOf<T, I + 1>();
+    }
+
+    std::shared_mutex mutex;
+    Token nextToken = 1;
+    std::vector<Entry> all;
+    std::unordered_map<uint64_t, std::vector<Entry>> byTask;
+    std::array<std::vector<Entry>, std::variant_size_v<TaskResultValue>> byKind;
+    std::unordered_map<Token, std::pair<Where, uint64_t>> locations; // 退订时找到所在的表
+
+    Token Add(Where where, uint64_t key, Callback fn);
+};
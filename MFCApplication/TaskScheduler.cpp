@@ -1,34 +1,72 @@
-#include "pch.h" // ĿûʹԤͷע͵һУ߱MFCĿĬͨҪ
+// Ĳ MFCҲʹԤͷ (vcxproj иļΪ"ʹԤͷ")
 #include "TaskScheduler.h"
+#include "HeapTimerQueue.h"
+#include "TimingWheel.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <exception>
 
 // ʼ̬Ա
 TaskScheduler* TaskScheduler::instance = nullptr;
 
+// ǰ̳߳߳еıţǹ߳Ϊ -1
+static thread_local long long tlsWorkerIndex = -1;
+
+// ǰִ߳еȼParallelFor 
+static thread_local TaskPriority tlsCurrentPriority = TaskPriority::Normal;
+
+// ǰִ߳еıţṹĬϹ
+static thread_local uint64_t tlsCurrentTaskId = 0;
+
+// ȡɨ㣬ÿȡת߳ɨͬһСͬһܺ
+static thread_local size_t tlsStealCursor = 0;
+
 // 캯ʼ־¼ֹͣ־
 // ע⣺־ļ "scheduler_log.txt" ڳĿ¼
-TaskScheduler::TaskScheduler() : logger("scheduler_log.txt"), stopScheduler(false) {
+TaskScheduler::TaskScheduler() : stopScheduler(false), coarseClock(false), logger("scheduler_log.txt") {
+    taskQueue = std::make_unique<HeapTimerQueue>();
+    workerCount = 0;
+    nextQueue = 0;
+    readyCount = 0;
+    priorityAgingNs = 200LL * 1000000LL;
+    dispatcherDone = false;
+    nextTaskId = 1;
+    staleEntries = 0;
+    SetWorkerCount(0);
+
     //  ʼر־ 
+    heartbeatCount = 0;
     stopMonitor = false;
-    isTaskRunning = false;
-    taskStartTime = 0;
+    monitorKick = false;
+    monitorWakeNs = LLONG_MAX;
+    defaultTimeoutMs = 10000; // ִг 10 룬ΪǱ
+    for (auto& budget : typeTimeoutMs) budget = 0;
+}
+
+// ʱӼԪ룬뿴Źͳһʹ
+static long long SteadyNs(SchedulerClock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
 }
 
 
 void TaskScheduler::AttachObserver(IObserver* observer) {
-    std::lock_guard<std::mutex> lock(observerMutex);
-    observers.push_back(observer);
+    observers.Attach(observer);
 }
 
+// غ󲻻ٻصù۲
 void TaskScheduler::DetachObserver(IObserver* observer) {
-    std::lock_guard<std::mutex> lock(observerMutex);
-    // 򵥵Ƴ߼
-    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+    observers.Detach(observer);
 }
-void TaskScheduler::NotifyObservers(const std::string& msg) {
-    std::lock_guard<std::mutex> lock(observerMutex);
-    for (auto obs : observers) {
-        if (obs) obs->OnLogUpdate(msg);
-    }
+void TaskScheduler::NotifyObservers(const std::string& msg, const std::string& key) {
+    observers.Publish(msg, key);
+}
+
+void TaskScheduler::PublishResult(TaskResultValue value, uint64_t taskId) {
+    TaskResult result;
+    result.taskId = taskId;
+    result.value = std::move(value);
+    results.Publish(result);
 }
 // ȡʵ
 TaskScheduler* TaskScheduler::GetInstance() {
@@ -38,155 +76,828 @@ TaskScheduler* TaskScheduler::GetInstance() {
     return instance;
 }
 
+// ö¼־
+bool TaskScheduler::EnableEventLog(const std::string& path) {
+    if (!eventLog.Open(path)) {
+        logger.Write("[Error] Failed to open event log: " + path);
+        return false;
+    }
+    logger.Write("[System] Event log enabled: " + path);
+    return true;
+}
+
+void TaskScheduler::RecordEvent(EventType type, const std::shared_ptr<TaskControl>& control) {
+    eventLog.Record(type, control ? control->id : 0, control ? control->nameId : 0);
+}
+
+// ƿеȼͽֹöĿ (ύµȡʱ)
+static void StampPriority(ScheduledTask& entry) {
+    if (!entry.control) return;
+    entry.priority = entry.control->priority;
+    entry.deadline = entry.control->deadlineMs > 0
+        ? entry.executeTime + std::chrono::milliseconds(entry.control->deadlineMs)
+        : SchedulerClock::time_point::max();
+}
+
+// ̳߳شС
+void TaskScheduler::SetWorkerCount(size_t count) {
+    if (count == 0) {
+        count = std::thread::hardware_concurrency();
+        if (count == 0) count = 1; // ޷̽ʱٱһ߳
+    }
+    workerCount = count;
+}
+
+// ŹԤ
+void TaskScheduler::SetDefaultTaskTimeout(std::chrono::milliseconds budget) {
+    defaultTimeoutMs = budget.count() > 0 ? budget.count() : 1;
+}
+
+void TaskScheduler::SetTaskTimeout(const std::string& taskName, std::chrono::milliseconds budget) {
+    uint32_t id = metrics.Register(taskName); // ύʱǼǵıһ£ AddTask ֮ǰ
+    typeTimeoutMs[id] = budget.count() > 0 ? budget.count() : 0;
+}
+
+// ȼϻ
+void TaskScheduler::SetPriorityAging(std::chrono::milliseconds step) {
+    // ϸȼȡһԶκŶʱֵ (Լ 13 )ʱ
+    const long long kStrictNs = 1LL << 50;
+    long long ns = step.count() > 0 ? (std::min)(step.count() * 1000000LL, kStrictNs) : kStrictNs;
+    priorityAgingNs.store(ns, std::memory_order_relaxed);
+}
+
+// лʱ
+void TaskScheduler::SetTimerBackend(TimerBackend backend, std::chrono::nanoseconds tick) {
+    std::unique_ptr<ITimerQueue> newQueue;
+    if (backend == TimerBackend::TimingWheel) {
+        newQueue = std::make_unique<TimingWheel>(tick);
+    }
+    else {
+        newQueue = std::make_unique<HeapTimerQueue>();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        std::vector<ScheduledTask> pending;
+        taskQueue->TakeAll(pending);
+        newQueue->PushBatch(pending);
+        taskQueue = std::move(newQueue);
+    }
+    cv.notify_one(); // öʱ̰߳º¼ȴʱ
+    logger.Write(std::string("[System] Timer backend: ") +
+        (backend == TimerBackend::TimingWheel ? "TimingWheel" : "BinaryHeap"));
+}
+
 // 
 void TaskScheduler::Start() {
     if (stopScheduler) {
         stopScheduler = false;
     }
-    // ִ̨̣߳ WorkerLoop
-    if (!workerThread.joinable()) {
-        workerThread = std::thread(&TaskScheduler::WorkerLoop, this);
-        logger.Write("[System] Scheduler Started.");
+    // ̳߳أʱַ̣֤߳ʱ߳̿ȡ
+    if (workerThreads.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            dispatcherDone = false;
+        }
+        // ֹ̳߳ͣʱоſգ԰µ߳ؽ
+        if (workerQueues.size() != workerCount) {
+            workerQueues.clear();
+            for (size_t i = 0; i < workerCount; ++i) {
+                workerQueues.push_back(std::make_unique<WorkStealingQueue>());
+            }
+        }
+        // Ź̳߳ͬʱֹͣʱ԰ȫؽ
+        if (heartbeatCount != workerCount && !monitorThread.joinable()) {
+            heartbeats.reset(new WorkerHeartbeat[workerCount]);
+            heartbeatCount = workerCount;
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            workerThreads.emplace_back(&TaskScheduler::WorkerLoop, this, i);
+        }
+    }
+    if (!dispatcherThread.joinable()) {
+        dispatcherThread = std::thread(&TaskScheduler::DispatcherLoop, this);
+        logger.Write("[System] Scheduler Started with " + std::to_string(workerCount) + " workers.");
+        RecordEvent(EventType::SchedulerStarted, nullptr);
     }
     if (!monitorThread.joinable()) {
-        stopMonitor = false;
+        {
+            std::lock_guard<std::mutex> lock(monitorMutex);
+            stopMonitor = false;
+        }
         monitorThread = std::thread(&TaskScheduler::MonitorLoop, this);
         logger.Write("[System] Watchdog Monitor Started.");
     }
 }
 
 // ֹͣ
+// ſ岻䣺ʱ̻߳ taskQueue еȫڲַ
+// ִ߳е˳
 void TaskScheduler::Stop() {
     {
         std::lock_guard<std::mutex> lock(queueMutex);
         stopScheduler = true;
     }
-    cv.notify_all(); // ѹ̣߳˳
+    cv.notify_all(); // Ѷʱ̣߳ſպ˳
 
-    if (workerThread.joinable()) {
-        workerThread.join(); // ȴ߳̽
+    if (dispatcherThread.joinable()) {
+        dispatcherThread.join(); // ȴʱ߳̽
     }
-    stopMonitor = true;
+    for (auto& worker : workerThreads) {
+        if (worker.joinable()) {
+            worker.join(); // ȴִ߳ʣ
+        }
+    }
+    workerThreads.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex);
+        stopMonitor = true;
+    }
+    monitorCv.notify_all();
     if (monitorThread.joinable()) {
         monitorThread.join();
     }
     logger.Write("[System] Scheduler Stopped.");
+    RecordEvent(EventType::SchedulerStopped, nullptr);
+    logger.Flush(); // 첽ģʽµȴ־̺ٷ
+    observers.Flush(); // 첽ģʽµȴѷ֪ͨȫͶ
+    eventLog.Flush();
 
 }
 
 // 
-void TaskScheduler::AddTask(std::shared_ptr<ITask> task, int delayMs, bool periodic, int intervalMs) {
-    auto now = std::chrono::system_clock::now();
-    auto executeTime = now + std::chrono::milliseconds(delayMs);
+ScheduledTask TaskScheduler::MakeEntry(const TaskSpec& spec, SchedulerClock::time_point now, uint64_t taskId) {
+    auto control = std::make_shared<TaskControl>(taskId != 0 ? taskId : nextTaskId.fetch_add(1), spec.task, spec.periodic, spec.intervalMs,
+        spec.mode);
+    control->priority = spec.priority;
+    control->deadlineMs = spec.deadlineMs > 0 ? spec.deadlineMs : 0;
+    ScheduledTask entry(spec.task, now + std::chrono::milliseconds(spec.delayMs), spec.periodic, spec.intervalMs);
+    entry.control = std::move(control);
+    StampPriority(entry);
+    return entry;
+}
+
+TaskHandle TaskScheduler::AddTask(std::shared_ptr<ITask> task, int delayMs, bool periodic, int intervalMs,
+    PeriodicMode mode) {
+    return AddTask(TaskSpec{ task, delayMs, periodic, intervalMs, mode });
+}
 
-    ScheduledTask newTask(task, executeTime, periodic, intervalMs);
+TaskHandle TaskScheduler::AddTask(const TaskSpec& spec) {
+    const std::shared_ptr<ITask>& task = spec.task;
+    int delayMs = spec.delayMs;
+    ScheduledTask newTask = MakeEntry(spec, SchedulerClock::now());
+    std::shared_ptr<TaskControl> control = newTask.control;
+    control->metricId = metrics.Register(task->GetName());
+
+    // д־ռö¼־ʱֻǼһƣ֮¼ֻǱ
+    if (eventLog.IsOpen()) {
+        control->nameId = eventLog.Intern(task->GetName());
+        RecordEvent(EventType::TaskAdded, control);
+    }
+    else {
+        logger.Write("[Task] Added task: " + task->GetName());
+    }
+
+    // ߳ύѾڣֱӷ뱾ضУ taskQueue
+    if (delayMs <= 0 && tlsWorkerIndex >= 0) {
+        PushReady(std::move(newTask));
+        WakeWorkers(1); // ߳æһ߳ȡ
+        return TaskHandle(control);
+    }
 
     {
         std::lock_guard<std::mutex> lock(queueMutex);
-        taskQueue.push(newTask);
-        logger.Write("[Task] Added task: " + task->GetName());
+        control->timerQueued = true;
+        taskQueue->Push(std::move(newTask));
     }
-    cv.notify_one(); // ֪ͨ߳
+    cv.notify_one(); // ֪ͨʱ߳
+    return TaskHandle(control);
 }
 
-// Ĺѭ
-void TaskScheduler::WorkerLoop() {
-    while (true) {
-        std::shared_ptr<ITask> taskToRun = nullptr;
-        bool isPeriodic = false;
-        int intervalMs = 0;
+// ڲ AddTask ͬ·ֻñšıۼ
+uint64_t TaskScheduler::PostContinuation(std::shared_ptr<ITask> task, uint64_t taskId, TaskPriority priority,
+    int delayMs) {
+    TaskSpec spec;
+    spec.task = std::move(task);
+    spec.delayMs = delayMs;
+    spec.priority = priority;
+    ScheduledTask entry = MakeEntry(spec, SchedulerClock::now(), taskId);
+    TaskControl& control = *entry.control;
+    control.quiet = true;
+    control.metricId = metrics.Register(spec.task->GetName());
+    uint64_t id = control.id;
+
+    if (delayMs <= 0 && tlsWorkerIndex >= 0) {
+        PushReady(std::move(entry));
+        WakeWorkers(1);
+        return id;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        control.timerQueued = true;
+        taskQueue->Push(std::move(entry));
+    }
+    cv.notify_one();
+    return id;
+}
+
+// 
+std::vector<TaskHandle> TaskScheduler::AddTasks(const std::vector<TaskSpec>& specs) {
+    std::vector<TaskHandle> handles;
+    handles.reserve(specs.size());
+    std::vector<ScheduledTask> timed;   // 붨ʱ
+    std::vector<ScheduledTask> local;   // ߳ύֱӷ뱾ض
+    timed.reserve(specs.size());
 
+    // ĿһʱӶȡͬʱһεĵǼǽ
+    auto now = SchedulerClock::now();
+    bool binaryLog = eventLog.IsOpen();
+    std::string lastName;
+    uint32_t lastMetricId = 0;
+    uint32_t lastNameId = 0;
+    bool haveLast = false;
+
+    for (const auto& spec : specs) {
+        if (!spec.task) {
+            handles.emplace_back(); // ռһЧ specs һһӦ
+            continue;
+        }
+        ScheduledTask entry = MakeEntry(spec, now);
+        TaskControl& control = *entry.control;
+
+        std::string name = spec.task->GetName();
+        if (!haveLast || name != lastName) {
+            lastMetricId = metrics.Register(name);
+            lastNameId = binaryLog ? eventLog.Intern(name) : 0;
+            lastName = std::move(name);
+            haveLast = true;
+        }
+        control.metricId = lastMetricId;
+        control.nameId = lastNameId;
+        if (binaryLog) RecordEvent(EventType::TaskAdded, entry.control);
+
+        handles.emplace_back(entry.control);
+        if (spec.delayMs <= 0 && tlsWorkerIndex >= 0) {
+            local.push_back(std::move(entry));
+        }
+        else {
+            timed.push_back(std::move(entry));
+        }
+    }
+
+    size_t added = local.size() + timed.size();
+    if (!binaryLog && added > 0) {
+        logger.Write("[Task] Added " + std::to_string(added) + " tasks in batch");
+    }
+
+    if (!local.empty()) {
+        size_t count = local.size();
+        workerQueues[static_cast<size_t>(tlsWorkerIndex)]->PushBatch(local);
+        readyCount.fetch_add(static_cast<long long>(count));
+        // ߳æ໽Ĺ߳ȡ
+        WakeWorkers((std::min)(count, workerQueues.size() - 1));
+    }
+    if (!timed.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (const auto& entry : timed) entry.control->timerQueued = true;
+            taskQueue->PushBatch(timed);
+        }
+        cv.notify_one(); // ʱ߳һȡȫٰѹ߳
+    }
+    return handles;
+}
+
+// ParallelFor Ĺ״̬±ɵͨԭӼȡ˭쵽˭ִ
+struct ParallelForState {
+    const std::function<void(size_t)>* body; // ߵȴȫɺŷأָڴ֮ǰһֱЧ
+    size_t count;
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> done{ 0 };
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;                // һ쳣 ( mutex )
+
+    ParallelForState(const std::function<void(size_t)>* b, size_t n) : body(b), count(n) {}
+
+    // ȡִ±ֱꣻغ̲߳ٷ body
+    void Drain() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < count) {
+            try {
+                (*body)(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+            }
+            if (done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+// ParallelFor ʱ±ѱֱӷ
+class ParallelForTask : public ITask {
+private:
+    std::shared_ptr<ParallelForState> state;
+    std::string name;
+
+public:
+    ParallelForTask(std::shared_ptr<ParallelForState> s, const std::string& n) : state(std::move(s)), name(n) {}
+    void Execute() override { state->Drain(); }
+    std::string GetName() const override { return name; }
+};
+
+TaskPriority TaskScheduler::CurrentPriority() {
+    return tlsWorkerIndex >= 0 ? tlsCurrentPriority : TaskPriority::Normal;
+}
+
+uint64_t TaskScheduler::CurrentTaskId() {
+    return tlsWorkerIndex >= 0 ? tlsCurrentTaskId : 0;
+}
+
+void TaskScheduler::ParallelFor(size_t count, const std::function<void(size_t)>& body, const std::string& name) {
+    if (count == 0) return;
+    auto state = std::make_shared<ParallelForState>(&body, count);
+
+    // ԼҲһݣֹͣеĵٽ
+    size_t helpers = 0;
+    if (!stopScheduler.load() && count > 1) {
+        size_t idle = tlsWorkerIndex >= 0 ? workerCount - 1 : workerCount;
+        helpers = (std::min)(count - 1, idle);
+    }
+    if (helpers > 0) {
+        std::vector<TaskSpec> specs(helpers);
+        auto task = std::make_shared<ParallelForTask>(state, name);
+        for (auto& spec : specs) {
+            spec.task = task;
+            spec.priority = CurrentPriority();
+        }
+        AddTasks(specs);
+    }
+
+    state->Drain();
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&] { return state->done.load() == count; });
+    }
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+// ȡֻǣеľĿڳӻѹʱ
+// ѽ񷵻 falseֻĿڶʱʱżΪʧЧĿ
+bool TaskScheduler::CancelTask(const TaskHandle& handle) {
+    const auto& control = handle.GetControl();
+    if (!control || control->finished) return false;
+
+    bool wake = false;
+    {
+        // ڡַͬһжϣĿҪô뿪ʱУҪôﱻ
+        std::lock_guard<std::mutex> lock(queueMutex);
+        bool expected = false;
+        if (!control->cancelled.compare_exchange_strong(expected, true)) {
+            return false; // Ѿȡ
+        }
+        if (control->timerQueued) {
+            wake = MarkStale();
+        }
+    }
+    if (wake) cv.notify_one();
+    RecordEvent(EventType::TaskCancelled, control);
+    logger.Write("[Task] Cancelled task: " + control->task->GetName());
+    return true;
+}
+
+// µȣ +1 ʹĿʧЧٲһĿ
+bool TaskScheduler::RescheduleTask(const TaskHandle& handle, int delayMs) {
+    const auto& control = handle.GetControl();
+    if (!control || control->cancelled || control->finished) return false;
+
+    ScheduledTask newTask(control->task, SchedulerClock::now() + std::chrono::milliseconds(delayMs),
+        control->periodic, control->intervalMs);
+    newTask.control = control;
+    newTask.generation = control->generation.fetch_add(1) + 1;
+    StampPriority(newTask);
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (control->timerQueued) {
+            MarkStale(); // ĿڶʱУѷ̵ַ߳ľĿ RunTask 
+        }
+        control->timerQueued = true;
+        taskQueue->Push(std::move(newTask));
+    }
+    cv.notify_one();
+    RecordEvent(EventType::TaskRescheduled, control);
+    logger.Write("[Task] Rescheduled task: " + control->task->GetName());
+    return true;
+}
+
+// ޸ڣһʱЧ
+bool TaskScheduler::SetTaskInterval(const TaskHandle& handle, int intervalMs) {
+    const auto& control = handle.GetControl();
+    if (!control || control->cancelled || control->finished || !control->periodic) return false;
+    control->intervalMs = intervalMs;
+    return true;
+}
+
+// ¼һʧЧĿ (߳ queueMutex)۹ʱҪѶʱ߳ȥѹ
+// ֹͣʱʱ߳̿ȡԶĿͬҪ
+bool TaskScheduler::MarkStale() {
+    return staleEntries.fetch_add(1) + 1 > kPurgeThreshold || stopScheduler;
+}
+
+// ѹʱ (߳ queueMutex)
+void TaskScheduler::PurgeIfNeeded() {
+    long long stale = staleEntries.load();
+    if (stale <= kPurgeThreshold || static_cast<size_t>(stale) * 2 < taskQueue->Size()) {
+        return;
+    }
+    PurgeStale();
+}
+
+// ѹ۳ѹǰѼʧЧĿ (߳ queueMutex)
+// ֱ㣺ѹڼȡĿûƳ©ƣֹͣʱͻһֱ
+void TaskScheduler::PurgeStale() {
+    long long counted = staleEntries.load();
+    taskQueue->Purge();
+    staleEntries.fetch_sub(counted);
+}
+
+// TaskHandle Ĳȫת
+bool TaskHandle::Cancel() {
+    return TaskScheduler::GetInstance()->CancelTask(*this);
+}
+
+bool TaskHandle::Reschedule(int delayMs) {
+    return TaskScheduler::GetInstance()->RescheduleTask(*this, delayMs);
+}
+
+bool TaskHandle::SetInterval(int intervalMs) {
+    return TaskScheduler::GetInstance()->SetTaskInterval(*this, intervalMs);
+}
+
+// ڣֱӷŻضʱУ AddTask
+// now Ϊִнʱ䣬 RunTask 룬ٶʱ
+void TaskScheduler::Rearm(const ScheduledTask& scheduled, SchedulerClock::time_point now) {
+    ScheduledTask next = scheduled;
+    PeriodicMode mode = PeriodicMode::FixedDelay;
+    if (next.control) {
+        next.interval = std::chrono::milliseconds(next.control->intervalMs.load()); // ѱ SetInterval ޸
+        mode = next.control->mode;
+    }
+    if (mode == PeriodicMode::FixedRate && next.interval.count() > 0) {
+        // һεļƻʱΪ׼λִкʱƯ
+        next.executeTime = scheduled.executeTime + next.interval;
+        if (next.executeTime <= now) {
+            // Ѿ (̫̳̫߳æ)ڣԭλ
+            auto missed = (now - scheduled.executeTime) / next.interval;
+            next.executeTime = scheduled.executeTime + next.interval * (missed + 1);
+        }
+    }
+    else {
+        next.executeTime = now + next.interval;
+    }
+    StampPriority(next);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        // ִڼ䱻ȡµȣٷŻ (CancelTask ͬһжǷ)
+        if (!next.IsLive()) return;
+        if (next.control) next.control->timerQueued = true;
+        taskQueue->Push(std::move(next));
+    }
+    cv.notify_one();
+}
+
+// ʱѭֻȴڲ񽻸̳߳أִ
+void TaskScheduler::DispatcherLoop() {
+    std::vector<ScheduledTask> dueTasks;
+
+    while (true) {
         {
             std::unique_lock<std::mutex> lock(queueMutex);
 
             // ȴֹͣ־Ϊ true߶вΪ
             // Ϊûֹͣһֱ
             cv.wait(lock, [this] {
-                return stopScheduler || !taskQueue.empty();
+                return stopScheduler || !taskQueue->Empty();
                 });
 
-            // յֹͣźҶѴ꣨ǿ˳˳ѭ
-            if (stopScheduler && taskQueue.empty()) {
+            // ֹͣʱʧЧĿȡԶӦסſ
+            if (stopScheduler && staleEntries > 0) {
+                PurgeStale();
+            }
+
+            // յֹͣźҶѴ꣬˳ѭ
+            if (stopScheduler && taskQueue->Empty()) {
                 break;
             }
 
-            // 鿴
-            const auto& topTask = taskQueue.top();
-            auto now = std::chrono::system_clock::now();
+            PurgeIfNeeded();
 
-            if (now >= topTask.executeTime) {
-                // ʱ䵽ˣȡִ
-                taskToRun = topTask.task;
-                isPeriodic = topTask.isPeriodic;
-                intervalMs = static_cast<int>(topTask.interval.count());
-                taskQueue.pop(); // Ƴ
+            // һȡѵڵ񣬼ټʧЧĿֱӶ
+            // ÿһʱӲȻ
+            auto now = CoarseClock::Refresh();
+            taskQueue->PopDue(now, dueTasks);
+            auto firstDead = std::remove_if(dueTasks.begin(), dueTasks.end(),
+                [](const ScheduledTask& t) { return !t.IsLive(); });
+            long long dead = static_cast<long long>(dueTasks.end() - firstDead);
+            if (dead > 0) {
+                dueTasks.erase(firstDead, dueTasks.end());
+                staleEntries.fetch_sub((std::min)(dead, staleEntries.load())); // ű windows.h  min 
+            }
+            for (const auto& due : dueTasks) {
+                if (due.control) due.control->timerQueued = false; // 뿪ʱУ֮ȡټΪʧЧĿ
             }
-            else {
-                // ʱ仹ûʹ wait_until ȴضʱ
-                // ﲻȴʱ䣬ҪǷ루notifyֹͣź
-                auto status = cv.wait_until(lock, topTask.executeTime);
 
-                // Ǳʱѣʱ䵽ˣΪ뱻
-                // Ǽ򵥵 continue½ѭ
-                if (status == std::cv_status::timeout) {
-                    // ʱ䵽ˣһѭ if ִ֧
+            if (dueTasks.empty()) {
+                if (taskQueue->Empty()) {
+                    continue; // ȫʧЧĿصͷµȴ
                 }
+                // ʱ仹ûʹ wait_until ȴضʱ
+                // ﲻȴʱ䣬ҪǷ루notifyֹͣź
+                cv.wait_until(lock, taskQueue->NextExpiry());
                 continue;
             }
-        } // 뿪Զ (lock )Աִʱв
+        } // 뿪ͷ queueMutexԱַʱ߳̿Լ
 
-        // ִ (ִУĲ)
-        if (taskToRun) {
-            try {
-                // ¼־
-                logger.Write("[Running] Executing task: " + taskToRun->GetName());
+        // ѵ񽻸̳߳أֻ˫˶Уٳ queueMutex
+        size_t dispatched = dueTasks.size();
+        for (auto& due : dueTasks) {
+            PushReady(std::move(due));
+        }
+        dueTasks.clear();
+        WakeWorkers(dispatched);
+    }
 
-                // ִо
-                NotifyObservers("[Running] " + taskToRun->GetName());
-                taskToRun->Execute();
+    // ֪̣ͨ߳µĵִм˳
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        dispatcherDone = true;
+    }
+    idleCv.notify_all();
+}
 
-                logger.Write("[Finished] Task completed: " + taskToRun->GetName());
+// Ͷݾ
+void TaskScheduler::PushReady(ScheduledTask task) {
+    size_t index;
+    if (tlsWorkerIndex >= 0) {
+        index = static_cast<size_t>(tlsWorkerIndex); // ߳ύڱأѺ
+    }
+    else {
+        index = nextQueue.fetch_add(1) % workerQueues.size();
+    }
+    workerQueues[index]->Push(std::move(task));
+    readyCount.fetch_add(1);
+}
 
-                // ¼
-                if (isPeriodic) {
-                    AddTask(taskToRun, intervalMs, true, intervalMs);
-                }
-            }
-            catch (const std::exception& e) {
-                logger.Write("[Error] Exception in task " + taskToRun->GetName() + ": " + e.what());
-            }
-            catch (...) {
-                logger.Write("[Error] Unknown exception in task " + taskToRun->GetName());
-            }
+// ѿй߳
+void TaskScheduler::WakeWorkers(size_t count) {
+    // Ȼȡһ idleMutexڼĹ̴֪߳ͨ
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    // ֻ쵽̼߳߳
+    if (count >= workerQueues.size()) {
+        idleCv.notify_all();
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) {
+            idleCv.notify_one();
         }
     }
 }
 
-void TaskScheduler::MonitorLoop() {
-    while (!stopMonitor) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+// ȰйֵӦִе (ͬʱԼĶ)
+// ò˻ԭ˳ȡԼĶУٳȡУһγɹ
+// ɨе㰴߳תֵͬʱ߳еܺ߷ɢ
+bool TaskScheduler::TryTakeReady(size_t index, ScheduledTask& out) {
+    long long aging = priorityAgingNs.load(std::memory_order_relaxed);
+    long long nowNs = SteadyNs(CoarseClock::Now()); // ϻֻҪʱ
+    size_t n = workerQueues.size();
+    size_t others = n - 1;
+    size_t start = others > 0 ? tlsStealCursor++ % others : 0; // еĵڼɨ
+    size_t best = index;
+    ReadyRank bestRank = workerQueues[index]->Peek(nowNs, aging);
+    for (size_t i = 0; i < others; ++i) {
+        size_t q = (index + 1 + (start + i) % others) % n;
+        ReadyRank rank = workerQueues[q]->Peek(nowNs, aging);
+        if (rank < bestRank) {
+            bestRank = rank;
+            best = q;
+        }
+    }
+    if (best != index && workerQueues[best]->TrySteal(out, nowNs, aging)) {
+        return true;
+    }
 
-        if (stopMonitor) break;
+    if (workerQueues[index]->TryPop(out, nowNs, aging)) {
+        return true;
+    }
+    for (size_t i = 0; i < others; ++i) {
+        if (workerQueues[(index + 1 + (start + i) % others) % n]->TrySteal(out, nowNs, aging)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ߳ѭ
+void TaskScheduler::WorkerLoop(size_t index) {
+    tlsWorkerIndex = static_cast<long long>(index);
 
-        if (isTaskRunning) {
-            auto now = std::chrono::system_clock::now().time_since_epoch().count();
-            // ﵥλȡ time_since_epoch ľȣͨתȫ
-            // Ǽ򵥴ȡǰʱԱ
-            auto start = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(taskStartTime));
-            auto current = std::chrono::system_clock::now();
+    while (true) {
+        ScheduledTask scheduled(nullptr, SchedulerClock::time_point());
 
-            auto duration = std::chrono::duration_cast<std::chrono::seconds>(current - start).count();
+        if (TryTakeReady(index, scheduled)) {
+            readyCount.fetch_sub(1);
+            RunTask(scheduled); // ִʱκ
+            continue;
+        }
 
-            // ִֵг 10 룬ΪǱ
-            if (duration > 10) {
-                std::string warning = "[DEADLOCK WARNING] Task is stuck for over 10 seconds!";
-                // д־֪ͨ UI
-                logger.Write(warning);
-                NotifyObservers(warning);
+        std::unique_lock<std::mutex> lock(idleMutex);
+        idleCv.wait(lock, [this] {
+            return dispatcherDone || readyCount.load() > 0;
+            });
+
+        if (dispatcherDone && readyCount.load() <= 0) {
+            break; // ʱ߳˳жѿ
+        }
+    }
 
-                // ע⣺C++ std::thread ޷ȫǿɱ (Kill)
-                // ֻܱ־ǡϵͳڲ״̬
+    tlsWorkerIndex = -1;
+}
+
+// ִ (ڹִ߳Уĵ)
+void TaskScheduler::RunTask(const ScheduledTask& scheduled) {
+    std::shared_ptr<ITask> taskToRun = scheduled.task;
+    if (!taskToRun || !scheduled.IsLive()) {
+        return; // ַ֮űȡ
+    }
+
+    // ¼־ʱʼ/ֻд¼ƴıڲ߶д
+    bool quiet = scheduled.control && scheduled.control->quiet;
+    bool textLog = !quiet && !eventLog.IsOpen();
+    bool events = !quiet;
+
+    // Ŷӳ = ʵʿʼ - ƻʱ䣻ִкʱ =  - ʼ
+    // ÿֻڿʼͽȡһʱ䣬ʱͬʱΪ̶ӳڵĻ׼
+    bool coarse = coarseClock.load(std::memory_order_relaxed);
+    SchedulerClock::time_point execStart = scheduled.executeTime; // Execute() ֮ǰʧʱԼƻʱΪ
+    SchedulerClock::time_point execEnd;
+    uint32_t metricId = scheduled.control ? scheduled.control->metricId : TaskMetrics::kMaxTaskTypes - 1;
+    bool recorded = false;
+    bool heartbeatBegun = false; // Begin ֮ǰ׳ʱ End۵żᷴ
+    bool rearmed = false;
+    auto recordMetrics = [&](bool failed) {
+        if (recorded) return; // Execute() ֮ʧܲظ
+        recorded = true;
+        execEnd = CoarseClock::Refresh(); // ͬʱƽʱӣȼϻ
+        if (heartbeatBegun) EndHeartbeat();
+        bool missed = scheduled.HasDeadline() && execStart > scheduled.deadline;
+        metrics.Record(metricId, static_cast<size_t>(scheduled.priority), execStart - scheduled.executeTime,
+            execEnd - execStart, failed, missed);
+    };
+
+    try {
+        // ¼־
+        if (events) RecordEvent(EventType::TaskStarted, scheduled.control);
+        if (textLog) logger.Write("[Running] Executing task: " + taskToRun->GetName());
+
+        // ִоԣûй۲ʱƴ֪ͨı
+        if (!quiet && !observers.Empty()) {
+            std::string name = taskToRun->GetName();
+            NotifyObservers("[Running] " + name, "running/" + name);
+        }
+        execStart = coarse ? CoarseClock::Now() : SchedulerClock::now();
+        BeginHeartbeat(scheduled, execStart);
+        heartbeatBegun = true;
+        tlsCurrentPriority = scheduled.priority;
+        tlsCurrentTaskId = scheduled.control ? scheduled.control->id : 0;
+        taskToRun->Execute();
+        recordMetrics(false);
+
+        if (events) RecordEvent(EventType::TaskFinished, scheduled.control);
+        if (textLog) logger.Write("[Finished] Task completed: " + taskToRun->GetName());
+
+        // ¼
+        // ֹͣʱڣ Stop() ſԶ޷
+        bool periodic = scheduled.control ? scheduled.control->periodic.load() : scheduled.isPeriodic;
+        if (periodic && !stopScheduler && scheduled.IsLive()) {
+            Rearm(scheduled, execEnd);
+            rearmed = true;
+        }
+    }
+    catch (const std::exception& e) {
+        recordMetrics(true);
+        RecordEvent(EventType::TaskFailed, scheduled.control);
+        logger.Write("[Error] Exception in task " + taskToRun->GetName() + ": " + e.what());
+    }
+    catch (...) {
+        recordMetrics(true);
+        RecordEvent(EventType::TaskFailed, scheduled.control);
+        logger.Write("[Error] Unknown exception in task " + taskToRun->GetName());
+    }
+
+    // ûھ͵˽ִڼ䱻µȹ (ѱ) ĻĿִУ
+    if (!rearmed && scheduled.control && scheduled.control->generation == scheduled.generation) {
+        scheduled.control->finished = true;
+    }
+}
+
+// ̣߳ԼеǼִе
+void TaskScheduler::BeginHeartbeat(const ScheduledTask& scheduled, SchedulerClock::time_point start) {
+    if (tlsWorkerIndex < 0 || static_cast<size_t>(tlsWorkerIndex) >= heartbeatCount) return;
+
+    uint32_t metricId = scheduled.control ? scheduled.control->metricId : TaskMetrics::kMaxTaskTypes - 1;
+    long long budgetMs = typeTimeoutMs[metricId].load(std::memory_order_relaxed);
+    if (budgetMs <= 0) budgetMs = defaultTimeoutMs.load(std::memory_order_relaxed);
+    long long startNs = SteadyNs(start);
+    long long deadlineNs = startNs + budgetMs * 1000000LL;
+
+    heartbeats[tlsWorkerIndex].Begin(scheduled.control ? scheduled.control->id : 0, metricId,
+        scheduled.control ? scheduled.control->nameId : 0, startNs, deadlineNs);
+
+    // ͨŹѾڸʱֻһԭӶֻнֹʱŻ
+    if (deadlineNs < monitorWakeNs.load(std::memory_order_seq_cst)) {
+        {
+            std::lock_guard<std::mutex> lock(monitorMutex);
+            monitorKick = true;
+        }
+        monitorCv.notify_one();
+    }
+}
+
+void TaskScheduler::EndHeartbeat() {
+    if (tlsWorkerIndex < 0 || static_cast<size_t>(tlsWorkerIndex) >= heartbeatCount) return;
+    heartbeats[tlsWorkerIndex].End();
+}
+
+// 濨סд־֪ͨ桢һ TaskStalled ¼
+void TaskScheduler::ReportStall(size_t worker, const WorkerHeartbeat::View& view, long long nowNs) {
+    std::string name = metrics.GetName(view.metricId);
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "' (#%llu) on worker %zu has been running for %.1f s (budget %.1f s)",
+        static_cast<unsigned long long>(view.taskId), worker,
+        (nowNs - view.startNs) / 1e9, (view.deadlineNs - view.startNs) / 1e9);
+    std::string warning = "[DEADLOCK WARNING] Task '" + name + buf;
+
+    // д־֪ͨ UI
+    logger.Write(warning);
+    NotifyObservers(warning);
+    eventLog.Record(EventType::TaskStalled, view.taskId, view.nameId);
+
+    // ע⣺C++ std::thread ޷ȫǿɱ (Kill)
+    // ֻܱ־ǡϵͳڲ״̬
+}
+
+// Źȡۣ˯ܵĽֹʱ
+// ûʱĽֹʱ"ڿʼ + Ԥ"ԿʱҲֻԤ
+void TaskScheduler::MonitorLoop() {
+    // ÿ߳һο epoch һαʱ䣻ͬһִÿһԤ㱨һ
+    std::vector<uint64_t> seenEpoch(heartbeatCount, 0);
+    std::vector<long long> nextReportNs(heartbeatCount, LLONG_MAX);
+
+    std::unique_lock<std::mutex> lock(monitorMutex);
+    while (!stopMonitor) {
+        monitorKick = false;
+        lock.unlock();
+
+        long long nowNs = SteadyNs(SchedulerClock::now());
+        long long minBudgetMs = defaultTimeoutMs.load(std::memory_order_relaxed);
+        for (const auto& budget : typeTimeoutMs) {
+            long long ms = budget.load(std::memory_order_relaxed);
+            if (ms > 0 && ms < minBudgetMs) minBudgetMs = ms;
+        }
+        long long earliest = nowNs + minBudgetMs * 1000000LL;
+        // ɨ飺һȷʱ䣬ڶ鲹ڼ俪ʼ
+        // ֮ſʼ BeginHeartbeat пµĻʱ䣬Ҫʱ
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t i = 0; i < heartbeatCount; ++i) {
+                WorkerHeartbeat::View view;
+                if (!heartbeats[i].Read(view)) continue; // лл
+
+                if (view.epoch != seenEpoch[i]) {
+                    seenEpoch[i] = view.epoch;
+                    nextReportNs[i] = view.deadlineNs;
+                }
+                if (nowNs >= nextReportNs[i]) {
+                    ReportStall(i, view, nowNs);
+                    nextReportNs[i] = nowNs + (std::max)(view.deadlineNs - view.startNs, 1000000LL);
+                }
+                earliest = (std::min)(earliest, nextReportNs[i]);
             }
+            monitorWakeNs.store(earliest, std::memory_order_seq_cst);
         }
+
+        lock.lock();
+        auto wakeAt = SchedulerClock::time_point(
+            std::chrono::duration_cast<SchedulerClock::duration>(std::chrono::nanoseconds(earliest)));
+        monitorCv.wait_until(lock, wakeAt, [this] { return stopMonitor || monitorKick; });
     }
-}
\ No newline at end of file
+    monitorWakeNs = LLONG_MAX;
+}
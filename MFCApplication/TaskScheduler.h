@@ -1,13 +1,39 @@
 #pragma once
 #include "ScheduledTask.h"
 #include "LogWriter.h"
-#include "IObserver.h"
-#include <queue>
+#include "EventLog.h"
+#include "TaskMetrics.h"
+#include "ObserverHub.h"
+#include "TaskResult.h"
+#include "WorkStealingQueue.h"
+#include "WorkerHeartbeat.h"
+#include "ITimerQueue.h"
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <memory>
 #include <atomic>
+#include <functional>
+#include <string>
+
+// ʱˣ (Ĭ) ֲʱ
+enum class TimerBackend {
+    BinaryHeap,
+    TimingWheel
+};
+
+// ύʱһֶκ AddTask Ĳͬ
+struct TaskSpec {
+    std::shared_ptr<ITask> task;
+    int delayMs = 0;
+    bool periodic = false;
+    int intervalMs = 0;
+    PeriodicMode mode = PeriodicMode::FixedDelay;
+    TaskPriority priority = TaskPriority::Normal;
+    int deadlineMs = 0;            // ںٶÿʼ0 ʾûнֹʱ
+};
 
 // ӦģʽSingleton ()
 // ֤ϵͳֻһʵ
@@ -15,30 +41,83 @@ class TaskScheduler {
 private:
     static TaskScheduler* instance; // ָ
 
-    // ȶУʹ std::greater  ScheduledTask  operator>
-    // ȷʱڶ (Min-Heap)
-    
-    std::priority_queue<ScheduledTask, std::vector<ScheduledTask>, std::greater<ScheduledTask>> taskQueue;
-    std::vector<IObserver*> observers;
-    std::mutex observerMutex;
+    // ʱУδڵ񣬾ʵֿڶʱ֮л
+    std::unique_ptr<ITimerQueue> taskQueue;
+    ObserverHub observers;             // ۲бдʱƣ֪ͨлΪ첽Ͷ
+    TaskResultChannel results;         // ṹ־ıֿ
     std::mutex queueMutex;             // еĻ
     std::condition_variable cv;        // ̻߳
     std::atomic<bool> stopScheduler;   // ֹͣ־λ (ԭӲ)
-    std::thread workerThread;          // ̨߳
+    std::atomic<bool> coarseClock;     // ̶߳ȡ CoarseClock 棬ÿ񶼶ʱ
+    std::thread dispatcherThread;      // ʱֻ̣߳ѵ taskQueue 
     LogWriter logger;                  // ־¼ (RAII)
+    EventLogWriter eventLog;           // ¼־ú·дı־
+    TaskMetrics metrics;               // ͳŶӳ١ִкʱ
+
+    // ̳߳أ񽻸 N ִ̲߳Уס
+    std::vector<std::thread> workerThreads;
+    size_t workerCount;                // ߳ (Ĭȡ hardware_concurrency)
+
+    // ַ㣺ÿ߳һ (ȼ/ֹʱ)̴߳æµ̴߳ȡ
+    // taskQueue ֻʱŰ
+    std::vector<std::unique_ptr<WorkStealingQueue>> workerQueues;
+    std::atomic<size_t> nextQueue;     // ʱ߳ѯͶݵһ
+    std::atomic<long long> readyCount; // ое
+    std::atomic<long long> priorityAgingNs; // ȼÿȴôһ
+    std::mutex idleMutex;              // ڿй̵߳/
+    std::condition_variable idleCv;    // ѿеĹ߳
+    bool dispatcherDone;               // ʱ߳ſ taskQueue ˳ ( idleMutex )
+
+    std::atomic<uint64_t> nextTaskId;  // ţAddTask ʱ
+    std::atomic<long long> staleEntries; // ʱʧЧĿĹʱѹ
+    static const long long kPurgeThreshold = 64;
 
     // ˽й캯ֹⲿֱӴ
     TaskScheduler();
 
-    // ̵̨߳ѭ
-    void WorkerLoop();
+    // ʱ̵߳ѭȴڣȻַ̳߳
+    void DispatcherLoop();
+
+    // ̵߳ѭȡԼĶУȡ
+    void WorkerLoop(size_t index);
+
+    // һͶݵĳ̵߳ĶУӹ߳ڲʱͶݵԼĶ
+    void PushReady(ScheduledTask task);
+    void WakeWorkers(size_t count);
+    bool TryTakeReady(size_t index, ScheduledTask& out);
 
+    // ʧЧĿһʱѹһ ( queueMutex)̯ O(1)
+    void PurgeIfNeeded();
+    void PurgeStale();
+    // ¼ʱеһʧЧĿ ( queueMutex)ǷҪѶʱ߳
+    bool MarkStale();
+
+    void RecordEvent(EventType type, const std::shared_ptr<TaskControl>& control);
+
+    // Ϊһ񴴽ƿĿ (AddTask / AddTasks / PostContinuation )
+    // taskId Ϊ 0 ʱ±
+    ScheduledTask MakeEntry(const TaskSpec& spec, SchedulerClock::time_point now, uint64_t taskId = 0);
+
+    // ִе (쳣)
+    void RunTask(const ScheduledTask& scheduled);
+    void Rearm(const ScheduledTask& scheduled, SchedulerClock::time_point now);
+
+    // Źÿ߳һۣ߳˯Ľֹʱ䣬ѯ
+    std::unique_ptr<WorkerHeartbeat[]> heartbeats;
+    size_t heartbeatCount;
     std::thread monitorThread;             // ̣߳Ź
-    std::atomic<bool> stopMonitor;         // ֹͣصı־
-    std::atomic<bool> isTaskRunning;       // ǵǰǷ
-    std::atomic<long long> taskStartTime;  // ¼ʼʱ
+    std::mutex monitorMutex;
+    std::condition_variable monitorCv;
+    bool stopMonitor;                      // ֹͣصı־ ( monitorMutex )
+    bool monitorKick;                      // иĽֹʱ䣬Ҫ¼ ( monitorMutex )
+    std::atomic<long long> monitorWakeNs;  // Źһʱ䣬½ֹʱҪ
+    std::atomic<long long> defaultTimeoutMs;
+    std::atomic<long long> typeTimeoutMs[TaskMetrics::kMaxTaskTypes]; // ͵Ԥ㣬0 ʾʹĬֵ
 
     void MonitorLoop(); // ̵߳ľ߼
+    void BeginHeartbeat(const ScheduledTask& scheduled, SchedulerClock::time_point start);
+    void EndHeartbeat();
+    void ReportStall(size_t worker, const WorkerHeartbeat::View& view, long long nowNs);
 
 
 public:
@@ -50,13 +129,77 @@ public:
 
     // ȡʵ
     static TaskScheduler* GetInstance();
-    void NotifyObservers(const std::string& msg);
+    // key ǿʱΪ״̬Ϣ첽Ͷʱͬһ key ֻͬͶһ
+    void NotifyObservers(const std::string& msg, const std::string& key = std::string());
+    ObserverHub& GetObserverHub() { return observers; }
+
+    // ṹtaskId Ĭȡǰִе
+    void PublishResult(TaskResultValue value, uint64_t taskId = CurrentTaskId());
+    TaskResultChannel& GetResults() { return results; }
     LogWriter& GetLogger() { return logger; }
+
+    // ö¼־/ʼ/¼Ϊ¼ƴı
+    bool EnableEventLog(const std::string& path);
+    EventLogWriter& GetEventLog() { return eventLog; }
+
+    // ָ꣺Snapshot() ȡϲĿգStartPeriodicDump() ڵı/JSON
+    TaskMetrics& GetMetrics() { return metrics; }
     // ӿ
     // delayMs: ӳٶٺִ
     // periodic: Ƿִ
     // intervalMs: ִеļ
-    void AddTask(std::shared_ptr<ITask> task, int delayMs, bool periodic = false, int intervalMs = 0);
+    // mode: 񰴹̶ӳ (Ĭ) ǹ̶Ƶ
+    // ؾȡµȻ޸
+    TaskHandle AddTask(std::shared_ptr<ITask> task, int delayMs, bool periodic = false, int intervalMs = 0,
+        PeriodicMode mode = PeriodicMode::FixedDelay);
+
+    // ӣĿһμڲ붨ʱУֻдһ־ֻһζʱ߳
+    // صľ specs һһӦspec.task ΪյλЧ (IsValid() == false)
+    std::vector<TaskHandle> AddTasks(const std::vector<TaskSpec>& specs);
+
+    // ȼ/ֹʱĵ
+    TaskHandle AddTask(const TaskSpec& spec);
+
+    // ڲ (Э̵ÿλָ)Ϊ taskId һִУڼ CurrentTaskId()  taskId
+    // Ľԭ񣻲д/ʼ/־¼Ҳ֪ͨ۲ߡ
+    // taskId Ϊ 0 ʱ±ţʵʹõı
+    uint64_t PostContinuation(std::shared_ptr<ITask> task, uint64_t taskId, TaskPriority priority, int delayMs = 0);
+
+    // Fork-Join body(0) ... body(count - 1) 񽻸̳߳أͬʱȡִУȫɺ󷵻
+    // õǰȼΪ name (־ָ)
+    // ڹ߳ڵҲûп߳ʱ߶ȫ
+    // body ׳ĵһ쳣ȫɺ׳
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body, const std::string& name = "ParallelFor");
+
+    // ǰִ߳еȼڹ߳ʱΪ Normal (ʱ)
+    static TaskPriority CurrentPriority();
+    // ǰִ߳е (TaskHandle::GetId())ʱΪ 0
+    static uint64_t CurrentTaskId();
+
+    //  (TaskHandle ĳԱת)
+    bool CancelTask(const TaskHandle& handle);
+    bool RescheduleTask(const TaskHandle& handle, int delayMs);
+    bool SetTaskInterval(const TaskHandle& handle, int intervalMs);
+
+    // ̳߳شС Start() ֮ǰã0 ʾ hardware_concurrency Զѡ
+    void SetWorkerCount(size_t count);
+    size_t GetWorkerCount() const { return workerCount; }
+
+    // ŹִгԤ㼴濨סʱ
+    // ĬԤ 10 룻԰ (GetName()) 
+    void SetDefaultTaskTimeout(std::chrono::milliseconds budget);
+    void SetTaskTimeout(const std::string& taskName, std::chrono::milliseconds budget);
+
+    // ʱӣʼʱȡʱ߳ÿĻֵ
+    // ŶӳٺͿŹľȽΪһַΣÿһʱӶȡ
+    void SetCoarseClock(bool enable) { coarseClock = enable; }
+
+    // ȼϻһȸһĶȴ step 󼴿ִУ0 ʾϸȼ
+    void SetPriorityAging(std::chrono::milliseconds step);
+
+    // лʱˣŶӵǨƵº
+    // tick: ʱֵľȣ/ӳʱʱֵĲ͵ھΪ O(1)
+    void SetTimerBackend(TimerBackend backend, std::chrono::nanoseconds tick = std::chrono::milliseconds(1));
 
     // 
     void Start();
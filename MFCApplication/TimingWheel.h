@@ -0,0 +1,246 @@
+﻿#pragma once
+#include "ITimerQueue.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// 分层时间轮定时器：插入 O(1)，到期摊还 O(1)
+// 第 0 层 256 个槽，每槽对应一个 tick；往上 4 层各 64 个槽，每层槽宽是下一层整圈的长度。
+// 时间推进到某层的槽边界时，把该槽的任务"降级"重新放入更低层 (cascade)。
+// 4 层覆盖 2^32 个 tick (1ms 精度约 49 天)，更远的任务先挂在最高层，降级时再重新计算位置。
+class TimingWheel : public ITimerQueue {
+private:
+    static const int kRootBits = 8;
+    static const int kLevelBits = 6;
+    static const int kLevels = 4;
+    static const uint64_t kRootSize = 1ull << kRootBits;
+    static const uint64_t kRootMask = kRootSize - 1;
+    static const uint64_t kLevelSize = 1ull << kLevelBits;
+    static const uint64_t kLevelMask = kLevelSize - 1;
+    static const uint64_t kMaxDelta = (1ull << (kRootBits + kLevels * kLevelBits)) - 1;
+
+    struct Entry {
+        uint64_t tick;       // 到期的 tick (向上取整，保证到期时 executeTime 已过)
+        ScheduledTask task;
+    };
+    using Slot = std::vector<Entry>;
+
+    Slot root[kRootSize];
+    Slot levels[kLevels][kLevelSize];
+    uint64_t rootBitmap[kRootSize / 64];   // 非空槽位图，用于跳过空槽
+    uint64_t levelBitmap[kLevels];
+    std::vector<Entry> overdue;            // 插入时已经过期的任务，下一次 PopDue 直接返回
+
+    std::chrono::nanoseconds tick;
+    SchedulerClock::time_point origin;
+    uint64_t currentTick;                  // 下一个待处理的 tick
+    size_t count;
+
+    static int CountTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    // 在第 0 层位图中查找 >= from 的第一个非空槽，没有则返回 -1
+    int NextRootSlot(uint64_t from) const {
+        for (uint64_t word = from / 64; word < kRootSize / 64; ++word) {
+            uint64_t bits = rootBitmap[word];
+            if (word == from / 64) bits &= ~0ull << (from % 64);
+            if (bits) return static_cast<int>(word * 64 + CountTrailingZeros(bits));
+        }
+        return -1;
+    }
+
+    bool RootEmpty() const {
+        for (uint64_t word : rootBitmap) {
+            if (word) return false;
+        }
+        return true;
+    }
+
+    uint64_t TickOf(SchedulerClock::time_point time, bool roundUp) const {
+        if (time <= origin) return 0;
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(time - origin).count();
+        auto step = tick.count();
+        return static_cast<uint64_t>(roundUp ? (elapsed + step - 1) / step : elapsed / step);
+    }
+
+    SchedulerClock::time_point TimeOf(uint64_t t) const {
+        return origin + std::chrono::duration_cast<SchedulerClock::duration>(tick * t);
+    }
+
+    // 按相对 currentTick 的距离选择层和槽
+    void Place(Entry entry) {
+        if (entry.tick < currentTick) {
+            overdue.push_back(std::move(entry));
+            return;
+        }
+        uint64_t delta = entry.tick - currentTick;
+        if (delta < kRootSize) {
+            uint64_t index = entry.tick & kRootMask;
+            root[index].push_back(std::move(entry));
+            rootBitmap[index / 64] |= 1ull << (index % 64);
+            return;
+        }
+        uint64_t expires = entry.tick;
+        if (delta > kMaxDelta) {
+            delta = kMaxDelta;
+            expires = currentTick + kMaxDelta; // 超出范围的先挂在最远的槽里
+        }
+        for (int level = 0; level < kLevels; ++level) {
+            int shift = kRootBits + level * kLevelBits;
+            if (delta < (1ull << (shift + kLevelBits))) {
+                uint64_t index = (expires >> shift) & kLevelMask;
+                levels[level][index].push_back(std::move(entry));
+                levelBitmap[level] |= 1ull << index;
+                return;
+            }
+        }
+    }
+
+    // 把高层的一个槽整体降级到低层
+    void Cascade(int level, uint64_t index) {
+        if (!(levelBitmap[level] & (1ull << index))) return;
+        Slot moved;
+        moved.swap(levels[level][index]);
+        levelBitmap[level] &= ~(1ull << index);
+        for (auto& entry : moved) {
+            Place(std::move(entry));
+        }
+    }
+
+    void ExpireRoot(uint64_t index, std::vector<ScheduledTask>& out) {
+        Slot& slot = root[index];
+        for (auto& entry : slot) {
+            out.push_back(std::move(entry.task));
+        }
+        count -= slot.size();
+        slot.clear();
+        rootBitmap[index / 64] &= ~(1ull << (index % 64));
+    }
+
+public:
+    explicit TimingWheel(std::chrono::nanoseconds tickResolution = std::chrono::milliseconds(1),
+        SchedulerClock::time_point startTime = SchedulerClock::now())
+        : rootBitmap(), levelBitmap(), tick(tickResolution), origin(startTime), currentTick(0), count(0) {
+        if (tick.count() <= 0) tick = std::chrono::milliseconds(1);
+    }
+
+    void Push(ScheduledTask task) override {
+        uint64_t t = TickOf(task.executeTime, true);
+        Place(Entry{ t, std::move(task) });
+        ++count;
+    }
+
+    void PopDue(SchedulerClock::time_point now, std::vector<ScheduledTask>& out) override {
+        for (auto& entry : overdue) {
+            out.push_back(std::move(entry.task));
+        }
+        count -= overdue.size();
+        overdue.clear();
+
+        if (now < origin) return;
+        uint64_t target = TickOf(now, false);
+
+        while (currentTick <= target) {
+            uint64_t index = currentTick & kRootMask;
+            if (index == 0) {
+                // 第 0 层转完一圈：依次降级上层当前槽，直到某层没有进位
+                for (int level = 0; level < kLevels; ++level) {
+                    uint64_t levelIndex = (currentTick >> (kRootBits + level * kLevelBits)) & kLevelMask;
+                    Cascade(level, levelIndex);
+                    if (levelIndex != 0) break;
+                }
+            }
+
+            // 借助位图直接跳到本圈内下一个非空槽，或者下一圈的起点
+            uint64_t revolution = currentTick - index;
+            int next = NextRootSlot(index);
+            uint64_t nextTick = next >= 0 ? revolution + next : revolution + kRootSize;
+            if (nextTick > target) {
+                currentTick = target + 1;
+                break;
+            }
+            currentTick = nextTick;
+            if (next >= 0) {
+                ExpireRoot(static_cast<uint64_t>(next), out);
+                ++currentTick;
+            }
+        }
+    }
+
+    SchedulerClock::time_point NextExpiry() const override {
+        if (!overdue.empty()) return overdue.front().task.executeTime;
+
+        uint64_t index = currentTick & kRootMask;
+        if (index == 0) return TimeOf(currentTick); // 待降级，需要立即处理
+
+        uint64_t revolution = currentTick - index;
+        int next = NextRootSlot(index);
+        if (next >= 0) return TimeOf(revolution + next);
+        if (!RootEmpty()) return TimeOf(revolution + kRootSize);
+
+        // 第 0 层为空：下一次可能有任务降级下来的时刻
+        uint64_t period = currentTick >> kRootBits;
+        uint64_t levelIndex = period & kLevelMask;
+        uint64_t bits = levelBitmap[0] & (levelIndex + 1 < kLevelSize ? ~0ull << (levelIndex + 1) : 0);
+        if (bits) return TimeOf((period - levelIndex + CountTrailingZeros(bits)) << kRootBits);
+        return TimeOf((period - levelIndex + kLevelSize) << kRootBits);
+    }
+
+    void TakeAll(std::vector<ScheduledTask>& out) override {
+        for (auto& entry : overdue) out.push_back(std::move(entry.task));
+        overdue.clear();
+        for (auto& slot : root) {
+            for (auto& entry : slot) out.push_back(std::move(entry.task));
+            slot.clear();
+        }
+        for (auto& level : levels) {
+            for (auto& slot : level) {
+                for (auto& entry : slot) out.push_back(std::move(entry.task));
+                slot.clear();
+            }
+        }
+        for (auto& word : rootBitmap) word = 0;
+        for (auto& word : levelBitmap) word = 0;
+        count = 0;
+    }
+
+    size_t Purge() override {
+        auto dead = [](const Entry& e) { return !e.task.IsLive(); };
+        auto purgeSlot = [&](Slot& slot) {
+            size_t before = slot.size();
+            slot.erase(std::remove_if(slot.begin(), slot.end(), dead), slot.end());
+            if (slot.empty()) Slot().swap(slot); // 归还空槽占用的内存
+            return before - slot.size();
+        };
+
+        size_t removed = purgeSlot(overdue);
+        for (uint64_t i = 0; i < kRootSize; ++i) {
+            removed += purgeSlot(root[i]);
+            if (root[i].empty()) rootBitmap[i / 64] &= ~(1ull << (i % 64));
+        }
+        for (int level = 0; level < kLevels; ++level) {
+            for (uint64_t i = 0; i < kLevelSize; ++i) {
+                removed += purgeSlot(levels[level][i]);
+                if (levels[level][i].empty()) levelBitmap[level] &= ~(1ull << i);
+            }
+        }
+        count -= removed;
+        return removed;
+    }
+
+    bool Empty() const override { return count == 0; }
+    size_t Size() const override { return count; }
+
+    std::chrono::nanoseconds GetTick() const { return tick; }
+};
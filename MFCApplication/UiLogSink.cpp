@@ -0,0 +1,44 @@
+﻿// 调度器核心不依赖 MFC，也不使用预编译头
+#include "UiLogSink.h"
+#include <algorithm>
+
+UiLogSink::UiLogSink(size_t limit, size_t capacity)
+    : ring(capacity), historyLimit((std::max)(limit, size_t(2))), dropped(0), shown(0), skipped(0), reported(0) {}
+
+void UiLogSink::OnLogUpdate(const std::string& message) {
+    std::string item = message;
+    while (!ring.TryPush(item)) {
+        std::string oldest;
+        if (ring.TryPop(oldest)) dropped.fetch_add(1);
+    }
+}
+
+bool UiLogSink::PollFrame(UiLogFrame& frame) {
+    frame.lines.clear();
+    frame.evict = 0;
+    frame.dropped = 0;
+
+    // 最多取一个队列容量：生产者持续写入时也能按时返回
+    std::string line;
+    for (size_t i = 0; i < ring.Capacity() && ring.TryPop(line); ++i) frame.lines.push_back(std::move(line));
+
+    // 单帧只保留最新的 historyLimit - 1 行，留一行给提示
+    size_t keep = historyLimit - 1;
+    if (frame.lines.size() > keep) {
+        size_t excess = frame.lines.size() - keep;
+        frame.lines.erase(frame.lines.begin(), frame.lines.begin() + static_cast<std::ptrdiff_t>(excess));
+        skipped += excess;
+    }
+    uint64_t total = dropped.load() + skipped;
+    if (total > reported) {
+        frame.dropped = total - reported;
+        reported = total;
+        frame.lines.insert(frame.lines.begin(), "[UI] 日志过快，省略了 " + std::to_string(frame.dropped) + " 条");
+    }
+    if (frame.lines.empty()) return false;
+
+    size_t after = shown + frame.lines.size();
+    frame.evict = after > historyLimit ? after - historyLimit : 0;
+    shown = after - frame.evict;
+    return true;
+}
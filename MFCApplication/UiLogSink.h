@@ -0,0 +1,46 @@
+﻿#pragma once
+#include "IObserver.h"
+#include "RingBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 一帧要显示的日志
+struct UiLogFrame {
+    std::vector<std::string> lines;  // 本帧新增的行，按时间顺序，最多 historyLimit 行
+    size_t evict = 0;                // 显示端先从头部删除这么多行，总行数就不超过 historyLimit
+    uint64_t dropped = 0;            // 自上一帧以来未显示的行数 (已在 lines 开头插入一行提示)
+};
+
+// 对应设计模式：Observer (观察者模式) - 具体观察者
+// 界面日志的批处理缓冲：OnLogUpdate 在任意线程上只把消息推入无锁环形队列，不阻塞、不发窗口消息；
+// 显示线程按固定帧率调用 PollFrame 一次取出一整批，再一次性更新控件。
+// 每帧最多处理 historyLimit 行，显示的总行数也不超过 historyLimit，
+// 所以无论任务写日志多快，界面每帧的开销都有上限。不依赖 MFC，可以在无界面环境下使用。
+class UiLogSink : public IObserver {
+public:
+    // historyLimit: 最多保留显示的行数；capacity: 两帧之间最多缓存的行数，写满时丢弃最旧的
+    explicit UiLogSink(size_t historyLimit = 1000, size_t capacity = 4096);
+
+    void OnLogUpdate(const std::string& message) override;
+
+    // 只能在显示线程上调用；没有新内容时返回 false
+    bool PollFrame(UiLogFrame& frame);
+    // 显示端清空了控件时调用
+    void ResetShown() { shown = 0; }
+    size_t Shown() const { return shown; }
+
+    size_t GetHistoryLimit() const { return historyLimit; }
+    // 累计未显示的行数 (队列写满 + 单帧超出上限)
+    uint64_t GetDroppedCount() const { return dropped.load() + skipped; }
+
+private:
+    RingBuffer<std::string> ring;
+    size_t historyLimit;
+    std::atomic<uint64_t> dropped;   // 队列写满时丢弃的条数
+    // 以下只在显示线程上访问
+    size_t shown;                    // 控件中当前的行数
+    uint64_t skipped;                // 单帧超出上限而跳过的条数
+    uint64_t reported;               // 已经提示过的未显示条数
+};
@@ -0,0 +1,23 @@
+﻿#pragma once
+#include <filesystem>
+#include <string>
+
+// UTF-8 的 std::string 与 std::filesystem::path 互转
+// C++20 起 u8string() 返回 std::u8string、u8path 被弃用；接口上的路径仍统一用 UTF-8 的 std::string
+inline std::filesystem::path PathFromUtf8(const std::string& s) {
+#ifdef __cpp_char8_t
+    return std::filesystem::path(std::u8string(s.begin(), s.end()));
+#else
+    return std::filesystem::u8path(s);
+#endif
+}
+
+inline std::string PathToUtf8(const std::filesystem::path& p) {
+    auto s = p.u8string();
+    return std::string(s.begin(), s.end());
+}
+
+inline std::string GenericPathToUtf8(const std::filesystem::path& p) {
+    auto s = p.generic_u8string();
+    return std::string(s.begin(), s.end());
+}
@@ -0,0 +1,159 @@
+﻿#pragma once
+#include "ScheduledTask.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// 就绪队列中最应执行的任务的排序值：先比优先级，再比截止时间 (或到期时间)
+struct ReadyRank {
+    size_t lane;
+    long long key;
+
+    static ReadyRank Empty() { return ReadyRank{ kPriorityClasses, LLONG_MAX }; }
+    bool IsEmpty() const { return lane == kPriorityClasses; }
+    bool operator<(const ReadyRank& other) const {
+        return lane != other.lane ? lane < other.lane : key < other.key;
+    }
+};
+
+// 每个工作线程独占一个就绪队列，空闲线程可以从其他线程的队列中"偷"任务
+// 锁只保护单个队列，争用只发生在同一队列的拥有者与窃取者之间，
+// 因此加锁时间不会随工作线程数量和提交速率增长
+//
+// 队列内按优先级分成若干条通道，每条通道按截止时间排序 (EDF)；
+// 没有截止时间的任务以到期时间排序，同一通道内不会饿死。
+// 定时线程按到期顺序投递，排序值通常单调递增，这类任务走 FIFO 快速路径，只有乱序到达的才进堆。
+// 通道之间严格按优先级，但低优先级的堆顶比当前最高通道多等待 (级差 × 老化步长)、
+// 且该通道一个步长内没有被服务过时，让它先执行一个：
+// 持续的高优先级负载下低优先级仍能前进，而高优先级每个步长最多被插队一次。
+class WorkStealingQueue {
+private:
+    struct Lane {
+        std::deque<ScheduledTask> fifo;     // 排序值单调不减的部分
+        std::vector<ScheduledTask> heap;    // 乱序到达的部分 (最小堆)
+
+        bool Empty() const { return fifo.empty() && heap.empty(); }
+        // 下一个应取出的任务在 fifo 还是 heap
+        bool FrontInFifo() const {
+            return heap.empty() || (!fifo.empty() && fifo.front().ReadyKey() <= heap.front().ReadyKey());
+        }
+        const ScheduledTask& Front() const { return FrontInFifo() ? fifo.front() : heap.front(); }
+    };
+    Lane lanes[kPriorityClasses];
+    // 以下为无锁读取的提示值，均在持有 mtx 时更新
+    std::atomic<long long> headKey[kPriorityClasses];    // 堆顶的截止时间 (或到期时间)，空通道为 LLONG_MAX
+    std::atomic<long long> headDue[kPriorityClasses];    // 堆顶的到期时间，用于判断等待了多久
+    std::atomic<long long> lastServed[kPriorityClasses]; // 该通道上一次被取出任务的时间
+    std::mutex mtx;
+
+    static long long Ns(SchedulerClock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    // 堆比较：截止时间 (或到期时间) 更晚的排在后面
+    static bool Later(const ScheduledTask& a, const ScheduledTask& b) {
+        return a.ReadyKey() > b.ReadyKey();
+    }
+
+    void PublishHead(size_t index) {
+        const Lane& lane = lanes[index];
+        bool empty = lane.Empty();
+        headKey[index].store(empty ? LLONG_MAX : Ns(lane.Front().ReadyKey()), std::memory_order_relaxed);
+        headDue[index].store(empty ? LLONG_MAX : Ns(lane.Front().executeTime), std::memory_order_relaxed);
+    }
+
+    void PushLocked(ScheduledTask task) {
+        size_t index = static_cast<size_t>(task.priority);
+        if (index >= kPriorityClasses) index = kPriorityClasses - 1;
+        Lane& lane = lanes[index];
+        if (lane.fifo.empty() || lane.fifo.back().ReadyKey() <= task.ReadyKey()) {
+            lane.fifo.push_back(std::move(task));
+        }
+        else {
+            lane.heap.push_back(std::move(task));
+            std::push_heap(lane.heap.begin(), lane.heap.end(), Later);
+        }
+        PublishHead(index);
+    }
+
+    // 选择通道；全部为空时返回 kPriorityClasses
+    size_t PickLane(long long nowNs, long long agingNs) const {
+        size_t top = 0;
+        while (top < kPriorityClasses && headKey[top].load(std::memory_order_relaxed) == LLONG_MAX) ++top;
+        if (top == kPriorityClasses) return top;
+        for (size_t lane = top + 1; lane < kPriorityClasses; ++lane) {
+            long long due = headDue[lane].load(std::memory_order_relaxed);
+            if (due == LLONG_MAX) continue;
+            long long step = agingNs * static_cast<long long>(lane - top);
+            if (nowNs - due >= step && nowNs - lastServed[lane].load(std::memory_order_relaxed) >= agingNs) {
+                return lane; // 等待过久：本步长内让它执行一个
+            }
+        }
+        return top;
+    }
+
+    bool PopLocked(long long nowNs, long long agingNs, ScheduledTask& out) {
+        size_t index = PickLane(nowNs, agingNs);
+        if (index == kPriorityClasses) return false;
+        Lane& lane = lanes[index];
+        if (lane.FrontInFifo()) {
+            out = std::move(lane.fifo.front());
+            lane.fifo.pop_front();
+        }
+        else {
+            std::pop_heap(lane.heap.begin(), lane.heap.end(), Later);
+            out = std::move(lane.heap.back());
+            lane.heap.pop_back();
+        }
+        PublishHead(index);
+        lastServed[index].store(nowNs, std::memory_order_relaxed);
+        return true;
+    }
+
+public:
+    WorkStealingQueue() {
+        for (size_t lane = 0; lane < kPriorityClasses; ++lane) {
+            headKey[lane].store(LLONG_MAX, std::memory_order_relaxed);
+            headDue[lane].store(LLONG_MAX, std::memory_order_relaxed);
+            lastServed[lane].store(LLONG_MIN / 2, std::memory_order_relaxed);
+        }
+    }
+
+    // 定时线程投递到期任务
+    void Push(ScheduledTask task) {
+        std::lock_guard<std::mutex> lock(mtx);
+        PushLocked(std::move(task));
+    }
+
+    // 批量投递：一次加锁
+    void PushBatch(std::vector<ScheduledTask>& batch) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& task : batch) {
+            PushLocked(std::move(task));
+        }
+        batch.clear();
+    }
+
+    // 拥有者取当前最应执行的任务；nowNs 只用于老化判断，可以是粗粒度时间
+    bool TryPop(ScheduledTask& out, long long nowNs, long long agingNs) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return PopLocked(nowNs, agingNs, out);
+    }
+
+    // 窃取者同样取最应执行的任务，队列正忙就换下一个目标
+    bool TrySteal(ScheduledTask& out, long long nowNs, long long agingNs) {
+        std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+        if (!lock.owns_lock()) return false;
+        return PopLocked(nowNs, agingNs, out);
+    }
+
+    // 不加锁估计本队列下一个会被取出的任务，工作线程据此在各队列之间挑选
+    ReadyRank Peek(long long nowNs, long long agingNs) const {
+        size_t lane = PickLane(nowNs, agingNs);
+        if (lane == kPriorityClasses) return ReadyRank::Empty();
+        return ReadyRank{ lane, headKey[lane].load(std::memory_order_relaxed) };
+    }
+};
@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+
+// 工作线程的心跳槽：每个工作线程独占一个缓存行，只有它自己写，看门狗只读
+// epoch 为奇数表示正在执行任务，偶数表示空闲；每次开始/结束各 +1。
+// 读者按 seqlock 方式读取：前后两次读到同一个奇数 epoch，字段才是同一次执行的。
+struct alignas(64) WorkerHeartbeat {
+    std::atomic<uint64_t> epoch;
+    std::atomic<uint64_t> taskId;
+    std::atomic<uint32_t> metricId;    // 任务类型编号 (TaskMetrics)，用于查名称和超时预算
+    std::atomic<uint32_t> nameId;      // 事件日志中的名称编号
+    std::atomic<long long> startNs;    // steady_clock 纳秒
+    std::atomic<long long> deadlineNs; // 超过该时间仍未结束即视为卡住
+
+    WorkerHeartbeat() : epoch(0), taskId(0), metricId(0), nameId(0), startNs(0), deadlineNs(0) {}
+
+    // 工作线程：开始执行一个任务
+    void Begin(uint64_t id, uint32_t metric, uint32_t name, long long start, long long deadline) {
+        // release 写：读者一旦读到新值，也必然能看到之前 End() 对 epoch 的修改，从而发现不一致
+        taskId.store(id, std::memory_order_release);
+        metricId.store(metric, std::memory_order_release);
+        nameId.store(name, std::memory_order_release);
+        startNs.store(start, std::memory_order_release);
+        deadlineNs.store(deadline, std::memory_order_release);
+        epoch.store(epoch.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+    }
+
+    // 工作线程：任务结束
+    void End() {
+        epoch.store(epoch.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    struct View {
+        uint64_t epoch;
+        uint64_t taskId;
+        uint32_t metricId;
+        uint32_t nameId;
+        long long startNs;
+        long long deadlineNs;
+    };
+
+    // 看门狗：读取一份一致的快照；空闲或恰好在切换任务时返回 false
+    bool Read(View& out) const {
+        // seq_cst：与 Begin() 中的 epoch 写入配对，看门狗先发布唤醒时间再读心跳时不会漏掉新任务
+        uint64_t before = epoch.load(std::memory_order_seq_cst);
+        if ((before & 1) == 0) return false;
+        // acquire 读保证最后一次读 epoch 不会被提前到读字段之前 (不用独立的内存栅栏，sanitizer 也能正确建模)
+        out.taskId = taskId.load(std::memory_order_acquire);
+        out.metricId = metricId.load(std::memory_order_acquire);
+        out.nameId = nameId.load(std::memory_order_acquire);
+        out.startNs = startNs.load(std::memory_order_acquire);
+        out.deadlineNs = deadlineNs.load(std::memory_order_acquire);
+        if (epoch.load(std::memory_order_relaxed) != before) return false;
+        out.epoch = before;
+        return true;
+    }
+};
@@ -0,0 +1,446 @@
+﻿#include "ZipWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+// ==========================================
+// CRC32
+// ==========================================
+
+namespace {
+
+const uint32_t kCrcPoly = 0xEDB88320u; // 反射形式
+
+// 按 8 字节一组查表 (slicing-by-8)，每字节约 1 个周期
+struct CrcTables {
+    uint32_t t[8][256];
+    uint32_t x2n[32]; // x^(2^n) mod P，用于合并
+
+    CrcTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ kCrcPoly : c >> 1;
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int s = 1; s < 8; ++s) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+        }
+        uint32_t p = 1u << 30; // x^1
+        x2n[0] = p;
+        for (int n = 1; n < 32; ++n) x2n[n] = p = MultModP(p, p);
+    }
+
+    // GF(2) 上 a(x) × b(x) mod P (与 zlib 的 multmodp 相同)
+    static uint32_t MultModP(uint32_t a, uint32_t b) {
+        uint32_t m = 1u << 31, p = 0;
+        for (;;) {
+            if (a & m) {
+                p ^= b;
+                if ((a & (m - 1)) == 0) break;
+            }
+            m >>= 1;
+            b = (b & 1) ? (b >> 1) ^ kCrcPoly : b >> 1;
+        }
+        return p;
+    }
+};
+
+const CrcTables& Tables() {
+    static const CrcTables tables;
+    return tables;
+}
+
+} // namespace
+
+uint32_t Crc32Update(uint32_t crc, const uint8_t* data, size_t n) {
+    const CrcTables& tb = Tables();
+    uint32_t c = ~crc;
+    while (n >= 8) {
+        uint32_t lo = c ^ (static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+                           static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24);
+        c = tb.t[7][lo & 0xFF] ^ tb.t[6][(lo >> 8) & 0xFF] ^ tb.t[5][(lo >> 16) & 0xFF] ^ tb.t[4][lo >> 24] ^
+            tb.t[3][data[4]] ^ tb.t[2][data[5]] ^ tb.t[1][data[6]] ^ tb.t[0][data[7]];
+        data += 8;
+        n -= 8;
+    }
+    while (n--) c = (c >> 8) ^ tb.t[0][(c ^ *data++) & 0xFF];
+    return ~c;
+}
+
+// crc(A+B) = crcA × x^(8·lenB) mod P ⊕ crcB
+uint32_t Crc32Combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB) {
+    const CrcTables& tb = Tables();
+    uint32_t p = 1u << 31; // x^0
+    unsigned k = 3;        // 长度以字节计，x^(8n) = x^(n·2^3)
+    for (uint64_t n = lengthB; n; n >>= 1, ++k) {
+        if (n & 1) p = CrcTables::MultModP(tb.x2n[k & 31], p);
+    }
+    return CrcTables::MultModP(p, crcA) ^ crcB;
+}
+
+// ==========================================
+// Deflate (固定 Huffman，块内 LZ77)
+// ==========================================
+
+namespace {
+
+const int kHashBits = 15;
+const size_t kWindow = 32768;
+const size_t kMinMatch = 3;
+const size_t kMaxMatch = 258;
+const int kMaxChain = 16;  // 哈希链最多比较的候选数：速度优先
+
+// 固定 Huffman 码 (已按位反转，可以直接低位在前写出) 与长度/距离码表
+struct DeflateTables {
+    uint16_t litCode[288];
+    uint8_t litBits[288];
+    uint8_t distCode[30];     // 5 位，已反转
+    uint16_t lengthSymbol[259]; // 匹配长度 -> 长度码序号 (符号 257 + 序号)
+    uint16_t lengthBase[29];
+    uint8_t lengthExtra[29];
+    uint16_t distBase[30];
+    uint8_t distExtra[30];
+
+    static uint16_t Reverse(uint16_t code, int bits) {
+        uint16_t r = 0;
+        for (int i = 0; i < bits; ++i) r = static_cast<uint16_t>((r << 1) | ((code >> i) & 1));
+        return r;
+    }
+
+    DeflateTables() {
+        for (int i = 0; i < 288; ++i) {
+            int bits, code;
+            if (i < 144) { bits = 8; code = 0x30 + i; }
+            else if (i < 256) { bits = 9; code = 0x190 + (i - 144); }
+            else if (i < 280) { bits = 7; code = i - 256; }
+            else { bits = 8; code = 0xC0 + (i - 280); }
+            litCode[i] = Reverse(static_cast<uint16_t>(code), bits);
+            litBits[i] = static_cast<uint8_t>(bits);
+        }
+        for (int i = 0; i < 30; ++i) distCode[i] = static_cast<uint8_t>(Reverse(static_cast<uint16_t>(i), 5));
+
+        const uint16_t lbase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83,
+            99, 115, 131, 163, 195, 227, 258 };
+        const uint8_t lextra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5,
+            5, 0 };
+        const uint16_t dbase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+            1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        const uint8_t dextra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+            12, 12, 13, 13 };
+        std::memcpy(lengthBase, lbase, sizeof(lbase));
+        std::memcpy(lengthExtra, lextra, sizeof(lextra));
+        std::memcpy(distBase, dbase, sizeof(dbase));
+        std::memcpy(distExtra, dextra, sizeof(dextra));
+        for (int code = 0; code < 29; ++code) {
+            // 227..257 用符号 284，258 单独使用符号 285
+            int end = code + 1 < 29 ? lengthBase[code + 1] : 259;
+            for (int len = lengthBase[code]; len < end; ++len) lengthSymbol[len] = static_cast<uint16_t>(code);
+        }
+    }
+
+    int DistanceSymbol(size_t dist) const {
+        // 距离码按区间对数增长，二分查找即可
+        int lo = 0, hi = 29;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (distBase[mid] <= dist) lo = mid;
+            else hi = mid - 1;
+        }
+        return lo;
+    }
+};
+
+const DeflateTables& Deflate() {
+    static const DeflateTables tables;
+    return tables;
+}
+
+// 低位在前的位写出器
+class BitWriter {
+private:
+    std::vector<uint8_t>& out;
+    uint64_t acc;
+    int count;
+
+public:
+    explicit BitWriter(std::vector<uint8_t>& o) : out(o), acc(0), count(0) {}
+
+    void Put(uint32_t value, int bits) {
+        acc |= static_cast<uint64_t>(value) << count;
+        count += bits;
+        while (count >= 8) {
+            out.push_back(static_cast<uint8_t>(acc));
+            acc >>= 8;
+            count -= 8;
+        }
+    }
+    void AlignToByte() {
+        if (count > 0) Put(0, 8 - count);
+    }
+};
+
+inline uint32_t Hash3(const uint8_t* p) {
+    uint32_t v = static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16;
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+void StoreBlocks(const uint8_t* data, size_t n, std::vector<uint8_t>& out) {
+    // 存储块：3 位块头 (非末尾、类型 00) 补齐到字节，再写 LEN / NLEN 和原始数据
+    for (size_t pos = 0; pos < n;) {
+        size_t len = (std::min)(n - pos, size_t(65535));
+        out.push_back(0x00);
+        out.push_back(static_cast<uint8_t>(len));
+        out.push_back(static_cast<uint8_t>(len >> 8));
+        out.push_back(static_cast<uint8_t>(~len));
+        out.push_back(static_cast<uint8_t>(~len >> 8));
+        out.insert(out.end(), data + pos, data + pos + len);
+        pos += len;
+    }
+}
+
+} // namespace
+
+void DeflateBlock(const uint8_t* data, size_t n, std::vector<uint8_t>& out) {
+    if (n == 0) return;
+    const DeflateTables& tb = Deflate();
+    size_t start = out.size();
+    out.reserve(start + n / 2 + 64);
+
+    // 每个线程一份哈希表，块之间不共享状态
+    static thread_local std::vector<int32_t> head(size_t(1) << kHashBits);
+    static thread_local std::vector<int32_t> prev(kWindow);
+    std::fill(head.begin(), head.end(), -1);
+
+    BitWriter bits(out);
+    bits.Put(0, 1); // BFINAL = 0
+    bits.Put(1, 2); // BTYPE = 01 (固定 Huffman)
+
+    auto literal = [&](uint8_t c) { bits.Put(tb.litCode[c], tb.litBits[c]); };
+    auto insert = [&](size_t pos) {
+        uint32_t h = Hash3(data + pos);
+        prev[pos & (kWindow - 1)] = head[h];
+        head[h] = static_cast<int32_t>(pos);
+    };
+
+    // 前 64 KB 压不下去就认为整块不可压缩，不再做完整的匹配搜索
+    const size_t probe = n > 2 * kWindow ? kWindow * 2 : n;
+    bool probed = probe == n;
+    size_t pos = 0;
+    while (pos < n) {
+        if (!probed && pos >= probe) {
+            probed = true;
+            if (out.size() - start >= probe) {
+                out.resize(start);
+                StoreBlocks(data, n, out);
+                return;
+            }
+        }
+        size_t bestLen = 0, bestDist = 0;
+        if (pos + kMinMatch <= n) {
+            size_t limit = (std::min)(kMaxMatch, n - pos);
+            int32_t candidate = head[Hash3(data + pos)];
+            for (int chain = 0; chain < kMaxChain && candidate >= 0; ++chain) {
+                size_t dist = pos - static_cast<size_t>(candidate);
+                if (dist > kWindow - 1 || dist == 0) break;
+                const uint8_t* a = data + candidate;
+                const uint8_t* b = data + pos;
+                if (a[bestLen] == b[bestLen]) {
+                    size_t len = 0;
+                    while (len < limit && a[len] == b[len]) ++len;
+                    if (len > bestLen) {
+                        bestLen = len;
+                        bestDist = dist;
+                        if (len == limit) break;
+                    }
+                }
+                candidate = prev[static_cast<size_t>(candidate) & (kWindow - 1)];
+            }
+            insert(pos);
+        }
+
+        if (bestLen >= kMinMatch) {
+            int ls = tb.lengthSymbol[bestLen];
+            bits.Put(tb.litCode[257 + ls], tb.litBits[257 + ls]);
+            if (tb.lengthExtra[ls]) bits.Put(static_cast<uint32_t>(bestLen - tb.lengthBase[ls]), tb.lengthExtra[ls]);
+            int ds = tb.DistanceSymbol(bestDist);
+            bits.Put(tb.distCode[ds], 5);
+            if (tb.distExtra[ds]) bits.Put(static_cast<uint32_t>(bestDist - tb.distBase[ds]), tb.distExtra[ds]);
+            // 匹配内部的位置也登记进哈希表 (长匹配只登记前一段，速度优先)
+            size_t end = pos + bestLen;
+            size_t insertEnd = (std::min)(end, n >= kMinMatch ? n - kMinMatch + 1 : 0);
+            for (size_t p = pos + 1; p < insertEnd && p < pos + 32; ++p) insert(p);
+            pos = end;
+        }
+        else {
+            literal(data[pos]);
+            ++pos;
+        }
+    }
+    bits.Put(tb.litCode[256], tb.litBits[256]); // 块结束
+
+    // 空的存储块：对齐到字节，之后的块 (可能来自其他线程) 可以直接拼接
+    bits.Put(0, 3);
+    bits.AlignToByte();
+    out.push_back(0x00);
+    out.push_back(0x00);
+    out.push_back(0xFF);
+    out.push_back(0xFF);
+
+    // 不可压缩的数据 (已压缩的文件、随机数据) 改为存储块
+    if (out.size() - start > n + n / 64 + 16) {
+        out.resize(start);
+        StoreBlocks(data, n, out);
+    }
+}
+
+// ==========================================
+// ZipWriter
+// ==========================================
+
+namespace {
+const uint32_t kLocalHeader = 0x04034b50u;
+const uint32_t kDataDescriptor = 0x08074b50u;
+const uint32_t kCentralHeader = 0x02014b50u;
+const uint32_t kEndOfCentral = 0x06054b50u;
+const uint16_t kVersion = 20;          // 2.0：deflate
+const uint16_t kFlags = 0x0008 | 0x0800; // 数据描述符 + UTF-8 文件名
+const uint16_t kMethodDeflate = 8;
+const uint64_t kMax32 = 0xFFFFFFFFull;
+}
+
+ZipWriter::ZipWriter() : buffer(size_t(1) << 20), offset(0), inEntry(false) {}
+
+bool ZipWriter::Fail(const std::string& message) {
+    if (error.empty()) error = message;
+    return false;
+}
+
+void ZipWriter::Put16(uint16_t v) {
+    uint8_t b[2] = { static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8) };
+    PutBytes(b, 2);
+}
+
+void ZipWriter::Put32(uint32_t v) {
+    uint8_t b[4] = { static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16),
+        static_cast<uint8_t>(v >> 24) };
+    PutBytes(b, 4);
+}
+
+void ZipWriter::PutBytes(const void* data, size_t n) {
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+    offset += n;
+}
+
+bool ZipWriter::Open(const std::string& path) {
+    out.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size())); // 必须在打开之前设置
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) return Fail("cannot create " + path);
+    return true;
+}
+
+bool ZipWriter::BeginEntry(const std::string& name, long long modified) {
+    if (inEntry) return Fail("BeginEntry called twice");
+    if (entries.size() >= 0xFFFF) return Fail("too many entries for a non-Zip64 archive");
+    if (offset > kMax32) return Fail("archive exceeds 4 GiB (Zip64 not supported)");
+
+    // MS-DOS 时间：2 秒精度，1980 年起
+    std::time_t t = static_cast<std::time_t>(modified);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &t);
+#else
+    localtime_r(&t, &local);
+#endif
+    Entry entry;
+    entry.name = name;
+    if (local.tm_year < 80) {
+        entry.dosTime = 0;
+        entry.dosDate = (1 << 5) | 1; // 1980-01-01
+    }
+    else {
+        entry.dosTime = static_cast<uint16_t>(local.tm_hour << 11 | local.tm_min << 5 | local.tm_sec / 2);
+        entry.dosDate = static_cast<uint16_t>((local.tm_year - 80) << 9 | (local.tm_mon + 1) << 5 | local.tm_mday);
+    }
+    entry.crc = 0;
+    entry.compressedSize = 0;
+    entry.size = 0;
+    entry.offset = offset;
+
+    Put32(kLocalHeader);
+    Put16(kVersion);
+    Put16(kFlags);
+    Put16(kMethodDeflate);
+    Put16(entry.dosTime);
+    Put16(entry.dosDate);
+    Put32(0); // CRC 与大小写在数据描述符中
+    Put32(0);
+    Put32(0);
+    Put16(static_cast<uint16_t>(name.size()));
+    Put16(0);
+    PutBytes(name.data(), name.size());
+
+    entries.push_back(entry);
+    inEntry = true;
+    return static_cast<bool>(out) || Fail("write failed");
+}
+
+bool ZipWriter::WriteData(const uint8_t* data, size_t n) {
+    if (!inEntry) return Fail("WriteData outside an entry");
+    PutBytes(data, n);
+    entries.back().compressedSize += n;
+    return static_cast<bool>(out) || Fail("write failed");
+}
+
+bool ZipWriter::EndEntry(uint32_t crc, uint64_t size) {
+    if (!inEntry) return Fail("EndEntry without BeginEntry");
+    WriteData(kDeflateEnd, sizeof(kDeflateEnd));
+    Entry& entry = entries.back();
+    if (size > kMax32 || entry.compressedSize > kMax32) return Fail(entry.name + " exceeds 4 GiB (Zip64 not supported)");
+    entry.crc = crc;
+    entry.size = size;
+    Put32(kDataDescriptor);
+    Put32(crc);
+    Put32(static_cast<uint32_t>(entry.compressedSize));
+    Put32(static_cast<uint32_t>(size));
+    inEntry = false;
+    return static_cast<bool>(out) || Fail("write failed");
+}
+
+bool ZipWriter::Close() {
+    if (!out.is_open()) return error.empty() ? Fail("archive not open") : false;
+    if (inEntry) return Fail("Close inside an entry");
+    uint64_t centralStart = offset;
+    if (centralStart > kMax32) return Fail("archive exceeds 4 GiB (Zip64 not supported)");
+    for (const Entry& entry : entries) {
+        Put32(kCentralHeader);
+        Put16(kVersion); // 创建者版本
+        Put16(kVersion); // 解压所需版本
+        Put16(kFlags);
+        Put16(kMethodDeflate);
+        Put16(entry.dosTime);
+        Put16(entry.dosDate);
+        Put32(entry.crc);
+        Put32(static_cast<uint32_t>(entry.compressedSize));
+        Put32(static_cast<uint32_t>(entry.size));
+        Put16(static_cast<uint16_t>(entry.name.size()));
+        Put16(0); // 扩展字段
+        Put16(0); // 注释
+        Put16(0); // 磁盘号
+        Put16(0); // 内部属性
+        Put32(0); // 外部属性
+        Put32(static_cast<uint32_t>(entry.offset));
+        PutBytes(entry.name.data(), entry.name.size());
+    }
+    uint64_t centralSize = offset - centralStart;
+    Put32(kEndOfCentral);
+    Put16(0);
+    Put16(0);
+    Put16(static_cast<uint16_t>(entries.size()));
+    Put16(static_cast<uint16_t>(entries.size()));
+    Put32(static_cast<uint32_t>(centralSize));
+    Put32(static_cast<uint32_t>(centralStart));
+    Put16(0);
+    out.close();
+    return !out.fail() || Fail("write failed");
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// 标准 zip (deflate) 的流式写出，不依赖 zlib
+//
+// 压缩按块独立进行 (与 pigz 相同的做法)：每块用自己的 LZ77 窗口和固定 Huffman 表编码，
+// 以空的存储块收尾对齐到字节，因此各块可以在不同线程上同时压缩，按顺序拼接就是一个合法的 deflate 流。
+// CRC32 也按块计算，再用 Crc32Combine 合并。
+
+// CRC32 (zip / gzip 使用的多项式)，crc 传入上一段的结果，初始为 0
+uint32_t Crc32Update(uint32_t crc, const uint8_t* data, size_t n);
+// 已知 A 段的 crcA 和 B 段的 crcB、B 段长度 lengthB，求 A+B 的 CRC
+uint32_t Crc32Combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB);
+
+// 把一块数据压缩为一个或多个非末尾的 deflate 块 (追加到 out，结束时按字节对齐)
+// 压缩后反而变大时改为存储块
+void DeflateBlock(const uint8_t* data, size_t n, std::vector<uint8_t>& out);
+// deflate 流的结束标记 (一个空的末尾块)
+const uint8_t kDeflateEnd[2] = { 0x03, 0x00 };
+
+// 对应设计模式：Builder (建造者)
+// 逐个条目写出：BeginEntry -> WriteData (可多次) -> EndEntry，最后 Close 写中央目录
+// 条目头在数据之前写出，大小和 CRC 放在数据之后的描述符里，因此不需要预先知道压缩结果
+// 不支持 Zip64：单个文件或整个归档超过 4 GiB、或超过 65535 个条目时返回 false
+class ZipWriter {
+private:
+    struct Entry {
+        std::string name;
+        uint16_t dosTime;
+        uint16_t dosDate;
+        uint32_t crc;
+        uint64_t compressedSize;
+        uint64_t size;
+        uint64_t offset;
+    };
+
+    std::ofstream out;
+    std::vector<char> buffer;
+    std::vector<Entry> entries;
+    uint64_t offset;
+    bool inEntry;
+    std::string error;
+
+    void Put16(uint16_t v);
+    void Put32(uint32_t v);
+    void PutBytes(const void* data, size_t n);
+    bool Fail(const std::string& message);
+
+public:
+    ZipWriter();
+
+    bool Open(const std::string& path);
+    // modified: 条目的修改时间 (time_t)
+    bool BeginEntry(const std::string& name, long long modified);
+    bool WriteData(const uint8_t* data, size_t n);
+    // 写出 deflate 结束标记和数据描述符
+    bool EndEntry(uint32_t crc, uint64_t size);
+    bool Close();
+
+    uint64_t BytesWritten() const { return offset; }
+    const std::string& Error() const { return error; }
+};
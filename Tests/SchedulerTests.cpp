@@ -0,0 +1,334 @@
+﻿// SchedulerTests.cpp: 调度器核心的无界面回归测试 (不依赖 MFC 与第三方测试框架)
+//
+//   cmake --build build --target SchedulerTests && ctest --test-dir build
+//   SchedulerTests [用例名]    不带参数时运行全部用例
+//
+// 每个用例由 CTest 单独启动一个进程，互不影响调度器单例的状态
+
+#include "StreamingStats.h"
+#include "TaskGraph.h"
+#include "TaskScheduler.h"
+#include "UiLogSink.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                             \
+        }                                                                           \
+    } while (0)
+
+// 计数任务：每执行一次加一，可选择抛出异常
+class CountingTask : public ITask {
+public:
+    explicit CountingTask(std::atomic<int>& counter, bool fail = false) : counter(counter), fail(fail) {}
+    void Execute() override {
+        counter.fetch_add(1);
+        if (fail) throw std::runtime_error("expected failure");
+    }
+    std::string GetName() const override { return "CountingTask"; }
+
+private:
+    std::atomic<int>& counter;
+    bool fail;
+};
+
+// 闸门任务：执行后一直等到 open 被置位
+class GateTask : public ITask {
+public:
+    GateTask(std::atomic<bool>& entered, std::atomic<bool>& open) : entered(entered), open(open) {}
+    void Execute() override {
+        entered = true;
+        while (!open) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::string GetName() const override { return "GateTask"; }
+
+private:
+    std::atomic<bool>& entered;
+    std::atomic<bool>& open;
+};
+
+// 轮询直到条件成立或超时
+bool WaitUntil(const std::function<bool()>& condition, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+std::string Line(int i) {
+    std::string line = "L";
+    line += std::to_string(i);
+    return line;
+}
+
+// ------------------------------------------
+// UiLogSink
+// ------------------------------------------
+
+void UiLogSinkEmptyFrame() {
+    UiLogSink sink(1000, 4096);
+    UiLogFrame frame;
+    CHECK(!sink.PollFrame(frame));
+    CHECK(frame.lines.empty());
+    CHECK(sink.Shown() == 0);
+}
+
+// 一帧最多 historyLimit 行 (含提示行)，保留的是最新的行且顺序不变
+void UiLogSinkFrameCap() {
+    UiLogSink sink(1000, 4096);
+    for (int i = 0; i < 3000; ++i) sink.OnLogUpdate(Line(i));
+
+    UiLogFrame frame;
+    CHECK(sink.PollFrame(frame));
+    CHECK(frame.lines.size() == 1000);
+    CHECK(frame.dropped == 2001);
+    CHECK(frame.evict == 0);
+    CHECK(frame.lines.front().find("2001") != std::string::npos); // 提示行在最前
+    CHECK(frame.lines[1] == Line(2001));
+    CHECK(frame.lines.back() == Line(2999));
+    for (size_t i = 2; i < frame.lines.size(); ++i) {
+        CHECK(frame.lines[i] == Line(static_cast<int>(2000 + i)));
+    }
+    CHECK(sink.Shown() == 1000);
+    CHECK(sink.GetDroppedCount() == 2001);
+
+    // 下一帧不再重复提示；显示总行数保持在 1000，旧行按新增数量淘汰
+    for (int i = 0; i < 10; ++i) sink.OnLogUpdate(Line(5000 + i));
+    CHECK(sink.PollFrame(frame));
+    CHECK(frame.lines.size() == 10);
+    CHECK(frame.dropped == 0);
+    CHECK(frame.evict == 10);
+    CHECK(frame.lines.front() == Line(5000));
+    CHECK(sink.Shown() == 1000);
+}
+
+// 队列写满时丢弃最旧的，剩下的仍按写入顺序取出
+void UiLogSinkDrainOrder() {
+    UiLogSink sink(1000, 16);
+    const int total = 100;
+    for (int i = 0; i < total; ++i) sink.OnLogUpdate(Line(i));
+
+    UiLogFrame frame;
+    CHECK(sink.PollFrame(frame));
+    CHECK(frame.dropped > 0);
+    CHECK(frame.lines.size() >= 2);
+    CHECK(frame.dropped + (frame.lines.size() - 1) == static_cast<size_t>(total));
+    CHECK(frame.lines.back() == Line(total - 1));
+    for (size_t i = 2; i < frame.lines.size(); ++i) {
+        CHECK(std::stoi(frame.lines[i].substr(1)) == std::stoi(frame.lines[i - 1].substr(1)) + 1);
+    }
+
+    // 清空控件后重新计数
+    sink.ResetShown();
+    sink.OnLogUpdate("again");
+    CHECK(sink.PollFrame(frame));
+    CHECK(frame.lines.size() == 1 && frame.evict == 0);
+    CHECK(sink.Shown() == 1);
+}
+
+// ------------------------------------------
+// StreamingStats
+// ------------------------------------------
+
+// 草图与自身合并：计数翻倍，分布不变；NaN 被忽略
+void KllSelfMerge() {
+    KllSketch sketch(200);
+    for (int i = 0; i < 10000; ++i) sketch.Add(static_cast<double>(i));
+    sketch.Add(std::nan(""));
+    CHECK(sketch.Count() == 10000);
+
+    double before = sketch.Quantile(0.5);
+    sketch.Merge(sketch);
+    CHECK(sketch.Count() == 20000);
+    CHECK(std::fabs(sketch.Quantile(0.5) - before) < 10000 * 0.02);
+    CHECK(sketch.Quantile(0.0) == 0.0);
+    CHECK(sketch.Quantile(1.0) == 9999.0);
+}
+
+// ------------------------------------------
+// 调度器
+// ------------------------------------------
+
+// 取消的任务不会执行，也不能再重新调度
+void CancelPreventsRun() {
+    TaskScheduler& scheduler = *TaskScheduler::GetInstance();
+    std::atomic<int> ran{ 0 };
+
+    TaskHandle handle = scheduler.AddTask(std::make_shared<CountingTask>(ran), 200);
+    CHECK(handle.Cancel());
+    CHECK(!handle.Cancel());
+    CHECK(handle.IsCancelled());
+    CHECK(!handle.Reschedule(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    CHECK(ran.load() == 0);
+}
+
+// 已经执行完的一次性任务不能再取消，也不会被记为已取消
+void CancelFinishedFails() {
+    TaskScheduler& scheduler = *TaskScheduler::GetInstance();
+    std::atomic<int> ran{ 0 };
+
+    TaskHandle handle = scheduler.AddTask(std::make_shared<CountingTask>(ran), 0);
+    CHECK(WaitUntil([&] { return handle.IsFinished(); }));
+    CHECK(!handle.Cancel());
+    CHECK(!handle.IsCancelled());
+    CHECK(ran.load() == 1);
+}
+
+// 重新调度替换原计划；已经执行完的一次性任务不能被复活
+void RescheduleReplacesPlan() {
+    TaskScheduler& scheduler = *TaskScheduler::GetInstance();
+    std::atomic<int> ran{ 0 };
+
+    TaskHandle pending = scheduler.AddTask(std::make_shared<CountingTask>(ran), 60000);
+    CHECK(pending.Reschedule(0));
+    CHECK(WaitUntil([&] { return ran.load() == 1; }));
+    CHECK(WaitUntil([&] { return pending.IsFinished(); }));
+    CHECK(!pending.Reschedule(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(ran.load() == 1); // 旧计划已作废，不会再执行一次
+}
+
+// 返回的句柄与 specs 一一对应，空任务的位置是无效句柄
+void AddTasksHandlesMatchSpecs() {
+    TaskScheduler& scheduler = *TaskScheduler::GetInstance();
+    std::atomic<int> ran{ 0 };
+
+    std::vector<TaskSpec> specs(3);
+    specs[0].task = std::make_shared<CountingTask>(ran);
+    specs[2].task = std::make_shared<CountingTask>(ran);
+    specs[2].delayMs = 5;
+    std::vector<TaskHandle> handles = scheduler.AddTasks(specs);
+
+    CHECK(handles.size() == specs.size());
+    if (handles.size() != specs.size()) return;
+    CHECK(handles[0].IsValid());
+    CHECK(!handles[1].IsValid());
+    CHECK(handles[2].IsValid());
+    CHECK(handles[0].GetId() != handles[2].GetId());
+    CHECK(WaitUntil([&] { return ran.load() == 2; }));
+    CHECK(WaitUntil([&] { return handles[0].IsFinished() && handles[2].IsFinished(); }));
+}
+
+// 失败的前驱使 OnSuccess 后继及其下游被跳过，OnCompletion 后继照常执行
+void TaskGraphSkipPropagation() {
+    TaskScheduler& scheduler = *TaskScheduler::GetInstance();
+    std::atomic<int> ran{ 0 };
+    std::atomic<int> failedRuns{ 0 };
+
+    TaskGraph graph;
+    auto root = graph.AddNode(std::make_shared<CountingTask>(failedRuns, true));
+    auto child = graph.AddNode(std::make_shared<CountingTask>(ran));
+    auto grandchild = graph.AddNode(std::make_shared<CountingTask>(ran));
+    auto cleanup = graph.AddNode(std::make_shared<CountingTask>(ran));
+    CHECK(graph.Precede(root, child));
+    CHECK(graph.Precede(child, grandchild));
+    CHECK(graph.Precede(root, cleanup, DependencyKind::OnCompletion));
+    CHECK(!graph.Precede(root, root));
+
+    auto execution = graph.Submit(scheduler);
+    CHECK(execution != nullptr);
+    if (!execution) return;
+    CHECK(execution->WaitFor(std::chrono::seconds(5)));
+    CHECK(execution->GetState(root) == NodeState::Failed);
+    CHECK(execution->GetState(child) == NodeState::Skipped);
+    CHECK(execution->GetState(grandchild) == NodeState::Skipped);
+    CHECK(execution->GetState(cleanup) == NodeState::Succeeded);
+    CHECK(execution->FailedCount() == 1);
+    CHECK(execution->SkippedCount() == 2);
+    CHECK(execution->SucceededCount() == 1);
+    CHECK(failedRuns.load() == 1);
+    CHECK(ran.load() == 1);
+}
+
+// 取消图：正在执行的节点照常完成，其余节点记为跳过，Wait() 能返回
+void TaskGraphCancelSkipsPending() {
+    TaskScheduler& scheduler = *TaskScheduler::GetInstance();
+    std::atomic<bool> entered{ false };
+    std::atomic<bool> open{ false };
+    std::atomic<int> ran{ 0 };
+
+    TaskGraph graph;
+    auto root = graph.AddNode(std::make_shared<GateTask>(entered, open));
+    auto child = graph.AddNode(std::make_shared<CountingTask>(ran));
+    auto cleanup = graph.AddNode(std::make_shared<CountingTask>(ran));
+    CHECK(graph.Precede(root, child));
+    CHECK(graph.Precede(child, cleanup, DependencyKind::OnCompletion));
+
+    auto execution = graph.Submit(scheduler);
+    CHECK(execution != nullptr);
+    if (!execution) return;
+    CHECK(WaitUntil([&] { return entered.load(); }));
+    execution->Cancel();
+    open = true;
+    CHECK(execution->WaitFor(std::chrono::seconds(5)));
+    CHECK(execution->IsCancelled());
+    CHECK(execution->GetState(root) == NodeState::Succeeded);
+    CHECK(execution->GetState(child) == NodeState::Skipped);
+    CHECK(execution->GetState(cleanup) == NodeState::Skipped);
+    CHECK(execution->SkippedCount() == 2);
+    CHECK(ran.load() == 0);
+}
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+    bool needsScheduler;
+};
+
+const TestCase kTests[] = {
+    { "UiLogSinkEmptyFrame", UiLogSinkEmptyFrame, false },
+    { "UiLogSinkFrameCap", UiLogSinkFrameCap, false },
+    { "UiLogSinkDrainOrder", UiLogSinkDrainOrder, false },
+    { "KllSelfMerge", KllSelfMerge, false },
+    { "CancelPreventsRun", CancelPreventsRun, true },
+    { "CancelFinishedFails", CancelFinishedFails, true },
+    { "RescheduleReplacesPlan", RescheduleReplacesPlan, true },
+    { "AddTasksHandlesMatchSpecs", AddTasksHandlesMatchSpecs, true },
+    { "TaskGraphSkipPropagation", TaskGraphSkipPropagation, true },
+    { "TaskGraphCancelSkipsPending", TaskGraphCancelSkipsPending, true },
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    bool started = false;
+    int run = 0;
+    for (const TestCase& test : kTests) {
+        if (only && std::strcmp(only, test.name) != 0) continue;
+        if (test.needsScheduler && !started) {
+            TaskScheduler::GetInstance()->Start();
+            started = true;
+        }
+        int before = failures;
+        test.run();
+        std::printf("[%s] %s\n", failures == before ? "  OK  " : " FAIL ", test.name);
+        ++run;
+    }
+    if (started) TaskScheduler::GetInstance()->Stop();
+    if (run == 0) {
+        std::fprintf(stderr, "unknown test: %s\n", only);
+        return 2;
+    }
+    return failures == 0 ? 0 : 1;
+}